@@ -0,0 +1,129 @@
+// MIT License
+//
+// Copyright (c) 2017-2018 Artur Wyszyński, aljen at hitomi dot pl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+#include <spaghetti/package.h>
+#include <spaghetti/registry.h>
+
+namespace {
+
+// Peak resident set size in KiB, ru_maxrss never decreases so sizes have to
+// be measured in increasing order.
+long peak_rss_kib()
+{
+#if defined(__APPLE__)
+  rusage usage{};
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss / 1024;
+#elif defined(__unix__)
+  rusage usage{};
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss;
+#else
+  return -1;
+#endif
+}
+
+void write_element_header(std::ofstream &a_file, size_t const a_id, char const *const a_type)
+{
+  a_file << R"({"element":{"id":)" << a_id << R"(,"name":"e)" << a_id << R"(","type":")" << a_type
+         << R"(","min_inputs":2,"max_inputs":8,"min_outputs":1,"max_outputs":1,)"
+         << R"("default_new_input_flags":0,"default_new_output_flags":0,"io":{)";
+}
+
+// Chain of AND gates, each feeding the next one, written directly so the
+// generator itself doesn't show up in the peak.
+void write_package(std::string const &a_filename, size_t const a_elements)
+{
+  std::ofstream file{ a_filename };
+
+  write_element_header(file, 0, "logic/package");
+  file << R"("inputs":[],"outputs":[]}},)";
+  file << R"("node":{"position":{"x":0,"y":0},"iconify":false,)"
+       << R"("inputs_position":{"x":0,"y":0},"outputs_position":{"x":0,"y":0}},)";
+  file << R"("package":{"description":"","path":"","icon":"","elements":[)";
+
+  for (size_t i = 1; i <= a_elements; ++i) {
+    if (i > 1) file << ',';
+    write_element_header(file, i, "gates/and");
+    file << R"("inputs":[{"socket":0,"type":"bool","name":"#1","flags":0},)"
+         << R"({"socket":1,"type":"bool","name":"#2","flags":0}],)"
+         << R"("outputs":[{"socket":0,"type":"bool","name":"State","flags":0}]}},)";
+    file << R"("node":{"position":{"x":)" << (i % 1000) * 100 << R"(,"y":)" << (i / 1000) * 100
+         << R"(},"iconify":false}})";
+  }
+
+  file << R"(],"connections":[)";
+  for (size_t i = 1; i < a_elements; ++i) {
+    if (i > 1) file << ',';
+    file << R"({"connect":{"id":)" << i << R"(,"socket":0},"to":{"id":)" << i + 1 << R"(,"socket":0}})";
+  }
+  file << "]}}";
+}
+
+void print_usage(size_t const a_elements, spaghetti::Package::MemoryUsage const &a_usage)
+{
+  auto const kib = [](size_t const a_bytes) { return static_cast<double>(a_bytes) / 1024.0; };
+
+  std::printf("%zu elements\n", a_elements);
+  std::printf("  arena        %12.1f KiB\n", kib(a_usage.arenaBytes));
+  std::printf("  sockets      %12.1f KiB\n", kib(a_usage.socketBytes));
+  std::printf("  editor       %12.1f KiB\n", kib(a_usage.editorBytes));
+  std::printf("  values       %12.1f KiB\n", kib(a_usage.valueBytes));
+  std::printf("  connections  %12.1f KiB\n", kib(a_usage.connectionBytes));
+  std::printf("  dependencies %12.1f KiB\n", kib(a_usage.dependencyBytes));
+  std::printf("  names        %12.1f KiB\n", kib(a_usage.nameBytes));
+  std::printf("  total        %12.1f KiB (%.1f B/element)\n", kib(a_usage.total()),
+              static_cast<double>(a_usage.total()) / static_cast<double>(a_elements));
+  std::printf("  load json    %12.1f KiB\n", kib(a_usage.lastLoadJsonBytes));
+  std::printf("  peak rss     %12ld KiB\n", peak_rss_kib());
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+  std::string const DIRECTORY{ argc > 1 ? argv[1] : "." };
+
+  spaghetti::Registry &registry{ spaghetti::Registry::get() };
+  registry.registerInternalElements();
+
+  for (size_t const ELEMENTS : { size_t{ 10'000 }, size_t{ 100'000 }, size_t{ 1'000'000 } }) {
+    std::string const FILENAME{ DIRECTORY + "/memory_" + std::to_string(ELEMENTS) + ".package" };
+    write_package(FILENAME, ELEMENTS);
+
+    spaghetti::Package package{};
+    package.open(FILENAME);
+    print_usage(ELEMENTS, package.memoryUsage());
+
+    std::remove(FILENAME.c_str());
+  }
+
+  return 0;
+}
@@ -0,0 +1,96 @@
+// MIT License
+//
+// Copyright (c) 2017-2018 Artur Wyszyński, aljen at hitomi dot pl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+#ifndef SPAGHETTI_DEPENDENCY_GRAPH_H
+#define SPAGHETTI_DEPENDENCY_GRAPH_H
+
+// clang-format off
+#ifdef _MSC_VER
+# pragma warning(disable:4251)
+#endif
+// clang-format on
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include <spaghetti/api.h>
+
+namespace spaghetti {
+
+// Fan-out of every element stored as compressed sparse rows, targets of one
+// source are contiguous. New edges go to a small overlay and removed ones are
+// tombstoned in place, both are folded into fresh rows once they outgrow
+// MERGE_THRESHOLD (or an eighth of the graph) so traversal stays a linear scan. Holds one edge per
+// connection, parallel connections show up repeatedly.
+class SPAGHETTI_API DependencyGraph final {
+ public:
+  using Id = uint32_t;
+  using Edge = std::pair<Id, Id>;
+
+  static constexpr size_t const MERGE_THRESHOLD{ 64 };
+  static constexpr Id const TOMBSTONE{ std::numeric_limits<Id>::max() };
+
+  void add(size_t const a_from, size_t const a_to);
+  void remove(size_t const a_from, size_t const a_to);
+  void clear();
+  void merge();
+
+  template<typename Callback>
+  void forEachTarget(size_t const a_from, Callback &&a_callback) const
+  {
+    Id const FROM{ static_cast<Id>(a_from) };
+
+    if (FROM + size_t{ 1 } < m_offsets.size()) {
+      for (Id i = m_offsets[FROM]; i < m_offsets[FROM + 1]; ++i)
+        if (m_targets[i] != TOMBSTONE) a_callback(static_cast<size_t>(m_targets[i]));
+    }
+
+    for (auto const &EDGE : m_added)
+      if (EDGE.first == FROM) a_callback(static_cast<size_t>(EDGE.second));
+  }
+
+  std::vector<size_t> targets(size_t const a_from) const;
+
+  size_t edges() const { return m_targets.size() - m_tombstones + m_added.size(); }
+  size_t overlay() const { return m_added.size() + m_tombstones; }
+  size_t memoryUsage() const
+  {
+    return (m_offsets.capacity() + m_targets.capacity()) * sizeof(Id) + m_added.capacity() * sizeof(Edge);
+  }
+
+ private:
+  void mergeIfNeeded();
+
+ private:
+  std::vector<Id> m_offsets{};
+  std::vector<Id> m_targets{};
+  std::vector<Edge> m_added{};
+  size_t m_tombstones{};
+};
+
+} // namespace spaghetti
+
+#endif // SPAGHETTI_DEPENDENCY_GRAPH_H
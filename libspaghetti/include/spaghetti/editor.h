@@ -78,6 +78,7 @@ class SPAGHETTI_API Editor final : public QMainWindow {
 
   void showLibrary(bool a_checked);
   void showProperties(bool a_checked);
+  void showMemoryUsage();
 
   void buildCommit();
   void recentChanges();
@@ -31,8 +31,10 @@
 #endif
 // clang-format on
 
+#include <cassert>
 #include <chrono>
 #include <functional>
+#include <memory>
 #include <set>
 #include <string>
 #include <thread>
@@ -42,7 +44,9 @@
 #include <spaghetti/vendor/json.hpp>
 
 #include <spaghetti/api.h>
+#include <spaghetti/small_vector.h>
 #include <spaghetti/strings.h>
+#include <spaghetti/value_store.h>
 
 namespace spaghetti {
 
@@ -54,7 +58,7 @@ class SPAGHETTI_API Element {
 
   using Json = nlohmann::json;
   using Value = std::variant<bool, int32_t, float>;
-  enum class ValueType { eBool, eInt, eFloat };
+  using ValueType = spaghetti::ValueType;
   struct Vec2 {
     double x{}, y{};
   };
@@ -68,47 +72,62 @@ class SPAGHETTI_API Element {
       eCanHoldAllValues = eCanHoldBool | eCanHoldInt | eCanHoldFloat,
       eDefaultFlags = eCanHoldAllValues | eCanChangeName
     };
-    Value value{};
+    ValueStore::Index index{};
     ValueType type{};
 
     size_t id{};
     uint8_t slot{};
     uint8_t flags{};
-    std::string name{};
+    // Connected input reading its source's slot directly, the index isn't owned.
+    bool linked{};
+    string::handle_t name{};
   };
 
-  using IOSockets = std::vector<IOSocket>;
+  // Cover the common element, up to 4 inputs and 8 outputs, wider and
+  // variable-arity ones spill to the heap.
+  static constexpr size_t const INLINE_INPUTS{ 4 };
+  static constexpr size_t const INLINE_OUTPUTS{ 8 };
+  using IOSockets = SmallVectorBase<IOSocket>;
 
   Element() = default;
-  virtual ~Element() = default;
+  virtual ~Element();
 
   virtual char const *type() const noexcept = 0;
   virtual string::hash_t hash() const noexcept = 0;
 
   virtual void serialize(Json &a_json);
   virtual void deserialize(Json const &a_json);
+  // Takes what serialize() writes under "properties" and leaves the sockets
+  // alone. Elements calling propertiesChanged() override it.
+  virtual void setProperties(Json const &a_properties) { (void)a_properties; }
 
   virtual void calculate() {}
   virtual void reset() {}
 
   virtual void update(duration_t const &a_delta) { (void)a_delta; }
 
+  // What update() and calculate() carry between ticks besides socket values, as
+  // one trivially copyable block checkpoints copy byte for byte.
+  struct RuntimeState {
+    void *data{};
+    size_t size{};
+  };
+  virtual RuntimeState runtimeState() { return {}; }
+
   size_t id() const noexcept { return m_id; }
 
   void setName(std::string const a_name);
 
-  std::string name() const noexcept { return m_name; }
+  // A copy, the interned string goes away once setName() drops its last holder.
+  std::string name() const { return string::lookup(m_editor->name); }
+  string::handle_t nameHandle() const noexcept { return m_editor->name; }
 
-  void setPosition(double const a_x, double const a_y)
-  {
-    m_position.x = a_x;
-    m_position.y = a_y;
-  }
-  void setPosition(Vec2 const a_position) { m_position = a_position; }
-  Vec2 const &position() const { return m_position; }
+  void setPosition(double const a_x, double const a_y);
+  void setPosition(Vec2 const a_position) { setPosition(a_position.x, a_position.y); }
+  Vec2 const &position() const { return m_editor->position; }
 
-  void iconify(bool const a_iconify) { m_isIconified = a_iconify; }
-  bool isIconified() const { return m_isIconified; }
+  void iconify(bool const a_iconify);
+  bool isIconified() const { return m_editor->isIconified; }
 
   IOSockets &inputs() { return m_inputs; }
   IOSockets const &inputs() const { return m_inputs; }
@@ -129,27 +148,43 @@ class SPAGHETTI_API Element {
 
   bool connect(size_t const a_sourceId, uint8_t const a_outputId, uint8_t const a_inputId);
 
-  uint8_t minInputs() const { return m_minInputs; }
-  uint8_t maxInputs() const { return m_maxInputs; }
-  uint8_t defaultNewInputFlags() const { return m_defaultNewInputFlags; }
-  uint8_t minOutputs() const { return m_minOutputs; }
-  uint8_t maxOutputs() const { return m_maxOutputs; }
-  uint8_t defaultNewOutputFlags() const { return m_defaultNewOutputFlags; }
+  uint8_t minInputs() const { return m_editor->minInputs; }
+  uint8_t maxInputs() const { return m_editor->maxInputs; }
+  uint8_t defaultNewInputFlags() const { return m_editor->defaultNewInputFlags; }
+  uint8_t minOutputs() const { return m_editor->minOutputs; }
+  uint8_t maxOutputs() const { return m_editor->maxOutputs; }
+  uint8_t defaultNewOutputFlags() const { return m_editor->defaultNewOutputFlags; }
 
-  Package *package() const { return m_package; }
+  Package *package() const { return m_editor->package; }
 
   void resetIOSocketValue(IOSocket &a_io);
 
+  template<typename T>
+  T value(IOSocket const &a_io) const
+  {
+    assert(a_io.type == value_type_v<T>);
+    return m_values->get<T>(a_io.index);
+  }
+
+  template<typename T>
+  void setValue(IOSocket const &a_io, T const a_value)
+  {
+    assert(a_io.type == value_type_v<T>);
+    m_values->set<T>(a_io.index, a_value);
+  }
+
+  ValueStore &values() const { return *m_values; }
+
  protected:
   struct NameChanged {
-    std::string from;
-    std::string to;
+    string::handle_t from;
+    string::handle_t to;
   };
   struct IONameChanged {
     bool input;
     uint8_t id;
-    std::string from;
-    std::string to;
+    string::handle_t from;
+    string::handle_t to;
   };
   struct IOTypeChanged {
     bool input;
@@ -172,30 +207,54 @@ class SPAGHETTI_API Element {
 
   void setMinInputs(uint8_t const a_min);
   void setMaxInputs(uint8_t const a_max);
-  void setDefaultNewInputFlags(uint8_t const a_flags) { m_defaultNewInputFlags = a_flags; }
+  void setDefaultNewInputFlags(uint8_t const a_flags) { m_editor->defaultNewInputFlags = a_flags; }
 
   void setMinOutputs(uint8_t const a_min);
   void setMaxOutputs(uint8_t const a_max);
-  void setDefaultNewOutputFlags(uint8_t const a_flags) { m_defaultNewOutputFlags = a_flags; }
+  void setDefaultNewOutputFlags(uint8_t const a_flags) { m_editor->defaultNewOutputFlags = a_flags; }
+
+  // Setters of what serialize() writes under "properties" call this after changing it.
+  void propertiesChanged();
 
  protected:
-  IOSockets m_inputs{};
-  IOSockets m_outputs{};
+  SmallVector<IOSocket, INLINE_INPUTS> m_inputs{};
+  SmallVector<IOSocket, INLINE_OUTPUTS> m_outputs{};
 
+  friend class ElementArena;
+  friend class Journal;
   friend class Package;
-  Package *m_package{};
+  friend class PackageLoader;
+  ValueStore *m_values{ &ValueStore::detached() };
 
  private:
+  void bindValueStore(ValueStore *const a_values);
+
+ private:
+  // Editor-only state, kept out of line so the dispatch loop walking elements
+  // only pulls sockets and the value store into cache. Elements placed in an
+  // ElementArena keep it in the arena's own slabs, others on the heap.
+  struct EditorData {
+    Package *package{};
+    string::handle_t name{};
+    Vec2 position{};
+    bool isIconified{};
+    bool inArena{};
+    uint8_t minInputs{};
+    uint8_t maxInputs{ std::numeric_limits<uint8_t>::max() };
+    uint8_t minOutputs{};
+    uint8_t maxOutputs{ std::numeric_limits<uint8_t>::max() };
+    uint8_t defaultNewInputFlags{};
+    uint8_t defaultNewOutputFlags{};
+  };
+
+  struct EditorDataDeleter {
+    void operator()(EditorData *const a_data) const;
+  };
+
+  static EditorData *createEditorData();
+
   size_t m_id{};
-  std::string m_name{};
-  Vec2 m_position{};
-  bool m_isIconified{};
-  uint8_t m_minInputs{};
-  uint8_t m_maxInputs{ std::numeric_limits<uint8_t>::max() };
-  uint8_t m_minOutputs{};
-  uint8_t m_maxOutputs{ std::numeric_limits<uint8_t>::max() };
-  uint8_t m_defaultNewInputFlags{};
-  uint8_t m_defaultNewOutputFlags{};
+  std::unique_ptr<EditorData, EditorDataDeleter> m_editor{ createEditorData() };
 };
 
 } // namespace spaghetti
@@ -25,31 +25,32 @@
 #define SPAGHETTI_PACKAGE_H
 
 #include <atomic>
-
-// clang-format off
-#ifdef _MSC_VER
-# include <unordered_map>
-#else
-# include <sparsepp/spp.h>
-#endif
-// clang-format on
+#include <condition_variable>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <vector>
 
 #include <spaghetti/api.h>
+#include <spaghetti/dependency_graph.h>
 #include <spaghetti/element.h>
+#include <spaghetti/package_format.h>
 #include <spaghetti/strings.h>
-
-// clang-format off
-#define PACKAGE_SPP_MAP 1
-#define PACKAGE_STD_UNORDERED_MAP 2
-#ifdef _MSC_VER
-# define PACKAGE_MAP PACKAGE_STD_UNORDERED_MAP
-#else
-# define PACKAGE_MAP PACKAGE_SPP_MAP
-#endif
-// clang-format on
+#include <spaghetti/value_store.h>
 
 namespace spaghetti {
 
+class ElementArena;
+class Journal;
+class PackageSnapshot;
+class Recorder;
+struct Partitioning;
+
+namespace binary {
+class View;
+}
+
 class SPAGHETTI_API Package final : public Element {
  public:
   using Elements = std::vector<Element *>;
@@ -62,6 +63,65 @@ class SPAGHETTI_API Package final : public Element {
 
   using Connections = std::vector<Connection>;
 
+  struct PartitionStats {
+    size_t partitions{ 1 };
+    size_t cutSize{};
+    double imbalance{};
+  };
+
+  struct RealtimeOptions {
+    bool enabled{};
+    int32_t cpu{ -1 };
+    // SCHED_FIFO priority. Windows has no such policy, dispatch threads run at
+    // THREAD_PRIORITY_TIME_CRITICAL there and RealtimeStatus::fifo stays false.
+    int32_t priority{ 80 };
+    bool lockMemory{ true };
+  };
+
+  struct TickOptions {
+    std::chrono::nanoseconds period{ std::chrono::milliseconds(1) };
+    bool highResolution{};
+    std::chrono::nanoseconds spin{};
+  };
+
+  struct RealtimeStatus {
+    bool pinned{};
+    bool fifo{};
+    bool memoryLocked{};
+  };
+
+  // Bytes held by a package and everything nested in it. Names are interned
+  // process-wide, so nameBytes is shared with every other package.
+  struct MemoryUsage {
+    struct ElementType {
+      string::hash_t hash{};
+      char const *type{};
+      size_t count{};
+      size_t bytes{};
+    };
+    std::vector<ElementType> elements{};
+    size_t arenaBytes{};
+    size_t socketBytes{};
+    size_t editorBytes{};
+    size_t valueBytes{};
+    size_t connectionBytes{};
+    size_t dependencyBytes{};
+    size_t nameBytes{};
+    // Transient parser state of the last JSON open(), already freed.
+    size_t lastLoadJsonBytes{};
+
+    size_t total() const
+    {
+      return arenaBytes + socketBytes + editorBytes + valueBytes + connectionBytes + dependencyBytes + nameBytes;
+    }
+  };
+
+  // Old element id -> new element id, removed elements map to INVALID_ID.
+  using IdRemap = std::vector<size_t>;
+  using CompactionCallback = std::function<void(IdRemap const &)>;
+  using SaveCallback = std::function<void(bool const a_written)>;
+  static constexpr size_t const INVALID_ID{ std::numeric_limits<size_t>::max() };
+
   Package();
   ~Package() override;
 
@@ -80,6 +140,16 @@ class SPAGHETTI_API Package final : public Element {
   std::string_view packageIcon() const { return m_packageIcon; }
   void setPackageIcon(std::string a_icon) { m_packageIcon = a_icon; }
 
+  // A reference is saved as its packagePath() alone. Its elements come from that
+  // file, through a cache shared by all references to it, once they're first
+  // needed: when dispatching starts, on the first edit or by materialize().
+  // Edits to a reference aren't saved, clearing the flag keeps the contents as
+  // a local copy.
+  void setReference(bool const a_reference);
+  bool isReference() const { return m_reference; }
+  bool isMaterialized() const { return m_materialized; }
+  void materialize();
+
   void serialize(Json &a_json) override;
   void deserialize(Json const &a_json) override;
 
@@ -91,68 +161,187 @@ class SPAGHETTI_API Package final : public Element {
 
   Element *get(size_t const a_id) const;
 
+  void compact();
+  float fragmentation() const;
+  void setCompactionThreshold(float const a_threshold) { m_compactionThreshold = a_threshold; }
+  float compactionThreshold() const { return m_compactionThreshold; }
+  void setCompactionCallback(CompactionCallback a_callback) { m_compactionCallback = std::move(a_callback); }
+
   bool connect(size_t const a_sourceId, uint8_t const a_outputId, size_t const a_targetId, uint8_t const a_inputId);
   bool disconnect(size_t const a_sourceId, uint8_t const a_outputId, size_t const a_targetId, uint8_t const a_inputId);
 
   void dispatchThreadFunction();
 
   void startDispatchThread();
+  void startDispatchThread(RealtimeOptions const &a_options);
   void quitDispatchThread();
   void pauseDispatchThread();
   void resumeDispatchThread();
 
+  // Elements are calculated in id order, an input reads what its source wrote
+  // this tick if the source comes first and last tick's value otherwise. With
+  // more than one partition that holds inside each partition, while inputs fed
+  // across partitions always read last tick's value. Changes take longer to
+  // ripple through, but without feedback loops every output goes through the
+  // same values and settles on the same one as with a single partition.
+  void setDispatchPartitions(size_t const a_partitions);
+  size_t dispatchPartitions() const { return m_dispatchPartitions; }
+  PartitionStats partitionStats();
+
+  void setRealtimeOptions(RealtimeOptions const &a_options) { m_realtimeOptions = a_options; }
+  RealtimeOptions const &realtimeOptions() const { return m_realtimeOptions; }
+  RealtimeStatus realtimeStatus() const;
+  std::chrono::nanoseconds worstWakeUpLatency() const { return std::chrono::nanoseconds{ m_worstWakeUpLatency }; }
+  void resetWorstWakeUpLatency() { m_worstWakeUpLatency = 0; }
+
+  void setTickOptions(TickOptions const &a_options);
+  TickOptions const &tickOptions() const { return m_tickOptions; }
+  std::chrono::nanoseconds measuredTickPeriod() const { return std::chrono::nanoseconds{ m_measuredTickPeriod }; }
+
   void setInputsPosition(double const a_x, double const a_y);
-  void setInputsPosition(Vec2 const a_position) { m_inputsPosition = a_position; }
+  void setInputsPosition(Vec2 const a_position) { setInputsPosition(a_position.x, a_position.y); }
   Vec2 const &inputsPosition() const { return m_inputsPosition; }
 
   void setOutputsPosition(double const a_x, double const a_y);
-  void setOutputsPosition(Vec2 const a_position) { m_outputsPosition = a_position; }
+  void setOutputsPosition(Vec2 const a_position) { setOutputsPosition(a_position.x, a_position.y); }
   Vec2 const &outputsPosition() const { return m_outputsPosition; }
 
   Elements const &elements() const { return m_elements; }
   Connections const &connections() const { return m_connections; }
+  DependencyGraph const &dependencies() const { return m_dependencies; }
+
+  MemoryUsage memoryUsage() const;
 
   void open(std::string const &a_filename);
-  void save(std::string const &a_filename);
+  // JSON is indented unless a_compact is set, binary packages ignore it.
+  void save(std::string const &a_filename, bool const a_compact = false);
+
+  // Takes a snapshot between ticks and writes it on a thread of its own, the
+  // package keeps dispatching and can be edited meanwhile. a_callback runs on
+  // that thread once the file is written, finishSave() from the package's own
+  // thread puts it in place and moves the journal over to it.
+  void startSave(std::string const &a_filename, bool const a_compact = false, SaveCallback a_callback = {});
+  bool isSaving() const { return m_save != nullptr; }
+  // Waits for the save started last, false if it failed or there's none.
+  bool finishSave();
+
+  // Appends edits made since the last save or autosave to the package's journal,
+  // open() replays them. Only the root package of an opened or saved file has one.
+  bool autosave();
+  void compactJournal();
+
+  // Socket values and every element's runtimeState(), here and in nested packages,
+  // taken between ticks of the root package. Restoring needs a package of the same
+  // structure, anything else is refused and leaves the state as it was.
+  std::vector<uint8_t> checkpoint();
+  bool restore(uint8_t const *const a_data, size_t const a_size);
+  bool restore(std::vector<uint8_t> const &a_checkpoint) { return restore(a_checkpoint.data(), a_checkpoint.size()); }
+  bool saveCheckpoint(std::string const &a_filename);
+  bool loadCheckpoint(std::string const &a_filename);
+
+ private:
+  friend class Element;
+  friend class Journal;
+  friend class PackageLoader;
+  friend class Recorder;
+
+  void dispatchPartitioned();
+  void dispatchPartition(size_t const a_index);
+  void preparePartitions();
+  void rebuildPartitions();
+  void applyPartitioning(Partitioning const &a_result);
+  // Between ticks, takes the layout of a finished repartition job if nothing was
+  // edited since it started, or starts one over the package as it is now.
+  void updateRepartition();
+  // Partitions a copy of the package on a thread of its own, the previous job
+  // has to be done.
+  void startRepartition();
+  void finishRepartition();
+  void accumulateMemoryUsage(MemoryUsage &a_usage) const;
+  void deserializeContents(Json const &a_package);
+  void openSnapshot(std::string const &a_filename);
+  bool saveSnapshot(std::string const &a_filename, package_format::Format const a_format, bool const a_compact);
+  static bool writeSnapshot(PackageSnapshot const &a_snapshot, std::string const &a_filename,
+                            package_format::Format const a_format, bool const a_compact);
+  void compactTree();
+  void openJson(std::string const &a_filename);
+  void openBinary(std::string const &a_filename);
+  void load(binary::View const &a_view, uint32_t const a_package);
+  static void loadElement(Element &a_element, binary::View const &a_view, uint32_t const a_index);
+
+  // Adds one element per type with consecutive ids starting at the returned one and hands
+  // each to a_init. Large batches are built on worker threads, a_init has to be thread safe.
+  using BulkInit = std::function<void(size_t const a_index, Element &a_element)>;
+  size_t addBulk(std::vector<string::hash_t> const &a_types, BulkInit const &a_init);
+  static void rebase(Element &a_element, ValueStore::Offsets const &a_offsets, ValueStore *const a_values);
+  bool canConnect(size_t const a_sourceId, uint8_t const a_outputId, size_t const a_targetId,
+                  uint8_t const a_inputId) const;
+  void link(Connection const &a_connection);
+  void unlink(IOSocket &a_input);
+  // Disconnects a_id's inputs or outputs in [a_first, a_last) ahead of their slots being
+  // released or reallocated, no input is left reading a freed slot.
+  void disconnectSockets(size_t const a_id, bool const a_inputs, size_t const a_first, size_t const a_last);
+  void applyRealtime(size_t const a_index);
+  void waitForNextTick();
+  void waitWhilePaused();
+  // The package owning the store this one's sockets live in, nested packages share their root's.
+  Package *storeOwner();
 
  private:
   std::string m_packageDescription{ "A package" };
   std::string m_packagePath{ "packages/unknown_package" };
   std::string m_packageIcon{ "icons/unknown.png" };
+  bool m_reference{};
+  bool m_materialized{ true };
   Vec2 m_inputsPosition{};
   Vec2 m_outputsPosition{};
   Elements m_elements{};
   Connections m_connections{};
+  ValueStore m_valueStore{};
+  std::unique_ptr<ElementArena> m_arena{};
 
   std::vector<size_t> m_free{};
-
-#if PACKAGE_MAP == PACKAGE_SPP_MAP
-  using Callbacks = spp::sparse_hash_map<size_t, std::vector<size_t>>;
-#elif PACKAGE_MAP == PACKAGE_STD_UNORDERED_MAP
-  using Callbacks = std::unordered_map<size_t, std::vector<size_t>>;
-#endif
-
-  Callbacks m_dependencies{};
+  float m_compactionThreshold{ 0.5f };
+  size_t m_lastLoadJsonBytes{};
+  CompactionCallback m_compactionCallback{};
+  std::unique_ptr<Journal> m_journal{};
+  struct SaveJob;
+  std::unique_ptr<SaveJob> m_save{};
+  std::atomic<Recorder *> m_recorder{};
+
+  DependencyGraph m_dependencies{};
   std::thread m_dispatchThread{};
   std::atomic_bool m_dispatchThreadStarted{};
   std::atomic_bool m_quit{};
   std::atomic_bool m_pause{};
   std::atomic_bool m_paused{};
   std::atomic_uint32_t m_pauseCount{};
+  // Paused dispatch threads block here instead of spinning, a yield loop never lets
+  // a lower priority thread in under SCHED_FIFO.
+  std::mutex m_pauseMutex{};
+  std::condition_variable m_pauseChanged{};
+
+  struct PartitionPlan;
+  std::unique_ptr<PartitionPlan> m_partitionPlan{};
+  // Looked up in the schedule cache where the package was opened or dispatch started,
+  // taken by the next rebuildPartitions() so the dispatch thread never touches the cache.
+  std::unique_ptr<Partitioning> m_preparedPartitions{};
+  struct RepartitionJob;
+  std::unique_ptr<RepartitionJob> m_repartition{};
+  size_t m_dispatchPartitions{ 1 };
+  std::atomic_bool m_partitionsDirty{ true };
+
+  RealtimeOptions m_realtimeOptions{};
+  std::atomic_uint8_t m_realtimeStatus{};
+  bool m_memoryLocked{};
+  std::atomic_int64_t m_worstWakeUpLatency{};
+
+  TickOptions m_tickOptions{};
+  std::chrono::steady_clock::time_point m_tickDeadline{};
+  std::chrono::steady_clock::time_point m_lastWakeUp{};
+  std::atomic_int64_t m_measuredTickPeriod{};
 };
 
-inline void Package::setInputsPosition(double const a_x, double const a_y)
-{
-  m_inputsPosition.x = a_x;
-  m_inputsPosition.y = a_y;
-}
-
-inline void Package::setOutputsPosition(double const a_x, double const a_y)
-{
-  m_outputsPosition.x = a_x;
-  m_outputsPosition.y = a_y;
-}
-
 } // namespace spaghetti
 
 #endif // SPAGHETTI_PACKAGE_H
@@ -0,0 +1,58 @@
+// MIT License
+//
+// Copyright (c) 2017-2018 Artur Wyszyński, aljen at hitomi dot pl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+#ifndef SPAGHETTI_PACKAGE_FORMAT_H
+#define SPAGHETTI_PACKAGE_FORMAT_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <spaghetti/api.h>
+#include <spaghetti/element.h>
+
+namespace spaghetti::package_format {
+
+// Packages are stored either as indented JSON (.package), as gzip'ed JSON
+// (.package.z) streamed through zlib on the way in and out, or as a binary
+// image (.package.bin) that is mmap'ed and validated in one pass instead of parsed.
+enum class Format { eJson, eCompressed, eBinary };
+
+constexpr char const *const JSON_EXTENSION{ ".package" };
+constexpr char const *const COMPRESSED_EXTENSION{ ".package.z" };
+constexpr char const *const BINARY_EXTENSION{ ".package.bin" };
+
+SPAGHETTI_API Format format_for(std::string_view const a_filename);
+
+// Lossless conversion between a serialized package and its binary image.
+// Element specific keys that don't fit the fixed records travel as CBOR.
+SPAGHETTI_API bool json_to_binary(Element::Json const &a_json, std::vector<uint8_t> &a_binary);
+SPAGHETTI_API bool binary_to_json(uint8_t const *const a_data, size_t const a_size, Element::Json &a_json);
+
+// Converts a_from into a_to, both formats picked by extension.
+SPAGHETTI_API bool convert(std::string const &a_from, std::string const &a_to);
+
+} // namespace spaghetti::package_format
+
+#endif // SPAGHETTI_PACKAGE_FORMAT_H
@@ -0,0 +1,106 @@
+// MIT License
+//
+// Copyright (c) 2017-2018 Artur Wyszyński, aljen at hitomi dot pl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+#ifndef SPAGHETTI_RECORDER_H
+#define SPAGHETTI_RECORDER_H
+
+// clang-format off
+#ifdef _MSC_VER
+# pragma warning(disable:4251)
+#endif
+// clang-format on
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include <spaghetti/api.h>
+
+namespace spaghetti {
+
+class Element;
+class Package;
+
+// Records value changes of chosen outputs while a package dispatches. The
+// dispatch thread compares them once per tick and queues changes in a ring
+// buffer, a writer thread empties it into a file. Files ending in .trace get
+// the binary format TraceReader reads, anything else is VCD. A package without
+// a recorder only checks for one once per tick.
+class SPAGHETTI_API Recorder final {
+ public:
+  using SignalId = uint32_t;
+
+  struct Options {
+    // Changes waiting for the writer, ones that don't fit are dropped and
+    // retried on the next tick.
+    size_t bufferBytes{ 4 * 1024 * 1024 };
+    // Rounded down to a power of ten of a nanosecond.
+    std::chrono::nanoseconds timescale{ std::chrono::microseconds(1) };
+  };
+
+  struct Stats {
+    uint64_t ticks{};
+    uint64_t changes{};
+    uint64_t dropped{};
+    uint64_t bytesWritten{};
+    // Spent comparing signals on the dispatch thread.
+    std::chrono::nanoseconds sampleTime{};
+  };
+
+  explicit Recorder(Package &a_package);
+  Recorder(Package &a_package, Options const &a_options);
+  ~Recorder();
+
+  Recorder(Recorder const &) = delete;
+  Recorder &operator=(Recorder const &) = delete;
+
+  // Signals are added while not recording, to any element of the package or
+  // of packages nested in it. Removing the element ends its signal.
+  SignalId addSignal(Element &a_element, uint8_t const a_output);
+  size_t signals() const;
+
+  void setEnabled(SignalId const a_signal, bool const a_enabled);
+  bool isEnabled(SignalId const a_signal) const;
+
+  bool start(std::string const &a_filename);
+  bool stop();
+  bool isRecording() const;
+
+  Stats stats() const;
+
+ private:
+  friend class Package;
+
+  void sample();
+  void forget(Element const *const a_element);
+  void writeChanges();
+
+ private:
+  struct PIMPL;
+  std::unique_ptr<PIMPL> m_pimpl;
+};
+
+} // namespace spaghetti
+
+#endif // SPAGHETTI_RECORDER_H
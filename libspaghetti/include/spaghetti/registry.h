@@ -32,6 +32,7 @@
 
 #include <cassert>
 #include <memory>
+#include <new>
 #include <string>
 #include <type_traits>
 
@@ -41,6 +42,7 @@
 namespace spaghetti {
 
 class Element;
+class ElementArena;
 class Node;
 
 class SPAGHETTI_API Registry final {
@@ -53,6 +55,11 @@ class SPAGHETTI_API Registry final {
     using CloneFunc = T *(*)();
     CloneFunc<Element> cloneElement{};
     CloneFunc<Node> cloneNode{};
+    using PlaceFunc = Element *(*)(void *);
+    PlaceFunc placeElement{};
+    size_t elementSize{};
+    // Writes keys of its own on top of Element::serialize().
+    bool customSerialize{};
   };
 
  public:
@@ -67,28 +74,35 @@ class SPAGHETTI_API Registry final {
   typename std::enable_if_t<(std::is_base_of_v<Element, ElementDerived> && std::is_base_of_v<Node, NodeDerived>)>
   registerElement(std::string a_name, std::string a_icon)
   {
+    static_assert(alignof(ElementDerived) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__, "Element is over-aligned");
     string::hash_t const hash{ ElementDerived::HASH };
+    bool const CUSTOM_SERIALIZE{ !std::is_same_v<decltype(&ElementDerived::serialize),
+                                                 decltype(&ElementDerived::Element::serialize)> };
     assert(!hasElement(hash));
     MetaInfo info{ hash,
                    ElementDerived::TYPE,
                    std::move(a_name),
                    std::move(a_icon),
                    &cloneElement<ElementDerived>,
-                   &cloneNode<NodeDerived> };
+                   &cloneNode<NodeDerived>,
+                   &placeElement<ElementDerived>,
+                   sizeof(ElementDerived),
+                   CUSTOM_SERIALIZE };
     addElement(info);
   }
 
   Element *createElement(char const *const a_name) { return createElement(string::hash(a_name)); }
   Element *createElement(string::hash_t const a_hash);
+  Element *createElement(string::hash_t const a_hash, ElementArena &a_arena);
 
   Node *createNode(char const *const a_name) { return createNode(string::hash(a_name)); }
   Node *createNode(string::hash_t const a_hash);
 
-  std::string elementName(char const *const a_name) { return elementName(string::hash(a_name)); }
-  std::string elementName(string::hash_t const a_hash);
+  std::string const &elementName(char const *const a_name) { return elementName(string::hash(a_name)); }
+  std::string const &elementName(string::hash_t const a_hash);
 
-  std::string elementIcon(char const *const a_name) { return elementIcon(string::hash(a_name)); }
-  std::string elementIcon(string::hash_t const a_hash);
+  std::string const &elementIcon(char const *const a_name) { return elementIcon(string::hash(a_name)); }
+  std::string const &elementIcon(string::hash_t const a_hash);
 
   bool hasElement(string::hash_t const a_hash) const;
 
@@ -101,6 +115,7 @@ class SPAGHETTI_API Registry final {
   std::string userPluginsPath() const;
   std::string systemPackagesPath() const;
   std::string userPackagesPath() const;
+  std::string userCachePath() const;
 
  private:
   Registry();
@@ -113,6 +128,12 @@ class SPAGHETTI_API Registry final {
     return new T;
   }
 
+  template<typename T>
+  static Element *placeElement(void *const a_memory)
+  {
+    return new (a_memory) T;
+  }
+
   template<typename T>
   static Node *cloneNode()
   {
@@ -0,0 +1,166 @@
+// MIT License
+//
+// Copyright (c) 2017-2018 Artur Wyszyński, aljen at hitomi dot pl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+#ifndef SPAGHETTI_SMALL_VECTOR_H
+#define SPAGHETTI_SMALL_VECTOR_H
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <utility>
+
+namespace spaghetti {
+
+// Vector keeping its first N elements inside the owning object and spilling
+// to the heap only past that. All sizes share SmallVectorBase<T>, so code that
+// doesn't care about the inline capacity can take the base by reference.
+template<typename T>
+class SmallVectorBase {
+ public:
+  using value_type = T;
+  using iterator = T *;
+  using const_iterator = T const *;
+
+  SmallVectorBase(SmallVectorBase const &) = delete;
+  SmallVectorBase &operator=(SmallVectorBase const &) = delete;
+
+  size_t size() const { return m_size; }
+  size_t capacity() const { return m_capacity; }
+  bool empty() const { return m_size == 0; }
+
+  T *data() { return m_begin; }
+  T const *data() const { return m_begin; }
+
+  iterator begin() { return m_begin; }
+  iterator end() { return m_begin + m_size; }
+  const_iterator begin() const { return m_begin; }
+  const_iterator end() const { return m_begin + m_size; }
+
+  T &operator[](size_t const a_index)
+  {
+    assert(a_index < m_size);
+    return m_begin[a_index];
+  }
+  T const &operator[](size_t const a_index) const
+  {
+    assert(a_index < m_size);
+    return m_begin[a_index];
+  }
+
+  T &front() { return (*this)[0]; }
+  T const &front() const { return (*this)[0]; }
+  T &back() { return (*this)[m_size - 1]; }
+  T const &back() const { return (*this)[m_size - 1]; }
+
+  void push_back(T const &a_value) { emplace_back(a_value); }
+  void push_back(T &&a_value) { emplace_back(std::move(a_value)); }
+
+  template<typename... Args>
+  T &emplace_back(Args &&... a_args)
+  {
+    if (m_size == m_capacity) grow(m_size + 1);
+    T *const element{ new (m_begin + m_size) T(std::forward<Args>(a_args)...) };
+    ++m_size;
+    return *element;
+  }
+
+  void pop_back()
+  {
+    assert(m_size > 0);
+    m_begin[--m_size].~T();
+  }
+
+  void clear()
+  {
+    for (uint32_t i = 0; i < m_size; ++i) m_begin[i].~T();
+    m_size = 0;
+  }
+
+  void reserve(size_t const a_capacity)
+  {
+    if (a_capacity > m_capacity) grow(a_capacity);
+  }
+
+  bool isInline() const { return m_begin == inlineStorage(); }
+
+ protected:
+  explicit SmallVectorBase(uint32_t const a_inlineCapacity)
+    : m_begin{ inlineStorage() }
+    , m_capacity{ a_inlineCapacity }
+  {
+  }
+
+  ~SmallVectorBase()
+  {
+    clear();
+    if (!isInline()) ::operator delete(m_begin);
+  }
+
+  // Inline storage sits right behind this base in SmallVector<T, N>.
+  T *inlineStorage() const
+  {
+    constexpr size_t const OFFSET{ (sizeof(SmallVectorBase) + alignof(T) - 1) / alignof(T) * alignof(T) };
+    return reinterpret_cast<T *>(const_cast<char *>(reinterpret_cast<char const *>(this)) + OFFSET);
+  }
+
+ private:
+  void grow(size_t const a_minimum)
+  {
+    size_t const CAPACITY{ std::max<size_t>(a_minimum, size_t{ m_capacity } * 2) };
+    T *const elements{ static_cast<T *>(::operator new(CAPACITY * sizeof(T))) };
+
+    for (uint32_t i = 0; i < m_size; ++i) {
+      new (elements + i) T(std::move(m_begin[i]));
+      m_begin[i].~T();
+    }
+
+    if (!isInline()) ::operator delete(m_begin);
+
+    m_begin = elements;
+    m_capacity = static_cast<uint32_t>(CAPACITY);
+  }
+
+ private:
+  T *m_begin{};
+  uint32_t m_size{};
+  uint32_t m_capacity{};
+};
+
+template<typename T, size_t N>
+class SmallVector final : public SmallVectorBase<T> {
+ public:
+  SmallVector()
+    : SmallVectorBase<T>{ static_cast<uint32_t>(N) }
+  {
+    assert(static_cast<void *>(m_storage) == this->inlineStorage());
+  }
+
+ private:
+  alignas(T) std::byte m_storage[N * sizeof(T)];
+};
+
+} // namespace spaghetti
+
+#endif // SPAGHETTI_SMALL_VECTOR_H
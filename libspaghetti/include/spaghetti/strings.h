@@ -25,6 +25,10 @@
 #define SPAGHETTI_STRINGS_H
 
 #include <cstdint>
+#include <string>
+#include <string_view>
+
+#include <spaghetti/api.h>
 
 #define HASH_SIZE_32 32
 #define HASH_SIZE_64 64
@@ -61,6 +65,42 @@ constexpr hash_t hash(char const *const a_key, hash_t const &a_offset = FNV_OFFS
   return value;
 }
 
+constexpr hash_t hash(std::string_view const a_key, hash_t const &a_offset = FNV_OFFSET,
+                      hash_t const &a_prime = FNV_PRIME)
+{
+  hash_t value{ a_offset };
+  for (char const CHARACTER : a_key) {
+    value ^= static_cast<hash_t>(CHARACTER);
+    value *= a_prime;
+  }
+
+  return value;
+}
+
+// Handle of a string interned in the process-wide string table, interning the
+// same text twice yields the same handle. 0 is the empty string.
+// Every intern() takes a reference its caller gives back with release(), a
+// string without any is dropped and its handle reused, so the table is bounded
+// by the names in use rather than every name ever set.
+using handle_t = uint32_t;
+
+SPAGHETTI_API handle_t intern(std::string_view const a_string);
+SPAGHETTI_API void release(handle_t const a_handle);
+SPAGHETTI_API std::string const &lookup(handle_t const a_handle);
+SPAGHETTI_API size_t interned();
+SPAGHETTI_API size_t memory_usage();
+
+// Defers dropping strings while it lives, handles copied without a reference
+// of their own stay valid until it's gone.
+class SPAGHETTI_API Hold final {
+ public:
+  Hold();
+  ~Hold();
+
+  Hold(Hold const &) = delete;
+  Hold &operator=(Hold const &) = delete;
+};
+
 } // namespace spaghetti::string
 
 #endif // SPAGHETTI_STRINGS_H
@@ -0,0 +1,103 @@
+// MIT License
+//
+// Copyright (c) 2017-2018 Artur Wyszyński, aljen at hitomi dot pl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+#ifndef SPAGHETTI_TRACE_READER_H
+#define SPAGHETTI_TRACE_READER_H
+
+// clang-format off
+#ifdef _MSC_VER
+# pragma warning(disable:4251)
+#endif
+// clang-format on
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <spaghetti/api.h>
+#include <spaghetti/value_store.h>
+
+namespace spaghetti {
+
+// Reads the binary traces a Recorder writes to .trace files. The file is
+// mapped, opening reads the header and the signals only, a lookup finds its
+// chunk with a binary search and decodes one change list of it. Times are in
+// timescale() units since the recording started.
+class SPAGHETTI_API TraceReader final {
+ public:
+  using SignalId = uint32_t;
+
+  static constexpr char const *const EXTENSION{ ".trace" };
+
+  struct Signal {
+    // Dot separated nested package labels.
+    std::string scope{};
+    std::string name{};
+    ValueType type{};
+  };
+
+  struct Value {
+    // False before the first sample and while the signal was disabled or removed.
+    bool known{};
+    // Whichever matches the signal's type.
+    bool boolean{};
+    int32_t integer{};
+    float real{};
+  };
+
+  struct Change {
+    uint64_t time{};
+    Value value{};
+  };
+
+  TraceReader();
+  ~TraceReader();
+
+  TraceReader(TraceReader const &) = delete;
+  TraceReader &operator=(TraceReader const &) = delete;
+
+  // A trace whose recording didn't finish is read up to its last whole chunk.
+  bool open(std::string const &a_filename);
+  void close();
+  bool isOpen() const;
+  bool isComplete() const;
+
+  std::vector<Signal> const &signals() const;
+  std::chrono::nanoseconds timescale() const;
+  uint64_t endTime() const;
+  size_t chunks() const;
+
+  Value valueAt(SignalId const a_signal, uint64_t const a_time) const;
+  // Changes with a_from <= time <= a_to.
+  std::vector<Change> changes(SignalId const a_signal, uint64_t const a_from, uint64_t const a_to) const;
+
+ private:
+  struct PIMPL;
+  std::unique_ptr<PIMPL> m_pimpl;
+};
+
+} // namespace spaghetti
+
+#endif // SPAGHETTI_TRACE_READER_H
@@ -0,0 +1,138 @@
+// MIT License
+//
+// Copyright (c) 2017-2018 Artur Wyszyński, aljen at hitomi dot pl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+#ifndef SPAGHETTI_VALUE_STORE_H
+#define SPAGHETTI_VALUE_STORE_H
+
+// clang-format off
+#ifdef _MSC_VER
+# pragma warning(disable:4251)
+#endif
+// clang-format on
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
+#include <spaghetti/api.h>
+
+namespace spaghetti {
+
+enum class ValueType { eBool, eInt, eFloat };
+
+template<typename T>
+constexpr ValueType value_type_v = std::is_same_v<T, bool>
+                                       ? ValueType::eBool
+                                       : std::is_same_v<T, int32_t> ? ValueType::eInt : ValueType::eFloat;
+
+// Socket values of a whole package kept in one contiguous array per type,
+// sockets only hold an index into the array matching their type.
+// Bools take a byte each so elements of different dispatch partitions never
+// write to the same word.
+class SPAGHETTI_API ValueStore final {
+ public:
+  using Index = uint32_t;
+
+  // Where the slots of a store appended to another one start, per type.
+  struct Offsets {
+    Index bools{};
+    Index ints{};
+    Index floats{};
+
+    Index of(ValueType const a_type) const
+    {
+      return a_type == ValueType::eBool ? bools : a_type == ValueType::eInt ? ints : floats;
+    }
+  };
+
+  ValueStore() = default;
+  ValueStore(ValueStore const &) = delete;
+  ValueStore &operator=(ValueStore const &) = delete;
+
+  // Store of elements that don't belong to any package yet, one per thread so
+  // elements can be built concurrently.
+  static ValueStore &detached();
+
+  Index allocate(ValueType const a_type);
+  void release(ValueType const a_type, Index const a_index);
+  void reset(ValueType const a_type, Index const a_index);
+
+  // Moves all slots of a_other, free ones included, behind the slots of this store.
+  Offsets append(ValueStore &a_other);
+
+  void copy(ValueType const a_type, Index const a_from, Index const a_to)
+  {
+    switch (a_type) {
+      case ValueType::eBool: m_bools[a_to] = m_bools[a_from]; break;
+      case ValueType::eInt: m_ints[a_to] = m_ints[a_from]; break;
+      case ValueType::eFloat: m_floats[a_to] = m_floats[a_from]; break;
+    }
+  }
+
+  template<typename T>
+  T get(Index const a_index) const
+  {
+    if constexpr (std::is_same_v<T, bool>)
+      return m_bools[a_index] != 0;
+    else if constexpr (std::is_same_v<T, int32_t>)
+      return m_ints[a_index];
+    else {
+      static_assert(std::is_same_v<T, float>, "Unsupported value type");
+      return m_floats[a_index];
+    }
+  }
+
+  template<typename T>
+  void set(Index const a_index, T const a_value)
+  {
+    if constexpr (std::is_same_v<T, bool>)
+      m_bools[a_index] = a_value;
+    else if constexpr (std::is_same_v<T, int32_t>)
+      m_ints[a_index] = a_value;
+    else {
+      static_assert(std::is_same_v<T, float>, "Unsupported value type");
+      m_floats[a_index] = a_value;
+    }
+  }
+
+  size_t size(ValueType const a_type) const;
+  size_t memoryUsage() const;
+
+ private:
+  std::vector<uint8_t> m_bools{};
+  std::vector<int32_t> m_ints{};
+  std::vector<float> m_floats{};
+
+  std::vector<Index> m_freeBools{};
+  std::vector<Index> m_freeInts{};
+  std::vector<Index> m_freeFloats{};
+
+  std::mutex m_mutex{};
+};
+
+} // namespace spaghetti
+
+#endif // SPAGHETTI_VALUE_STORE_H
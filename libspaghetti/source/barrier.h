@@ -0,0 +1,91 @@
+// MIT License
+//
+// Copyright (c) 2017-2018 Artur Wyszyński, aljen at hitomi dot pl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+#ifndef SPAGHETTI_BARRIER_H
+#define SPAGHETTI_BARRIER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+
+namespace spaghetti {
+
+// Reusable barrier, the last thread to arrive runs the completion step while
+// the others are still held, so it may safely touch shared state. Waiters spin
+// briefly and then block, the completion may sleep for a whole tick or pause and
+// a spinning SCHED_FIFO thread would starve everything else on its core.
+class Barrier final {
+ public:
+  explicit Barrier(size_t const a_count)
+    : m_count{ a_count }
+  {
+  }
+
+  template<typename Completion>
+  void wait(Completion &&a_completion)
+  {
+    size_t const GENERATION{ m_generation.load(std::memory_order_acquire) };
+
+    if (m_arrived.fetch_add(1, std::memory_order_acq_rel) + 1 == m_count) {
+      a_completion();
+      m_arrived.store(0, std::memory_order_relaxed);
+      {
+        std::lock_guard<std::mutex> lock{ m_mutex };
+        m_generation.fetch_add(1, std::memory_order_acq_rel);
+      }
+      m_released.notify_all();
+      return;
+    }
+
+    for (size_t i = 0; i < SPIN_LIMIT; ++i) {
+      if (m_generation.load(std::memory_order_acquire) != GENERATION) return;
+      std::this_thread::yield();
+    }
+
+    std::unique_lock<std::mutex> lock{ m_mutex };
+    m_released.wait(lock, [this, GENERATION] { return m_generation.load(std::memory_order_acquire) != GENERATION; });
+  }
+
+  void wait()
+  {
+    wait([] {});
+  }
+
+  size_t count() const { return m_count; }
+
+ private:
+  // Enough for partitions finishing a tick close together to skip the mutex.
+  static constexpr size_t const SPIN_LIMIT{ 256 };
+
+  size_t const m_count{};
+  std::atomic_size_t m_arrived{};
+  std::atomic_size_t m_generation{};
+  std::mutex m_mutex{};
+  std::condition_variable m_released{};
+};
+
+} // namespace spaghetti
+
+#endif // SPAGHETTI_BARRIER_H
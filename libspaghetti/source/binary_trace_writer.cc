@@ -0,0 +1,206 @@
+// MIT License
+//
+// Copyright (c) 2017-2018 Artur Wyszyński, aljen at hitomi dot pl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "binary_trace_writer.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace spaghetti {
+
+namespace {
+
+size_t aligned(size_t const a_offset)
+{
+  return (a_offset + 7) & ~size_t{ 7 };
+}
+
+template<typename T>
+void append(std::vector<uint8_t> &a_buffer, T const &a_value)
+{
+  uint8_t const *const BYTES{ reinterpret_cast<uint8_t const *>(&a_value) };
+  a_buffer.insert(std::end(a_buffer), BYTES, BYTES + sizeof(T));
+}
+
+} // namespace
+
+bool BinaryTraceWriter::open(std::string const &a_filename, std::vector<TraceSignal> const &a_signals,
+                             std::chrono::nanoseconds const a_timescale)
+{
+  m_file.open(a_filename, std::ios::binary | std::ios::trunc);
+  if (!m_file.is_open()) return false;
+
+  size_t const SIGNALS{ a_signals.size() };
+
+  std::memcpy(m_header.magic, trace::MAGIC, sizeof(trace::MAGIC));
+  m_header.version = trace::VERSION;
+  m_header.endian = trace::ENDIAN_MARK;
+  m_header.timescale = static_cast<uint64_t>(a_timescale.count());
+  m_header.signals = SIGNALS;
+
+  std::vector<uint8_t> table{};
+  for (auto const &SIGNAL : a_signals) {
+    m_types.push_back(SIGNAL.type);
+    table.push_back(static_cast<uint8_t>(SIGNAL.type));
+    for (auto const *const STRING : { &SIGNAL.scope, &SIGNAL.name }) {
+      append(table, static_cast<uint32_t>(STRING->size()));
+      table.insert(std::end(table), std::begin(*STRING), std::end(*STRING));
+    }
+  }
+  table.resize(aligned(sizeof(trace::Header) + table.size()) - sizeof(trace::Header));
+
+  m_header.firstChunk = sizeof(trace::Header) + table.size();
+  m_offset = m_header.firstChunk;
+
+  m_file.write(reinterpret_cast<char const *>(&m_header), sizeof(m_header));
+  m_file.write(reinterpret_cast<char const *>(table.data()), static_cast<std::streamsize>(table.size()));
+
+  m_bits.assign(SIGNALS, 0);
+  m_tags.assign(SIGNALS, trace::TAG_UNKNOWN);
+  m_startBits = m_bits;
+  m_startTags = m_tags;
+  m_lists.resize(SIGNALS);
+  m_listBytes = std::max(LIST_BYTES, SIGNALS * (sizeof(uint32_t) + sizeof(uint8_t)));
+
+  return m_file.good();
+}
+
+void BinaryTraceWriter::write(TraceChange const *const a_changes, size_t const a_count)
+{
+  for (size_t i = 0; i < a_count; ++i) {
+    auto const &CHANGE = a_changes[i];
+    uint32_t const SIGNAL{ CHANGE.signal() };
+
+    if (!m_chunkOpen) {
+      m_chunkOpen = true;
+      m_chunkStart = CHANGE.time;
+    }
+    m_chunkEnd = CHANGE.time;
+
+    auto &list = m_lists[SIGNAL];
+    if (list.changes == 0) {
+      m_changed.push_back(SIGNAL);
+      list.lastTime = m_chunkStart;
+    }
+
+    uint8_t tag{};
+    switch (CHANGE.kind()) {
+      case TraceChange::Kind::eBool: tag = CHANGE.bits ? trace::TAG_TRUE : trace::TAG_FALSE; break;
+      case TraceChange::Kind::eInt:
+      case TraceChange::Kind::eFloat: tag = trace::TAG_VALUE; break;
+      case TraceChange::Kind::eUnknown: tag = trace::TAG_UNKNOWN; break;
+    }
+
+    uint8_t encoded[16]{};
+    uint8_t *cursor{ encoded };
+    trace::write_varint(cursor, ((CHANGE.time - list.lastTime) << 2) | tag);
+    if (tag == trace::TAG_VALUE) {
+      if (m_types[SIGNAL] == ValueType::eInt)
+        trace::write_varint(cursor, trace::zigzag(static_cast<int32_t>(CHANGE.bits)));
+      else {
+        std::memcpy(cursor, &CHANGE.bits, sizeof(CHANGE.bits));
+        cursor += sizeof(CHANGE.bits);
+      }
+    }
+
+    size_t const SIZE{ static_cast<size_t>(cursor - encoded) };
+    list.data.insert(std::end(list.data), encoded, cursor);
+    list.changes++;
+    list.lastTime = CHANGE.time;
+    m_pending += SIZE;
+
+    m_tags[SIGNAL] = tag;
+    m_bits[SIGNAL] = tag == trace::TAG_VALUE ? CHANGE.bits : 0;
+
+    if (m_pending >= CHUNK_BYTES || list.data.size() >= m_listBytes) flush();
+  }
+}
+
+void BinaryTraceWriter::flush()
+{
+  if (!m_chunkOpen) return;
+
+  std::sort(std::begin(m_changed), std::end(m_changed));
+
+  size_t const SIGNALS{ m_lists.size() };
+  size_t const DIRECTORY{ aligned(sizeof(trace::ChunkHeader) + SIGNALS * (sizeof(uint32_t) + sizeof(uint8_t))) };
+  size_t const LISTS{ DIRECTORY + m_changed.size() * sizeof(trace::ListEntry) };
+
+  trace::ChunkHeader header{};
+  header.magic = trace::CHUNK_MAGIC;
+  header.lists = static_cast<uint32_t>(m_changed.size());
+  header.size = aligned(LISTS + m_pending);
+  header.startTime = m_chunkStart;
+  header.endTime = m_chunkEnd;
+
+  m_chunk.clear();
+  m_chunk.reserve(header.size);
+  append(m_chunk, header);
+  for (auto const BITS : m_startBits) append(m_chunk, BITS);
+  m_chunk.insert(std::end(m_chunk), std::begin(m_startTags), std::end(m_startTags));
+  m_chunk.resize(DIRECTORY);
+
+  uint64_t offset{ LISTS };
+  for (auto const SIGNAL : m_changed) {
+    auto const &LIST = m_lists[SIGNAL];
+    append(m_chunk, trace::ListEntry{ SIGNAL, LIST.changes, offset });
+    offset += LIST.data.size();
+  }
+  for (auto const SIGNAL : m_changed) {
+    auto &list = m_lists[SIGNAL];
+    m_chunk.insert(std::end(m_chunk), std::begin(list.data), std::end(list.data));
+    list.data.clear();
+    list.changes = 0;
+  }
+  m_chunk.resize(header.size);
+
+  m_file.write(reinterpret_cast<char const *>(m_chunk.data()), static_cast<std::streamsize>(m_chunk.size()));
+  m_index.push_back({ m_offset, m_chunkStart, m_chunkEnd });
+  m_offset += header.size;
+
+  m_startBits = m_bits;
+  m_startTags = m_tags;
+  m_changed.clear();
+  m_pending = 0;
+  m_chunkOpen = false;
+}
+
+bool BinaryTraceWriter::close(uint64_t &a_bytes)
+{
+  flush();
+
+  m_header.index = m_offset;
+  m_header.chunks = m_index.size();
+  m_header.endTime = m_index.empty() ? 0 : m_index.back().endTime;
+
+  m_file.write(reinterpret_cast<char const *>(m_index.data()),
+               static_cast<std::streamsize>(m_index.size() * sizeof(trace::IndexEntry)));
+  m_file.seekp(0);
+  m_file.write(reinterpret_cast<char const *>(&m_header), sizeof(m_header));
+
+  a_bytes = m_offset + m_index.size() * sizeof(trace::IndexEntry);
+  bool const GOOD{ m_file.good() };
+  m_file.close();
+  return GOOD;
+}
+
+} // namespace spaghetti
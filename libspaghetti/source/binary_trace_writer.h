@@ -0,0 +1,83 @@
+// MIT License
+//
+// Copyright (c) 2017-2018 Artur Wyszyński, aljen at hitomi dot pl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+#ifndef SPAGHETTI_BINARY_TRACE_WRITER_H
+#define SPAGHETTI_BINARY_TRACE_WRITER_H
+
+#include <fstream>
+
+#include "trace_format.h"
+#include "trace_writer.h"
+
+namespace spaghetti {
+
+// Writes the .trace format described in trace_format.h. Changes are sorted into
+// per-signal lists in memory and written out a chunk at a time.
+class BinaryTraceWriter final : public TraceWriter {
+ public:
+  // Encoded changes at which a chunk is written out. A lookup decodes one list
+  // from the chunk's start, so a single list reaching LIST_BYTES, or the
+  // keyframe's size if that's larger, ends the chunk too.
+  static constexpr size_t const CHUNK_BYTES{ 1 << 20 };
+  static constexpr size_t const LIST_BYTES{ 4 * 1024 };
+
+  bool open(std::string const &a_filename, std::vector<TraceSignal> const &a_signals,
+            std::chrono::nanoseconds const a_timescale) override;
+  void write(TraceChange const *const a_changes, size_t const a_count) override;
+  bool close(uint64_t &a_bytes) override;
+
+ private:
+  void flush();
+
+ private:
+  struct List {
+    std::vector<uint8_t> data{};
+    uint32_t changes{};
+    uint64_t lastTime{};
+  };
+
+  std::ofstream m_file{};
+  trace::Header m_header{};
+  uint64_t m_offset{};
+  std::vector<ValueType> m_types{};
+
+  // Values as of the last change written and as of the current chunk's start.
+  std::vector<uint32_t> m_bits{};
+  std::vector<uint8_t> m_tags{};
+  std::vector<uint32_t> m_startBits{};
+  std::vector<uint8_t> m_startTags{};
+
+  std::vector<List> m_lists{};
+  std::vector<uint32_t> m_changed{};
+  size_t m_pending{};
+  size_t m_listBytes{};
+  bool m_chunkOpen{};
+  uint64_t m_chunkStart{};
+  uint64_t m_chunkEnd{};
+  std::vector<uint8_t> m_chunk{};
+  std::vector<trace::IndexEntry> m_index{};
+};
+
+} // namespace spaghetti
+
+#endif // SPAGHETTI_BINARY_TRACE_WRITER_H
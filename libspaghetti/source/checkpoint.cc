@@ -0,0 +1,203 @@
+// MIT License
+//
+// Copyright (c) 2017-2018 Artur Wyszyński, aljen at hitomi dot pl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "checkpoint.h"
+
+#include <cstring>
+
+#include "spaghetti/logger.h"
+
+namespace spaghetti {
+
+namespace {
+
+constexpr char const MAGIC[8]{ 'S', 'P', 'A', 'G', 'C', 'K', 'P', '\0' };
+constexpr uint32_t VERSION{ 1 };
+
+struct Header {
+  char magic[8]{};
+  uint32_t version{};
+  uint32_t reserved{};
+  uint64_t structure{};
+  uint64_t size{};
+};
+
+struct Layout {
+  uint64_t structure{ 0xcbf29ce484222325ULL };
+  uint64_t size{};
+
+  void add(uint64_t const a_value) { structure = (structure ^ a_value) * 0x100000001b3ULL; }
+};
+
+size_t value_size(ValueType const a_type)
+{
+  return a_type == ValueType::eBool ? 1 : 4;
+}
+
+// Nested packages are walked in place of their own element, their id 0 is that
+// element again.
+template<typename Callback>
+void for_each_element(Package &a_package, Callback &&a_callback)
+{
+  auto const &ELEMENTS = a_package.elements();
+  a_callback(*ELEMENTS[0]);
+
+  size_t const SIZE{ ELEMENTS.size() };
+  for (size_t i = 1; i < SIZE; ++i) {
+    Element *const element{ ELEMENTS[i] };
+    if (!element) continue;
+
+    if (element->hash() == Package::HASH)
+      for_each_element(*static_cast<Package *>(element), a_callback);
+    else
+      a_callback(*element);
+  }
+}
+
+Layout layout(Package &a_package)
+{
+  Layout layout{};
+
+  auto addSocket = [&layout](Element::IOSocket const &a_socket) {
+    layout.add(static_cast<uint64_t>(a_socket.type));
+    layout.size += value_size(a_socket.type);
+  };
+
+  for_each_element(a_package, [&layout, &addSocket](Element &a_element) {
+    layout.add(a_element.hash());
+    for (auto const &INPUT : a_element.inputs())
+      if (!INPUT.linked) addSocket(INPUT);
+    layout.add(a_element.inputs().size());
+    for (auto const &OUTPUT : a_element.outputs()) addSocket(OUTPUT);
+    layout.add(a_element.outputs().size());
+
+    size_t const STATE_SIZE{ a_element.runtimeState().size };
+    layout.add(STATE_SIZE);
+    layout.size += STATE_SIZE;
+  });
+
+  return layout;
+}
+
+uint8_t *save_value(ValueStore const &a_values, Element::IOSocket const &a_socket, uint8_t *a_cursor)
+{
+  switch (a_socket.type) {
+    case ValueType::eBool: *a_cursor = a_values.get<bool>(a_socket.index); break;
+    case ValueType::eInt: {
+      int32_t const VALUE{ a_values.get<int32_t>(a_socket.index) };
+      std::memcpy(a_cursor, &VALUE, sizeof(VALUE));
+      break;
+    }
+    case ValueType::eFloat: {
+      float const VALUE{ a_values.get<float>(a_socket.index) };
+      std::memcpy(a_cursor, &VALUE, sizeof(VALUE));
+      break;
+    }
+  }
+
+  return a_cursor + value_size(a_socket.type);
+}
+
+uint8_t const *restore_value(ValueStore &a_values, Element::IOSocket const &a_socket, uint8_t const *a_cursor)
+{
+  switch (a_socket.type) {
+    case ValueType::eBool: a_values.set<bool>(a_socket.index, *a_cursor != 0); break;
+    case ValueType::eInt: {
+      int32_t value{};
+      std::memcpy(&value, a_cursor, sizeof(value));
+      a_values.set<int32_t>(a_socket.index, value);
+      break;
+    }
+    case ValueType::eFloat: {
+      float value{};
+      std::memcpy(&value, a_cursor, sizeof(value));
+      a_values.set<float>(a_socket.index, value);
+      break;
+    }
+  }
+
+  return a_cursor + value_size(a_socket.type);
+}
+
+} // namespace
+
+void Checkpoint::save(Package &a_package, std::vector<uint8_t> &a_buffer)
+{
+  Layout const LAYOUT{ layout(a_package) };
+
+  Header header{};
+  std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+  header.version = VERSION;
+  header.structure = LAYOUT.structure;
+  header.size = LAYOUT.size;
+
+  a_buffer.resize(sizeof(Header) + LAYOUT.size);
+  std::memcpy(a_buffer.data(), &header, sizeof(Header));
+
+  uint8_t *cursor{ a_buffer.data() + sizeof(Header) };
+  for_each_element(a_package, [&cursor](Element &a_element) {
+    auto const &VALUES = a_element.values();
+    for (auto const &INPUT : a_element.inputs())
+      if (!INPUT.linked) cursor = save_value(VALUES, INPUT, cursor);
+    for (auto const &OUTPUT : a_element.outputs()) cursor = save_value(VALUES, OUTPUT, cursor);
+
+    auto const STATE = a_element.runtimeState();
+    if (STATE.size == 0) return;
+    std::memcpy(cursor, STATE.data, STATE.size);
+    cursor += STATE.size;
+  });
+}
+
+bool Checkpoint::restore(Package &a_package, uint8_t const *const a_data, size_t const a_size)
+{
+  if (a_size < sizeof(Header)) return false;
+
+  Header header{};
+  std::memcpy(&header, a_data, sizeof(Header));
+  if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION) {
+    log::error("[checkpoint]: Not a checkpoint");
+    return false;
+  }
+
+  Layout const LAYOUT{ layout(a_package) };
+  if (header.structure != LAYOUT.structure || header.size != LAYOUT.size || a_size != sizeof(Header) + LAYOUT.size) {
+    log::error("[checkpoint]: Checkpoint was taken from a package of another structure");
+    return false;
+  }
+
+  uint8_t const *cursor{ a_data + sizeof(Header) };
+  for_each_element(a_package, [&cursor](Element &a_element) {
+    auto &values = a_element.values();
+    for (auto const &INPUT : a_element.inputs())
+      if (!INPUT.linked) cursor = restore_value(values, INPUT, cursor);
+    for (auto const &OUTPUT : a_element.outputs()) cursor = restore_value(values, OUTPUT, cursor);
+
+    auto const STATE = a_element.runtimeState();
+    if (STATE.size == 0) return;
+    std::memcpy(STATE.data, cursor, STATE.size);
+    cursor += STATE.size;
+  });
+
+  return true;
+}
+
+} // namespace spaghetti
@@ -0,0 +1,49 @@
+// MIT License
+//
+// Copyright (c) 2017-2018 Artur Wyszyński, aljen at hitomi dot pl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+#ifndef SPAGHETTI_CHECKPOINT_H
+#define SPAGHETTI_CHECKPOINT_H
+
+#include <cstdint>
+#include <vector>
+
+#include "spaghetti/package.h"
+
+namespace spaghetti {
+
+// Runtime state of a package and everything nested in it, in one buffer:
+//
+//   Header | per element, depth first: unlinked inputs | outputs | runtimeState()
+//
+// Bools take a byte, ints and floats four, native endian. Where everything goes
+// follows from the structure alone, so a checkpoint only restores into a package
+// built the same way, told apart by a hash of that structure in the header.
+class Checkpoint final {
+ public:
+  static void save(Package &a_package, std::vector<uint8_t> &a_buffer);
+  static bool restore(Package &a_package, uint8_t const *const a_data, size_t const a_size);
+};
+
+} // namespace spaghetti
+
+#endif // SPAGHETTI_CHECKPOINT_H
@@ -0,0 +1,110 @@
+// MIT License
+//
+// Copyright (c) 2017-2018 Artur Wyszyński, aljen at hitomi dot pl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "spaghetti/dependency_graph.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace spaghetti {
+
+void DependencyGraph::add(size_t const a_from, size_t const a_to)
+{
+  assert(a_from < TOMBSTONE && a_to < TOMBSTONE);
+
+  m_added.emplace_back(static_cast<Id>(a_from), static_cast<Id>(a_to));
+  mergeIfNeeded();
+}
+
+void DependencyGraph::remove(size_t const a_from, size_t const a_to)
+{
+  Edge const EDGE{ static_cast<Id>(a_from), static_cast<Id>(a_to) };
+
+  auto const ADDED = std::find(std::begin(m_added), std::end(m_added), EDGE);
+  if (ADDED != std::end(m_added)) {
+    m_added.erase(ADDED);
+    return;
+  }
+
+  if (EDGE.first + size_t{ 1 } >= m_offsets.size()) return;
+
+  auto const BEGIN = std::begin(m_targets) + m_offsets[EDGE.first];
+  auto const END = std::begin(m_targets) + m_offsets[EDGE.first + 1];
+  auto const TARGET = std::find(BEGIN, END, EDGE.second);
+  if (TARGET == END) return;
+
+  *TARGET = TOMBSTONE;
+  m_tombstones++;
+  mergeIfNeeded();
+}
+
+void DependencyGraph::clear()
+{
+  m_offsets.clear();
+  m_targets.clear();
+  m_added.clear();
+  m_tombstones = 0;
+}
+
+void DependencyGraph::merge()
+{
+  if (m_added.empty() && m_tombstones == 0) return;
+
+  size_t rows{ m_offsets.empty() ? 0 : m_offsets.size() - 1 };
+  for (auto const &EDGE : m_added) rows = std::max<size_t>(rows, EDGE.first + size_t{ 1 });
+
+  // Counting sort by source, rows keep their previous order followed by the
+  // overlay in insertion order.
+  std::vector<Id> offsets(rows + 1, 0);
+  for (size_t row = 0; row + 1 < m_offsets.size(); ++row)
+    for (Id i = m_offsets[row]; i < m_offsets[row + 1]; ++i)
+      if (m_targets[i] != TOMBSTONE) offsets[row + 1]++;
+  for (auto const &EDGE : m_added) offsets[EDGE.first + 1]++;
+  for (size_t row = 0; row < rows; ++row) offsets[row + 1] += offsets[row];
+
+  std::vector<Id> targets(offsets.back());
+  std::vector<Id> cursor(std::begin(offsets), std::end(offsets) - 1);
+  for (size_t row = 0; row + 1 < m_offsets.size(); ++row)
+    for (Id i = m_offsets[row]; i < m_offsets[row + 1]; ++i)
+      if (m_targets[i] != TOMBSTONE) targets[cursor[row]++] = m_targets[i];
+  for (auto const &EDGE : m_added) targets[cursor[EDGE.first]++] = EDGE.second;
+
+  m_offsets = std::move(offsets);
+  m_targets = std::move(targets);
+  m_added.clear();
+  m_tombstones = 0;
+}
+
+std::vector<size_t> DependencyGraph::targets(size_t const a_from) const
+{
+  std::vector<size_t> targets{};
+  forEachTarget(a_from, [&targets](size_t const a_to) { targets.push_back(a_to); });
+  return targets;
+}
+
+void DependencyGraph::mergeIfNeeded()
+{
+  // Relative to the graph size so bulk edits stay amortized O(1) per edge.
+  if (overlay() > std::max(MERGE_THRESHOLD, m_targets.size() / 8)) merge();
+}
+
+} // namespace spaghetti
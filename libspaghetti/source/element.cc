@@ -25,22 +25,80 @@
 #include <cassert>
 #include <iostream>
 
+#include "element_arena.h"
+#include "journal.h"
 #include "spaghetti/package.h"
 
 namespace spaghetti {
 
+namespace {
+
+// Socket slots live in the package's value store, growing it has to wait
+// until the dispatch thread stops reading from it.
+class DispatchPause final {
+ public:
+  explicit DispatchPause(Package *const a_package)
+    : m_package{ a_package }
+  {
+    if (m_package) m_package->pauseDispatchThread();
+  }
+  ~DispatchPause()
+  {
+    if (m_package) m_package->resumeDispatchThread();
+  }
+
+ private:
+  Package *const m_package{};
+};
+
+} // namespace
+
+Element::EditorData *Element::createEditorData()
+{
+  if (void *const MEMORY{ ElementArena::takeEditorData() }) {
+    EditorData *const data{ new (MEMORY) EditorData{} };
+    data->inArena = true;
+    return data;
+  }
+
+  return new EditorData{};
+}
+
+void Element::EditorDataDeleter::operator()(EditorData *const a_data) const
+{
+  // Arena slots are handed back by Package::remove() or go away with the arena.
+  if (a_data->inArena)
+    a_data->~EditorData();
+  else
+    delete a_data;
+}
+
+Element::~Element()
+{
+  string::release(m_editor->name);
+  for (auto const &INPUT : m_inputs) string::release(INPUT.name);
+  for (auto const &OUTPUT : m_outputs) string::release(OUTPUT.name);
+
+  if (!m_values) return;
+
+  // Whoever destroys an element has unlinked its dependents, the slots only go back to the store.
+  for (auto const &INPUT : m_inputs)
+    if (!INPUT.linked) m_values->release(INPUT.type, INPUT.index);
+  for (auto const &OUTPUT : m_outputs) m_values->release(OUTPUT.type, OUTPUT.index);
+}
+
 void Element::serialize(Element::Json &a_json)
 {
   auto &jsonElement = a_json["element"];
   jsonElement["id"] = m_id;
-  jsonElement["name"] = m_name;
+  jsonElement["name"] = name();
   jsonElement["type"] = type();
-  jsonElement["min_inputs"] = m_minInputs;
-  jsonElement["max_inputs"] = m_maxInputs;
-  jsonElement["min_outputs"] = m_minOutputs;
-  jsonElement["max_outputs"] = m_maxOutputs;
-  jsonElement["default_new_input_flags"] = m_defaultNewInputFlags;
-  jsonElement["default_new_output_flags"] = m_defaultNewOutputFlags;
+  jsonElement["min_inputs"] = m_editor->minInputs;
+  jsonElement["max_inputs"] = m_editor->maxInputs;
+  jsonElement["min_outputs"] = m_editor->minOutputs;
+  jsonElement["max_outputs"] = m_editor->maxOutputs;
+  jsonElement["default_new_input_flags"] = m_editor->defaultNewInputFlags;
+  jsonElement["default_new_output_flags"] = m_editor->defaultNewOutputFlags;
 
   auto getSocketType = [](ValueType const a_type) {
     switch (a_type) {
@@ -58,7 +116,7 @@ void Element::serialize(Element::Json &a_json)
     Json socket{};
     socket["socket"] = i;
     socket["type"] = getSocketType(m_inputs[i].type);
-    socket["name"] = m_inputs[i].name;
+    socket["name"] = string::lookup(m_inputs[i].name);
     socket["flags"] = m_inputs[i].flags;
     jsonInputs.push_back(socket);
   }
@@ -69,7 +127,7 @@ void Element::serialize(Element::Json &a_json)
     Json socket{};
     socket["socket"] = i;
     socket["type"] = getSocketType(m_outputs[i].type);
-    socket["name"] = m_outputs[i].name;
+    socket["name"] = string::lookup(m_outputs[i].name);
     socket["flags"] = m_outputs[i].flags;
     jsonOutputs.push_back(socket);
   }
@@ -79,9 +137,9 @@ void Element::serialize(Element::Json &a_json)
   jsonIo["outputs"] = jsonOutputs;
 
   auto &jsonNode = a_json["node"];
-  jsonNode["position"]["x"] = m_position.x;
-  jsonNode["position"]["y"] = m_position.y;
-  jsonNode["iconify"] = m_isIconified;
+  jsonNode["position"]["x"] = m_editor->position.x;
+  jsonNode["position"]["y"] = m_editor->position.y;
+  jsonNode["iconify"] = m_editor->isIconified;
 }
 
 void Element::deserialize(Json const &a_json)
@@ -147,24 +205,51 @@ void Element::deserialize(Json const &a_json)
 
 void Element::setName(const std::string a_name)
 {
-  auto const OLD_NAME = m_name;
-  m_name = a_name;
+  Journal::Entry const JOURNAL{ *this };
+  if (JOURNAL) JOURNAL("name", { { "name", a_name } });
+
+  auto const OLD_NAME = m_editor->name;
+  m_editor->name = string::intern(a_name);
+
+  onEvent(NameChanged{ OLD_NAME, m_editor->name });
+
+  string::release(OLD_NAME);
+}
+
+void Element::setPosition(double const a_x, double const a_y)
+{
+  Journal::Entry const JOURNAL{ *this };
+  if (JOURNAL) JOURNAL("move", { { "x", a_x }, { "y", a_y } });
 
-  onEvent(NameChanged{ OLD_NAME, a_name });
+  m_editor->position.x = a_x;
+  m_editor->position.y = a_y;
+}
+
+void Element::iconify(bool const a_iconify)
+{
+  Journal::Entry const JOURNAL{ *this };
+  if (JOURNAL) JOURNAL("iconify", { { "iconify", a_iconify } });
+
+  m_editor->isIconified = a_iconify;
 }
 
 bool Element::addInput(Element::ValueType const a_type, std::string const a_name, uint8_t const a_flags)
 {
-  if (m_inputs.size() + 1 > m_maxInputs) return false;
+  Journal::Entry const JOURNAL{ *this };
+  DispatchPause const PAUSE{ m_editor->package };
+
+  if (m_inputs.size() + 1 > m_editor->maxInputs) return false;
 
   IOSocket input{};
-  input.name = a_name;
+  input.name = string::intern(a_name);
   input.type = a_type;
   input.flags = a_flags;
 
-  resetIOSocketValue(input);
+  input.index = m_values->allocate(a_type);
   m_inputs.emplace_back(input);
 
+  if (JOURNAL) JOURNAL("add_input", { { "type", static_cast<int>(a_type) }, { "name", a_name }, { "flags", a_flags } });
+
   onEvent(InputAdded{});
 
   return true;
@@ -172,14 +257,29 @@ bool Element::addInput(Element::ValueType const a_type, std::string const a_name
 
 void Element::setInputName(uint8_t const a_input, std::string const a_name)
 {
+  Journal::Entry const JOURNAL{ *this };
+  if (JOURNAL) JOURNAL("input_name", { { "socket", a_input }, { "name", a_name } });
+
   auto const OLD_NAME = m_inputs[a_input].name;
-  m_inputs[a_input].name = a_name;
+  m_inputs[a_input].name = string::intern(a_name);
+
+  onEvent(IONameChanged{ true, a_input, OLD_NAME, m_inputs[a_input].name });
 
-  onEvent(IONameChanged{ true, a_input, OLD_NAME, a_name });
+  string::release(OLD_NAME);
 }
 
 void Element::removeInput()
 {
+  Journal::Entry const JOURNAL{ *this };
+  if (JOURNAL) JOURNAL("remove_input");
+
+  DispatchPause const PAUSE{ m_editor->package };
+
+  size_t const LAST{ m_inputs.size() - 1 };
+  if (m_editor->package) m_editor->package->disconnectSockets(m_id, true, LAST, LAST + 1);
+
+  if (!m_inputs.back().linked) m_values->release(m_inputs.back().type, m_inputs.back().index);
+  string::release(m_inputs.back().name);
   m_inputs.pop_back();
 
   onEvent(InputRemoved{});
@@ -187,21 +287,38 @@ void Element::removeInput()
 
 void Element::clearInputs()
 {
+  Journal::Entry const JOURNAL{ *this };
+  if (JOURNAL) JOURNAL("clear_inputs");
+
+  DispatchPause const PAUSE{ m_editor->package };
+
+  if (m_editor->package) m_editor->package->disconnectSockets(m_id, true, 0, m_inputs.size());
+
+  for (auto const &INPUT : m_inputs) {
+    if (!INPUT.linked) m_values->release(INPUT.type, INPUT.index);
+    string::release(INPUT.name);
+  }
   m_inputs.clear();
 }
 
 bool Element::addOutput(Element::ValueType const a_type, std::string const a_name, uint8_t const a_flags)
 {
-  if (m_outputs.size() + 1 > m_maxOutputs) return false;
+  Journal::Entry const JOURNAL{ *this };
+  DispatchPause const PAUSE{ m_editor->package };
+
+  if (m_outputs.size() + 1 > m_editor->maxOutputs) return false;
 
   IOSocket output{};
-  output.name = a_name;
+  output.name = string::intern(a_name);
   output.type = a_type;
   output.flags = a_flags;
 
-  resetIOSocketValue(output);
+  output.index = m_values->allocate(a_type);
   m_outputs.emplace_back(output);
 
+  if (JOURNAL)
+    JOURNAL("add_output", { { "type", static_cast<int>(a_type) }, { "name", a_name }, { "flags", a_flags } });
+
   onEvent(OutputAdded{});
 
   return true;
@@ -209,14 +326,29 @@ bool Element::addOutput(Element::ValueType const a_type, std::string const a_nam
 
 void Element::setOutputName(uint8_t const a_output, std::string const a_name)
 {
+  Journal::Entry const JOURNAL{ *this };
+  if (JOURNAL) JOURNAL("output_name", { { "socket", a_output }, { "name", a_name } });
+
   auto const OLD_NAME = m_outputs[a_output].name;
-  m_outputs[a_output].name = a_name;
+  m_outputs[a_output].name = string::intern(a_name);
+
+  onEvent(IONameChanged{ false, a_output, OLD_NAME, m_outputs[a_output].name });
 
-  onEvent(IONameChanged{ false, a_output, OLD_NAME, a_name });
+  string::release(OLD_NAME);
 }
 
 void Element::removeOutput()
 {
+  Journal::Entry const JOURNAL{ *this };
+  if (JOURNAL) JOURNAL("remove_output");
+
+  DispatchPause const PAUSE{ m_editor->package };
+
+  size_t const LAST{ m_outputs.size() - 1 };
+  if (m_editor->package) m_editor->package->disconnectSockets(m_id, false, LAST, LAST + 1);
+
+  m_values->release(m_outputs.back().type, m_outputs.back().index);
+  string::release(m_outputs.back().name);
   m_outputs.pop_back();
 
   onEvent(OutputRemoved{});
@@ -224,55 +356,104 @@ void Element::removeOutput()
 
 void Element::clearOutputs()
 {
+  Journal::Entry const JOURNAL{ *this };
+  if (JOURNAL) JOURNAL("clear_outputs");
+
+  DispatchPause const PAUSE{ m_editor->package };
+
+  if (m_editor->package) m_editor->package->disconnectSockets(m_id, false, 0, m_outputs.size());
+
+  for (auto const &OUTPUT : m_outputs) {
+    m_values->release(OUTPUT.type, OUTPUT.index);
+    string::release(OUTPUT.name);
+  }
   m_outputs.clear();
 }
 
 void Element::setIOValueType(bool const a_input, uint8_t const a_id, ValueType const a_type)
 {
+  Journal::Entry const JOURNAL{ *this };
+  if (JOURNAL) JOURNAL("io_type", { { "input", a_input }, { "socket", a_id }, { "type", static_cast<int>(a_type) } });
+
+  DispatchPause const PAUSE{ m_editor->package };
+
+  // Connections only join sockets of one type.
+  if (m_editor->package) m_editor->package->disconnectSockets(m_id, a_input, a_id, a_id + 1);
+
   auto &io = a_input ? m_inputs[a_id] : m_outputs[a_id];
   auto const OLD_TYPE = io.type;
+  if (!io.linked) m_values->release(OLD_TYPE, io.index);
   io.type = a_type;
-  resetIOSocketValue(io);
+  io.index = m_values->allocate(a_type);
+  io.linked = false;
 
   onEvent(IOTypeChanged{ a_input, a_id, OLD_TYPE, a_type });
 }
 
 bool Element::connect(size_t const a_sourceId, uint8_t const a_outputId, uint8_t const a_inputId)
 {
-  return m_package->connect(a_sourceId, a_outputId, m_id, a_inputId);
+  return m_editor->package->connect(a_sourceId, a_outputId, m_id, a_inputId);
 }
 
 void Element::resetIOSocketValue(IOSocket &a_io)
 {
-  switch (a_io.type) {
-    case ValueType::eBool: a_io.value = false; break;
-    case ValueType::eInt: a_io.value = 0; break;
-    case ValueType::eFloat: a_io.value = 0.0f; break;
-  }
+  m_values->reset(a_io.type, a_io.index);
+}
+
+void Element::bindValueStore(ValueStore *const a_values)
+{
+  if (a_values == m_values) return;
+
+  auto rebind = [&](IOSocket &a_io) {
+    assert(!a_io.linked);
+    auto const INDEX = a_values->allocate(a_io.type);
+    switch (a_io.type) {
+      case ValueType::eBool: a_values->set(INDEX, m_values->get<bool>(a_io.index)); break;
+      case ValueType::eInt: a_values->set(INDEX, m_values->get<int32_t>(a_io.index)); break;
+      case ValueType::eFloat: a_values->set(INDEX, m_values->get<float>(a_io.index)); break;
+    }
+    m_values->release(a_io.type, a_io.index);
+    a_io.index = INDEX;
+  };
+
+  for (auto &&input : m_inputs) rebind(input);
+  for (auto &&output : m_outputs) rebind(output);
+
+  m_values = a_values;
+}
+
+void Element::propertiesChanged()
+{
+  Journal::Entry const JOURNAL{ *this };
+  if (!JOURNAL) return;
+
+  Json json{};
+  serialize(json);
+  JOURNAL("properties", { { "properties", json["properties"] } });
 }
 
 void Element::setMinInputs(uint8_t const a_min)
 {
-  if (a_min > m_maxInputs) return;
-  m_minInputs = a_min;
+  if (a_min > m_editor->maxInputs) return;
+  m_editor->minInputs = a_min;
 }
 
 void Element::setMaxInputs(uint8_t const a_max)
 {
-  if (a_max < m_minInputs) return;
-  m_maxInputs = a_max;
+  if (a_max < m_editor->minInputs) return;
+  m_editor->maxInputs = a_max;
 }
 
 void Element::setMinOutputs(uint8_t const a_min)
 {
-  if (a_min > m_maxOutputs) return;
-  m_minOutputs = a_min;
+  if (a_min > m_editor->maxOutputs) return;
+  m_editor->minOutputs = a_min;
 }
 
 void Element::setMaxOutputs(uint8_t const a_max)
 {
-  if (a_max < m_minOutputs) return;
-  m_maxOutputs = a_max;
+  if (a_max < m_editor->minOutputs) return;
+  m_editor->maxOutputs = a_max;
 }
 
 } // namespace spaghetti
@@ -0,0 +1,113 @@
+// MIT License
+//
+// Copyright (c) 2017-2018 Artur Wyszyński, aljen at hitomi dot pl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "element_arena.h"
+
+#include <algorithm>
+#include <cassert>
+#include <utility>
+
+#include "spaghetti/element.h"
+
+namespace spaghetti {
+
+namespace {
+
+thread_local void *t_editorData{};
+
+} // namespace
+
+void *ElementArena::allocate(string::hash_t const a_type, size_t const a_size)
+{
+  std::lock_guard<std::mutex> lock{ m_mutex };
+
+  auto &pool = m_pools[a_type];
+
+  if (pool.size == 0) {
+    pool.size = (a_size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+    pool.perSlab = std::max<size_t>(1, SLAB_SIZE / pool.size);
+    pool.used = pool.perSlab;
+  }
+  assert(a_size <= pool.size);
+
+  if (!pool.free.empty()) {
+    void *const MEMORY{ pool.free.back() };
+    pool.free.pop_back();
+    return MEMORY;
+  }
+
+  if (pool.used == pool.perSlab) {
+    pool.slabs.emplace_back(new std::byte[pool.size * pool.perSlab]);
+    pool.used = 0;
+  }
+
+  return pool.slabs.back().get() + pool.size * pool.used++;
+}
+
+void ElementArena::deallocate(string::hash_t const a_type, void *const a_memory)
+{
+  std::lock_guard<std::mutex> lock{ m_mutex };
+
+  auto const IT = m_pools.find(a_type);
+  assert(IT != std::end(m_pools));
+  IT->second.free.push_back(a_memory);
+}
+
+void ElementArena::prepareEditorData()
+{
+  assert(!t_editorData);
+  t_editorData = allocate(EDITOR_DATA, sizeof(Element::EditorData));
+}
+
+void *ElementArena::takeEditorData()
+{
+  return std::exchange(t_editorData, nullptr);
+}
+
+void ElementArena::discardEditorData()
+{
+  if (void *const MEMORY{ takeEditorData() }) deallocate(EDITOR_DATA, MEMORY);
+}
+
+size_t ElementArena::slabs() const
+{
+  std::lock_guard<std::mutex> lock{ m_mutex };
+
+  size_t count{};
+  for (auto const &POOL : m_pools) count += POOL.second.slabs.size();
+  return count;
+}
+
+size_t ElementArena::memoryUsage() const
+{
+  std::lock_guard<std::mutex> lock{ m_mutex };
+
+  size_t bytes{};
+  for (auto const &POOL : m_pools) {
+    auto const &INFO = POOL.second;
+    bytes += sizeof(POOL) + INFO.slabs.size() * INFO.perSlab * INFO.size;
+    bytes += INFO.slabs.capacity() * sizeof(INFO.slabs[0]) + INFO.free.capacity() * sizeof(void *);
+  }
+  return bytes;
+}
+
+} // namespace spaghetti
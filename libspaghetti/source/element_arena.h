@@ -0,0 +1,80 @@
+// MIT License
+//
+// Copyright (c) 2017-2018 Artur Wyszyński, aljen at hitomi dot pl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+#ifndef SPAGHETTI_ELEMENT_ARENA_H
+#define SPAGHETTI_ELEMENT_ARENA_H
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "spaghetti/strings.h"
+
+namespace spaghetti {
+
+// Per-package storage for elements, every element type gets its own slabs so
+// elements of the same type sit next to each other. Memory is only returned
+// to the system when the arena goes away, one slab at a time. Safe to use
+// from the worker threads of a parallel load.
+class ElementArena final {
+ public:
+  static constexpr size_t const SLAB_SIZE{ 64 * 1024 };
+  static constexpr size_t const ALIGNMENT{ __STDCPP_DEFAULT_NEW_ALIGNMENT__ };
+
+  ElementArena() = default;
+  ElementArena(ElementArena const &) = delete;
+  ElementArena &operator=(ElementArena const &) = delete;
+
+  void *allocate(string::hash_t const a_type, size_t const a_size);
+  void deallocate(string::hash_t const a_type, void *const a_memory);
+
+  // Editor data of the elements placed here gets slabs of its own, apart from
+  // the elements the dispatch loop walks. prepareEditorData() sets a slot aside
+  // for the next element constructed on the calling thread, which takes it.
+  static constexpr string::hash_t const EDITOR_DATA{ string::hash("spaghetti/editor_data") };
+  void prepareEditorData();
+  static void *takeEditorData();
+  // Hands back a slot prepareEditorData() set aside that no element took.
+  void discardEditorData();
+
+  size_t slabs() const;
+  size_t memoryUsage() const;
+
+ private:
+  struct Pool {
+    size_t size{};
+    size_t perSlab{};
+    size_t used{};
+    std::vector<std::unique_ptr<std::byte[]>> slabs{};
+    std::vector<void *> free{};
+  };
+
+  mutable std::mutex m_mutex{};
+  std::unordered_map<string::hash_t, Pool> m_pools{};
+};
+
+} // namespace spaghetti
+
+#endif // SPAGHETTI_ELEMENT_ARENA_H
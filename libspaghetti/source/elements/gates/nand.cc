@@ -43,14 +43,14 @@ void Nand::calculate()
 {
   bool allSets{ true };
   for (auto &input : m_inputs) {
-    bool const VALUE{ std::get<bool>(input.value) };
+    bool const VALUE{ value<bool>(input) };
     if (!VALUE) {
       allSets = false;
       break;
     }
   }
 
-  m_outputs[0].value = !allSets;
+  setValue(m_outputs[0], !allSets);
 }
 
 } // namespace spaghetti::elements::gates
@@ -39,7 +39,7 @@ Not::Not()
 
 void Not::calculate()
 {
-  m_outputs[0].value = !std::get<bool>(m_inputs[0].value);
+  setValue(m_outputs[0], !value<bool>(m_inputs[0]));
 }
 
 } // namespace spaghetti::elements::gates
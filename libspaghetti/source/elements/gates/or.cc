@@ -43,12 +43,12 @@ void Or::calculate()
 {
   bool somethingSet{ false };
   for (auto &input : m_inputs) {
-    bool const VALUE{ std::get<bool>(input.value) };
+    bool const VALUE{ value<bool>(input) };
     somethingSet |= VALUE;
     if (VALUE) break;
   }
 
-  m_outputs[0].value = somethingSet;
+  setValue(m_outputs[0], somethingSet);
 }
 
 } // namespace spaghetti::elements::gates
@@ -40,37 +40,37 @@ Blinker::Blinker()
 
 void Blinker::update(duration_t const &a_delta)
 {
-  if (m_enabled) {
-    m_time += a_delta;
+  if (m_state.enabled) {
+    m_state.time += a_delta;
 
-    auto const RATE = m_state ? m_highRate : m_lowRate;
-    if (m_time >= RATE) {
-      m_time = duration_t{};
-      m_state = !m_state;
-      m_outputs[0].value = m_state;
+    auto const RATE = m_state.high ? m_state.highRate : m_state.lowRate;
+    if (m_state.time >= RATE) {
+      m_state.time = duration_t{};
+      m_state.high = !m_state.high;
+      setValue(m_outputs[0], m_state.high);
     }
   }
 }
 
 void Blinker::calculate()
 {
-  bool const ENABLED = std::get<bool>(m_inputs[0].value);
-  duration_t const HIGH_RATE = duration_t{ std::get<int>(m_inputs[1].value) };
-  duration_t const LOW_RATE = duration_t{ std::get<int>(m_inputs[2].value) };
+  bool const ENABLED = value<bool>(m_inputs[0]);
+  duration_t const HIGH_RATE = duration_t{ value<int32_t>(m_inputs[1]) };
+  duration_t const LOW_RATE = duration_t{ value<int32_t>(m_inputs[2]) };
 
   bool changed{};
-  changed |= ENABLED != m_enabled;
-  changed |= HIGH_RATE != m_highRate;
-  changed |= LOW_RATE != m_lowRate;
+  changed |= ENABLED != m_state.enabled;
+  changed |= HIGH_RATE != m_state.highRate;
+  changed |= LOW_RATE != m_state.lowRate;
 
-  m_enabled = ENABLED;
-  m_highRate = HIGH_RATE;
-  m_lowRate = LOW_RATE;
+  m_state.enabled = ENABLED;
+  m_state.highRate = HIGH_RATE;
+  m_state.lowRate = LOW_RATE;
 
   if (changed) {
-    m_time = duration_t{};
-    m_state = false;
-    m_outputs[0].value = m_state;
+    m_state.time = duration_t{};
+    m_state.high = false;
+    setValue(m_outputs[0], m_state.high);
   }
 }
 
@@ -42,12 +42,17 @@ class Blinker final : public Element {
 
   void calculate() override;
 
+  RuntimeState runtimeState() override { return { &m_state, sizeof(m_state) }; }
+
  private:
-  bool m_enabled{};
-  bool m_state{};
-  duration_t m_highRate{};
-  duration_t m_lowRate{};
-  duration_t m_time{};
+  struct State {
+    bool enabled{};
+    bool high{};
+    duration_t highRate{};
+    duration_t lowRate{};
+    duration_t time{};
+  };
+  State m_state{};
 };
 
 } // namespace spaghetti::elements::logic
@@ -51,12 +51,23 @@ void Clock::deserialize(const Json &a_json)
   m_duration = duration_t{ PROPERTIES["duration"].get<double>() };
 }
 
+void Clock::setProperties(Json const &a_properties)
+{
+  setDuration(duration_t{ a_properties["duration"].get<double>() });
+}
+
+void Clock::setDuration(duration_t a_duration)
+{
+  m_duration = a_duration;
+  propertiesChanged();
+}
+
 void Clock::update(duration_t const &a_delta)
 {
   m_time += a_delta;
   if (m_time >= m_duration) {
-    bool const VALUE = !std::get<bool>(m_outputs[0].value);
-    m_outputs[0].value = VALUE;
+    bool const VALUE = !value<bool>(m_outputs[0]);
+    setValue(m_outputs[0], VALUE);
     reset();
   }
 }
@@ -42,11 +42,13 @@ class Clock final : public Element {
 
   void serialize(Json &a_json) override;
   void deserialize(Json const &a_json) override;
+  void setProperties(Json const &a_properties) override;
 
   void reset() override { m_time = duration_t{ 0.0 }; }
   void update(duration_t const &a_delta) override;
+  RuntimeState runtimeState() override { return { &m_time, sizeof(m_time) }; }
 
-  void setDuration(duration_t a_duration) { m_duration = a_duration; }
+  void setDuration(duration_t a_duration);
 
   duration_t duration() const { return m_duration; }
 
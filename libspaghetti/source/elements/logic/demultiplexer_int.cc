@@ -43,12 +43,12 @@ DemultiplexerInt::DemultiplexerInt()
 
 void DemultiplexerInt::calculate()
 {
-  int32_t const SELECT{ std::get<int32_t>(m_inputs[0].value) };
-  int32_t const VALUE{ std::get<int32_t>(m_inputs[1].value) };
+  int32_t const SELECT{ value<int32_t>(m_inputs[0]) };
+  int32_t const VALUE{ value<int32_t>(m_inputs[1]) };
   int32_t const SIZE{ static_cast<int32_t>(m_outputs.size()) - 1 };
   int32_t const INDEX{ std::clamp<int32_t>(SELECT, 0, SIZE) };
 
-  m_outputs[static_cast<size_t>(INDEX)].value = VALUE;
+  setValue(m_outputs[static_cast<size_t>(INDEX)], VALUE);
 }
 
 } // namespace spaghetti::elements::logic
@@ -41,10 +41,10 @@ IfEqual::IfEqual()
 
 void IfEqual::calculate()
 {
-  float const A{ std::get<float>(m_inputs[0].value) };
-  float const B{ std::get<float>(m_inputs[1].value) };
+  float const A{ value<float>(m_inputs[0]) };
+  float const B{ value<float>(m_inputs[1]) };
 
-  m_outputs[0].value = spaghetti::nearly_equal(A, B);
+  setValue(m_outputs[0], spaghetti::nearly_equal(A, B));
 }
 
 } // namespace spaghetti::elements::logic
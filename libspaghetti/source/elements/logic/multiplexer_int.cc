@@ -43,12 +43,12 @@ MultiplexerInt::MultiplexerInt()
 
 void MultiplexerInt::calculate()
 {
-  int32_t const SELECT{ std::get<int32_t>(m_inputs[0].value) };
+  int32_t const SELECT{ value<int32_t>(m_inputs[0]) };
   int32_t const SIZE{ static_cast<int32_t>(m_inputs.size()) - 2 };
   int32_t const INDEX{ std::clamp<int32_t>(SELECT, 0, SIZE) };
-  int32_t const VALUE{ std::get<int32_t>(m_inputs[static_cast<size_t>(INDEX) + 1].value) };
+  int32_t const VALUE{ value<int32_t>(m_inputs[static_cast<size_t>(INDEX) + 1]) };
 
-  m_outputs[0].value = VALUE;
+  setValue(m_outputs[0], VALUE);
 }
 
 } // namespace spaghetti::elements::logic
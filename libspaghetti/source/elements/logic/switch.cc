@@ -38,12 +38,12 @@ Switch::Switch()
 
 void Switch::toggle()
 {
-  m_outputs[0].value = !std::get<bool>(m_outputs[0].value);
+  setValue(m_outputs[0], !value<bool>(m_outputs[0]));
 }
 
 void Switch::set(bool a_state)
 {
-  m_outputs[0].value = a_state;
+  setValue(m_outputs[0], a_state);
 }
 
 } // namespace spaghetti::elements::logic
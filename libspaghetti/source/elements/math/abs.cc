@@ -39,10 +39,10 @@ Abs::Abs()
 
 void Abs::calculate()
 {
-  float const VALUE{ std::get<float>(m_inputs[0].value) };
+  float const VALUE{ value<float>(m_inputs[0]) };
   float const ABS{ std::abs(VALUE) };
 
-  m_outputs[0].value = ABS;
+  setValue(m_outputs[0], ABS);
 }
 
 } // namespace spaghetti::elements::math
@@ -42,9 +42,9 @@ Add::Add()
 void Add::calculate()
 {
   float sum{};
-  for (auto &&input : m_inputs) sum += std::get<float>(input.value);
+  for (auto &&input : m_inputs) sum += value<float>(input);
 
-  m_outputs[0].value = sum;
+  setValue(m_outputs[0], sum);
 }
 
 } // namespace spaghetti::elements::math
@@ -42,12 +42,12 @@ BCD::BCD()
 
 void BCD::calculate()
 {
-  int32_t const VALUE{ std::get<int32_t>(m_inputs[0].value) };
+  int32_t const VALUE{ value<int32_t>(m_inputs[0]) };
 
-  m_outputs[0].value = static_cast<bool>(VALUE & (1 << 0));
-  m_outputs[1].value = static_cast<bool>(VALUE & (1 << 1));
-  m_outputs[2].value = static_cast<bool>(VALUE & (1 << 2));
-  m_outputs[3].value = static_cast<bool>(VALUE & (1 << 3));
+  setValue(m_outputs[0], static_cast<bool>(VALUE & (1 << 0)));
+  setValue(m_outputs[1], static_cast<bool>(VALUE & (1 << 1)));
+  setValue(m_outputs[2], static_cast<bool>(VALUE & (1 << 2)));
+  setValue(m_outputs[3], static_cast<bool>(VALUE & (1 << 3)));
 }
 
 } // namespace spaghetti::elements::math
@@ -39,10 +39,10 @@ Cos::Cos()
 
 void Cos::calculate()
 {
-  float const ANGLE{ std::get<float>(m_inputs[0].value) };
+  float const ANGLE{ value<float>(m_inputs[0]) };
   float const COS{ std::cos(ANGLE) };
 
-  m_outputs[0].value = COS;
+  setValue(m_outputs[0], COS);
 }
 
 } // namespace spaghetti::elements::math
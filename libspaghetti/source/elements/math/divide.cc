@@ -41,15 +41,15 @@ Divide::Divide()
 
 void Divide::calculate()
 {
-  float output{ std::get<float>(m_inputs[0].value) };
+  float output{ value<float>(m_inputs[0]) };
   if (output == 0.0f) {
-    m_outputs[0].value = 0.0f;
+    setValue(m_outputs[0], 0.0f);
     return;
   }
 
   size_t const SIZE{ m_inputs.size() };
   for (size_t i = 1; i < SIZE; ++i) {
-    float const VALUE{ std::get<float>(m_inputs[i].value) };
+    float const VALUE{ value<float>(m_inputs[i]) };
     if (VALUE == 0.0f) {
       output = 0.0f;
       break;
@@ -57,7 +57,7 @@ void Divide::calculate()
     output /= VALUE;
   }
 
-  m_outputs[0].value = output;
+  setValue(m_outputs[0], output);
 }
 
 } // namespace spaghetti::elements::math
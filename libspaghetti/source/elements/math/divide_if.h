@@ -39,6 +39,7 @@ class DivideIf final : public Element {
   string::hash_t hash() const noexcept override { return HASH; }
 
   void calculate() override;
+  RuntimeState runtimeState() override { return { &m_enabled, sizeof(m_enabled) }; }
 
  private:
   bool m_enabled{};
@@ -41,15 +41,15 @@ Multiply::Multiply()
 
 void Multiply::calculate()
 {
-  float output{ std::get<float>(m_inputs[0].value) };
+  float output{ value<float>(m_inputs[0]) };
 
   size_t const SIZE{ m_inputs.size() };
   for (size_t i = 1; i < SIZE; ++i) {
-    float const VALUE{ std::get<float>(m_inputs[i].value) };
+    float const VALUE{ value<float>(m_inputs[i]) };
     output *= VALUE;
   }
 
-  m_outputs[0].value = output;
+  setValue(m_outputs[0], output);
 }
 
 } // namespace spaghetti::elements::math
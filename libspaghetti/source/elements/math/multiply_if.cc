@@ -42,10 +42,10 @@ MultiplyIf::MultiplyIf()
 
 void MultiplyIf::calculate()
 {
-  bool const ENABLED{ std::get<bool>(m_inputs[0].value) };
+  bool const ENABLED{ value<bool>(m_inputs[0]) };
 
   if (ENABLED != m_enabled && !ENABLED) {
-    m_outputs[0].value = 0.0f;
+    setValue(m_outputs[0], 0.0f);
     return;
   }
 
@@ -53,15 +53,15 @@ void MultiplyIf::calculate()
 
   if (!m_enabled) return;
 
-  float output{ std::get<float>(m_inputs[1].value) };
+  float output{ value<float>(m_inputs[1]) };
 
   size_t const SIZE{ m_inputs.size() };
   for (size_t i = 2; i < SIZE; ++i) {
-    float const VALUE{ std::get<float>(m_inputs[i].value) };
+    float const VALUE{ value<float>(m_inputs[i]) };
     output *= VALUE;
   }
 
-  m_outputs[0].value = output;
+  setValue(m_outputs[0], output);
 }
 
 } // namespace spaghetti::elements::math
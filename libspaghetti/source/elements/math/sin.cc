@@ -39,10 +39,10 @@ Sin::Sin()
 
 void Sin::calculate()
 {
-  float const ANGLE{ std::get<float>(m_inputs[0].value) };
+  float const ANGLE{ value<float>(m_inputs[0]) };
   float const SIN{ std::sin(ANGLE) };
 
-  m_outputs[0].value = SIN;
+  setValue(m_outputs[0], SIN);
 }
 
 } // namespace spaghetti::elements::math
@@ -41,11 +41,11 @@ Subtract::Subtract()
 
 void Subtract::calculate()
 {
-  float ret{ std::get<float>(m_inputs[0].value) };
+  float ret{ value<float>(m_inputs[0]) };
   size_t const SIZE{ m_inputs.size() };
-  for (size_t i = 1; i < SIZE; ++i) ret -= std::get<float>(m_inputs[i].value);
+  for (size_t i = 1; i < SIZE; ++i) ret -= value<float>(m_inputs[i]);
 
-  m_outputs[0].value = ret;
+  setValue(m_outputs[0], ret);
 }
 
 } // namespace spaghetti::elements::math
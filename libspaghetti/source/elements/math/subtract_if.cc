@@ -42,10 +42,10 @@ SubtractIf::SubtractIf()
 
 void SubtractIf::calculate()
 {
-  bool const ENABLED{ std::get<bool>(m_inputs[0].value) };
+  bool const ENABLED{ value<bool>(m_inputs[0]) };
 
   if (ENABLED != m_enabled && !ENABLED) {
-    m_outputs[0].value = 0.0f;
+    setValue(m_outputs[0], 0.0f);
     return;
   }
 
@@ -53,11 +53,11 @@ void SubtractIf::calculate()
 
   if (!m_enabled) return;
 
-  float ret{ std::get<float>(m_inputs[1].value) };
+  float ret{ value<float>(m_inputs[1]) };
   size_t const SIZE{ m_inputs.size() };
-  for (size_t i = 2; i < SIZE; ++i) ret -= std::get<float>(m_inputs[i].value);
+  for (size_t i = 2; i < SIZE; ++i) ret -= value<float>(m_inputs[i]);
 
-  m_outputs[0].value = ret;
+  setValue(m_outputs[0], ret);
 }
 
 } // namespace spaghetti::elements::math
@@ -47,10 +47,10 @@ BCDToSevenSegmentDisplay::BCDToSevenSegmentDisplay()
 
 void BCDToSevenSegmentDisplay::calculate()
 {
-  int32_t const A{ static_cast<int32_t>(std::get<bool>(m_inputs[0].value)) };
-  int32_t const B{ static_cast<int32_t>(std::get<bool>(m_inputs[1].value)) };
-  int32_t const C{ static_cast<int32_t>(std::get<bool>(m_inputs[2].value)) };
-  int32_t const D{ static_cast<int32_t>(std::get<bool>(m_inputs[3].value)) };
+  int32_t const A{ static_cast<int32_t>(value<bool>(m_inputs[0])) };
+  int32_t const B{ static_cast<int32_t>(value<bool>(m_inputs[1])) };
+  int32_t const C{ static_cast<int32_t>(value<bool>(m_inputs[2])) };
+  int32_t const D{ static_cast<int32_t>(value<bool>(m_inputs[3])) };
 
   int32_t const VALUE{ (D << 3) | (C << 2) | (B << 1) | A };
 
@@ -72,13 +72,13 @@ void BCDToSevenSegmentDisplay::calculate()
 void BCDToSevenSegmentDisplay::setOutputs(bool const a_A, bool const a_B, bool const a_C, bool const a_D,
                                           bool const a_E, bool const a_F, bool const a_G)
 {
-  m_outputs[0].value = a_A;
-  m_outputs[1].value = a_B;
-  m_outputs[2].value = a_C;
-  m_outputs[3].value = a_D;
-  m_outputs[4].value = a_E;
-  m_outputs[5].value = a_F;
-  m_outputs[6].value = a_G;
+  setValue(m_outputs[0], a_A);
+  setValue(m_outputs[1], a_B);
+  setValue(m_outputs[2], a_C);
+  setValue(m_outputs[3], a_D);
+  setValue(m_outputs[4], a_E);
+  setValue(m_outputs[5], a_F);
+  setValue(m_outputs[6], a_G);
 }
 
 } // namespace spaghetti::elements::ui
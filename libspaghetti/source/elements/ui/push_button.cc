@@ -37,13 +37,13 @@ PushButton::PushButton()
 void PushButton::toggle()
 {
   m_currentValue = !m_currentValue;
-  m_outputs[0].value = m_currentValue;
+  setValue(m_outputs[0], m_currentValue);
 }
 
 void PushButton::set(bool a_state)
 {
   m_currentValue = a_state;
-  m_outputs[0].value = m_currentValue;
+  setValue(m_outputs[0], m_currentValue);
 }
 
 } // namespace spaghetti::elements::ui
@@ -38,6 +38,8 @@ class PushButton final : public Element {
   char const *type() const noexcept override { return TYPE; }
   string::hash_t hash() const noexcept override { return HASH; }
 
+  RuntimeState runtimeState() override { return { &m_currentValue, sizeof(m_currentValue) }; }
+
   void toggle();
   void set(bool a_state);
 
@@ -37,13 +37,13 @@ ToggleButton::ToggleButton()
 void ToggleButton::toggle()
 {
   m_currentValue = !m_currentValue;
-  m_outputs[0].value = m_currentValue;
+  setValue(m_outputs[0], m_currentValue);
 }
 
 void ToggleButton::set(bool a_state)
 {
   m_currentValue = a_state;
-  m_outputs[0].value = m_currentValue;
+  setValue(m_outputs[0], m_currentValue);
 }
 
 } // namespace spaghetti::elements::ui
@@ -42,11 +42,11 @@ ClampFloat::ClampFloat()
 
 void ClampFloat::calculate()
 {
-  float const MINIMUM{ std::get<float>(m_inputs[0].value) };
-  float const MAXIMUM{ std::get<float>(m_inputs[1].value) };
-  float const VALUE{ std::get<float>(m_inputs[2].value) };
+  float const MINIMUM{ value<float>(m_inputs[0]) };
+  float const MAXIMUM{ value<float>(m_inputs[1]) };
+  float const VALUE{ value<float>(m_inputs[2]) };
 
-  m_outputs[0].value = std::clamp(VALUE, MINIMUM, MAXIMUM);
+  setValue(m_outputs[0], std::clamp(VALUE, MINIMUM, MAXIMUM));
 }
 
 } // namespace spaghetti::elements::values
@@ -42,11 +42,11 @@ ClampInt::ClampInt()
 
 void ClampInt::calculate()
 {
-  int32_t const MINIMUM{ std::get<int32_t>(m_inputs[0].value) };
-  int32_t const MAXIMUM{ std::get<int32_t>(m_inputs[1].value) };
-  int32_t const VALUE{ std::get<int32_t>(m_inputs[2].value) };
+  int32_t const MINIMUM{ value<int32_t>(m_inputs[0]) };
+  int32_t const MAXIMUM{ value<int32_t>(m_inputs[1]) };
+  int32_t const VALUE{ value<int32_t>(m_inputs[2]) };
 
-  m_outputs[0].value = std::clamp(VALUE, MINIMUM, MAXIMUM);
+  setValue(m_outputs[0], std::clamp(VALUE, MINIMUM, MAXIMUM));
 }
 
 } // namespace spaghetti::elements::values
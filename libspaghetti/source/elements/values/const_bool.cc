@@ -49,19 +49,26 @@ void ConstBool::deserialize(const Json &a_json)
   auto const &PROPERTIES = a_json["properties"];
   m_currentValue = PROPERTIES["value"].get<bool>();
 
-  m_outputs[0].value = m_currentValue;
+  setValue(m_outputs[0], m_currentValue);
+}
+
+void ConstBool::setProperties(Json const &a_properties)
+{
+  set(a_properties["value"].get<bool>());
 }
 
 void ConstBool::toggle()
 {
   m_currentValue = !m_currentValue;
-  m_outputs[0].value = m_currentValue;
+  setValue(m_outputs[0], m_currentValue);
+  propertiesChanged();
 }
 
 void ConstBool::set(bool a_state)
 {
   m_currentValue = a_state;
-  m_outputs[0].value = m_currentValue;
+  setValue(m_outputs[0], m_currentValue);
+  propertiesChanged();
 }
 
 } // namespace spaghetti::elements::values
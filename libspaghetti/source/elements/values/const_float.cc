@@ -49,13 +49,19 @@ void ConstFloat::deserialize(const Json &a_json)
   auto const &PROPERTIES = a_json["properties"];
   m_currentValue = PROPERTIES["value"].get<float>();
 
-  m_outputs[0].value = m_currentValue;
+  setValue(m_outputs[0], m_currentValue);
+}
+
+void ConstFloat::setProperties(Json const &a_properties)
+{
+  set(a_properties["value"].get<float>());
 }
 
 void ConstFloat::set(float a_value)
 {
   m_currentValue = a_value;
-  m_outputs[0].value = m_currentValue;
+  setValue(m_outputs[0], m_currentValue);
+  propertiesChanged();
 }
 
 } // namespace spaghetti::elements::values
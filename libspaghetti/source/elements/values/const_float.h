@@ -40,6 +40,7 @@ class ConstFloat final : public Element {
 
   void serialize(Json &a_json) override;
   void deserialize(Json const &a_json) override;
+  void setProperties(Json const &a_properties) override;
 
   void set(float a_value);
 
@@ -49,13 +49,19 @@ void ConstInt::deserialize(const Json &a_json)
   auto const &PROPERTIES = a_json["properties"];
   m_currentValue = PROPERTIES["value"].get<int32_t>();
 
-  m_outputs[0].value = m_currentValue;
+  setValue(m_outputs[0], m_currentValue);
+}
+
+void ConstInt::setProperties(Json const &a_properties)
+{
+  set(a_properties["value"].get<int32_t>());
 }
 
 void ConstInt::set(int32_t a_value)
 {
   m_currentValue = a_value;
-  m_outputs[0].value = m_currentValue;
+  setValue(m_outputs[0], m_currentValue);
+  propertiesChanged();
 }
 
 } // namespace spaghetti::elements::values
@@ -39,10 +39,10 @@ MaxInt::MaxInt()
 
 void MaxInt::calculate()
 {
-  int32_t const A{ std::get<int32_t>(m_inputs[0].value) };
-  int32_t const B{ std::get<int32_t>(m_inputs[1].value) };
+  int32_t const A{ value<int32_t>(m_inputs[0]) };
+  int32_t const B{ value<int32_t>(m_inputs[1]) };
 
-  m_outputs[0].value = std::max(A, B);
+  setValue(m_outputs[0], std::max(A, B));
 }
 
 } // namespace spaghetti::elements::values
@@ -39,10 +39,10 @@ MinFloat::MinFloat()
 
 void MinFloat::calculate()
 {
-  float const A{ std::get<float>(m_inputs[0].value) };
-  float const B{ std::get<float>(m_inputs[1].value) };
+  float const A{ value<float>(m_inputs[0]) };
+  float const B{ value<float>(m_inputs[1]) };
 
-  m_outputs[0].value = std::min(A, B);
+  setValue(m_outputs[0], std::min(A, B));
 }
 
 } // namespace spaghetti::elements::values
@@ -39,9 +39,9 @@ Radian2Degree::Radian2Degree()
 
 void Radian2Degree::calculate()
 {
-  float const RADIAN{ std::get<float>(m_inputs[0].value) };
+  float const RADIAN{ value<float>(m_inputs[0]) };
 
-  m_outputs[0].value = RADIAN * spaghetti::RAD2DEG;
+  setValue(m_outputs[0], RADIAN * spaghetti::RAD2DEG);
 }
 
 } // namespace spaghetti::elements::values
@@ -20,14 +20,26 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 // SOFTWARE.
 
+#include <atomic>
 #include <random>
 
 #include "elements/values/random_bool.h"
 
 namespace {
-std::random_device g_random{};
-std::mt19937 g_generator{ g_random() };
-std::bernoulli_distribution g_distrib(0.5);
+
+// Every element draws from a generator of its own, partitions calculate them
+// on different threads. Seeds come from one system draw per process.
+std::atomic_uint64_t g_seed{ (uint64_t{ std::random_device{}() } << 32) | std::random_device{}() };
+
+uint64_t next_seed()
+{
+  // splitmix64
+  uint64_t z{ g_seed.fetch_add(0x9e3779b97f4a7c15ULL) + 0x9e3779b97f4a7c15ULL };
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return (z ^ (z >> 31)) | 1;
+}
+
 } // namespace
 
 namespace spaghetti::elements::values {
@@ -43,16 +55,22 @@ RandomBool::RandomBool()
   addInput(ValueType::eBool, "Trigger", IOSocket::eCanHoldBool);
 
   addOutput(ValueType::eBool, "Value", IOSocket::eCanHoldBool);
+
+  m_state.random = next_seed();
 }
 
 void RandomBool::calculate()
 {
-  bool const STATE{ std::get<bool>(m_inputs[0].value) };
+  bool const STATE{ value<bool>(m_inputs[0]) };
 
-  if (STATE != m_state) {
-    bool const VALUE{ g_distrib(g_generator) };
-    m_outputs[0].value = VALUE;
-    m_state = STATE;
+  if (STATE != m_state.trigger) {
+    // xorshift64*, the top bit is the best one.
+    m_state.random ^= m_state.random >> 12;
+    m_state.random ^= m_state.random << 25;
+    m_state.random ^= m_state.random >> 27;
+    bool const VALUE{ ((m_state.random * 0x2545f4914f6cdd1dULL) >> 63) != 0 };
+    setValue(m_outputs[0], VALUE);
+    m_state.trigger = STATE;
   }
 }
 
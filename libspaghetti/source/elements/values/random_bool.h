@@ -39,9 +39,14 @@ class RandomBool final : public Element {
   string::hash_t hash() const noexcept override { return HASH; }
 
   void calculate() override;
+  RuntimeState runtimeState() override { return { &m_state, sizeof(m_state) }; }
 
  private:
-  bool m_state{};
+  // Checkpointed together, restoring one replays the same values.
+  struct State {
+    uint64_t random{};
+    bool trigger{};
+  } m_state{};
 };
 
 } // namespace spaghetti::elements::values
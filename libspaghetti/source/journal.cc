@@ -0,0 +1,545 @@
+// MIT License
+//
+// Copyright (c) 2017-2018 Artur Wyszyński, aljen at hitomi dot pl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "journal.h"
+
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+
+#include "filesystem.h"
+#include "mapped_file.h"
+#include "spaghetti/logger.h"
+#include "spaghetti/package.h"
+#include "spaghetti/package_format.h"
+#include "spaghetti/registry.h"
+
+namespace spaghetti {
+
+namespace {
+
+constexpr int const VERSION{ 1 };
+
+// Below this replaying is cheap enough that compacting isn't worth a rewrite.
+constexpr size_t const COMPACT_MIN_BYTES{ 1024 * 1024 };
+
+thread_local bool s_replaying{};
+
+struct ReplayScope {
+  ReplayScope() { s_replaying = true; }
+  ~ReplayScope() { s_replaying = false; }
+};
+
+Journal::Json path_of(Package const *a_package)
+{
+  std::vector<size_t> ids{};
+  for (; a_package->package(); a_package = a_package->package()) ids.push_back(a_package->id());
+  std::reverse(std::begin(ids), std::end(ids));
+  return ids;
+}
+
+// Edits that only overwrite state, a newer one makes a pending older one redundant.
+bool coalesces(std::string_view const a_op)
+{
+  for (auto const OP : { "move", "name", "iconify", "properties", "input_name", "output_name", "inputs_position",
+                         "outputs_position" })
+    if (a_op == OP) return true;
+  return false;
+}
+
+std::string header_line(uint64_t const a_baseHash)
+{
+  Journal::Json header = Journal::Json::object();
+  header["journal"] = VERSION;
+  header["base"] = a_baseHash;
+  return header.dump() + '\n';
+}
+
+Element *checked(Package const &a_package, size_t const a_id)
+{
+  auto const &ELEMENTS = a_package.elements();
+  if (a_id >= ELEMENTS.size() || !ELEMENTS[a_id]) throw std::runtime_error{ "no element " + std::to_string(a_id) };
+  return ELEMENTS[a_id];
+}
+
+Element::IOSocket &checked_socket(Element::IOSockets &a_sockets, size_t const a_socket)
+{
+  if (a_socket >= a_sockets.size()) throw std::runtime_error{ "no socket " + std::to_string(a_socket) };
+  return a_sockets[a_socket];
+}
+
+} // namespace
+
+Journal::Entry::Entry(Element const &a_element)
+  : m_hasId{ true }
+{
+  Package const *package{ a_element.package() };
+  m_id = a_element.id();
+
+  // The root package has no parent, it's element 0 of itself.
+  if (!package && a_element.hash() == Package::HASH) {
+    package = static_cast<Package const *>(&a_element);
+    m_id = 0;
+  }
+
+  enter(package, false);
+}
+
+Journal::Entry::Entry(Package const &a_package, bool const a_always)
+{
+  enter(&a_package, a_always);
+}
+
+Journal::Entry::~Entry()
+{
+  if (m_journal) --m_journal->m_depth;
+}
+
+void Journal::Entry::enter(Package const *const a_package, bool const a_always)
+{
+  if (!a_package) return;
+
+  Package const *root{ a_package };
+  while (root->package()) root = root->package();
+
+  m_journal = of(*root);
+  if (!m_journal) return;
+
+  m_package = a_package;
+  m_recording = m_journal->m_depth++ == 0 || a_always;
+}
+
+void Journal::Entry::operator()(char const *const a_op, Json a_args) const
+{
+  if (!m_recording) return;
+
+  a_args["op"] = a_op;
+  a_args["p"] = path_of(m_package);
+  if (m_hasId) a_args["id"] = m_id;
+
+  std::string key{};
+  if (coalesces(a_op)) {
+    key = a_args["p"].dump() + '/' + std::to_string(m_id) + '/' + a_op;
+    if (a_args.count("socket")) key += '/' + a_args["socket"].dump();
+  }
+
+  m_journal->record(a_args, std::move(key));
+}
+
+Journal::Journal(std::string a_packageFile)
+  : m_packageFile{ std::move(a_packageFile) }
+  , m_path{ m_packageFile + EXTENSION }
+{
+}
+
+Journal::~Journal()
+{
+  flush();
+
+  if (m_compaction.joinable()) {
+    m_compaction.join();
+    completeCompaction();
+  }
+}
+
+bool Journal::reset()
+{
+  dropCompaction();
+
+  m_pending.clear();
+  m_lastKey.clear();
+  m_size = 0;
+
+  m_hasBase = hashFile(m_packageFile, m_baseHash, m_baseSize);
+  if (!m_hasBase) return false;
+
+  // The log is written by the first flush() with an edit in it, opening a file
+  // doesn't leave one next to it. A stale one is dropped so it can't outlive its snapshot.
+  std::remove(m_path.c_str());
+  return true;
+}
+
+void Journal::replay(Package &a_package)
+{
+  uint64_t hash{};
+  size_t replayed{};
+  if (!hashFile(m_packageFile, hash, m_baseSize) || !replay(a_package, m_path, hash, SIZE_MAX, replayed)) {
+    reset();
+    return;
+  }
+
+  m_hasBase = true;
+  m_baseHash = hash;
+
+  // Drop a torn or broken tail, appends continue after the last edit that applied.
+  try {
+    if (fs::file_size(m_path) > replayed) fs::resize_file(m_path, replayed);
+  } catch (std::exception const &a_exception) {
+    log::error("Can't truncate journal {}: {}", m_path, a_exception.what());
+  }
+
+  m_size = replayed;
+}
+
+bool Journal::autosave(Package &a_package)
+{
+  finishCompaction();
+  if (!flush()) return false;
+
+  // Replaying costs about what loading does, a log a quarter of its snapshot is worth folding in.
+  if (m_size > std::max(COMPACT_MIN_BYTES, m_baseSize / 4)) startCompaction(a_package);
+
+  return true;
+}
+
+bool Journal::flush()
+{
+  if (m_pending.empty()) return true;
+  if (!m_hasBase) return false;
+
+  std::string const HEADER{ m_size == 0 ? header_line(m_baseHash) : std::string{} };
+  std::ofstream file{ m_path, std::ios::binary | (m_size == 0 ? std::ios::trunc : std::ios::app) };
+  file.write(HEADER.data(), static_cast<std::streamsize>(HEADER.size()));
+  file.write(m_pending.data(), static_cast<std::streamsize>(m_pending.size()));
+  if (!file) {
+    log::error("Can't append to journal {}", m_path);
+    return false;
+  }
+
+  m_size += HEADER.size() + m_pending.size();
+  m_pending.clear();
+  m_lastKey.clear();
+  return true;
+}
+
+void Journal::startCompaction(Package &a_package)
+{
+  if (m_compaction.joinable()) return;
+
+  a_package.compactTree();
+  if (!flush()) return;
+
+  m_compactionOffset = m_size;
+  m_compactionOk = false;
+  m_compactionDone = false;
+
+  // Works on a package of its own, the live one keeps being edited and journaled meanwhile.
+  m_compaction = std::thread{ [this] {
+    uint64_t hash{};
+    size_t size{};
+    if (hashFile(m_packageFile, hash, size)) {
+      Package package{};
+      package.openSnapshot(m_packageFile);
+
+      size_t replayed{};
+      std::string const TEMP{ m_packageFile + ".compacting" };
+      if (replay(package, m_path, hash, m_compactionOffset, replayed) && replayed == m_compactionOffset) {
+        package.saveSnapshot(TEMP, package_format::format_for(m_packageFile), false);
+        m_compactionOk = hashFile(TEMP, m_compactedHash, m_compactedSize);
+      }
+    }
+
+    m_compactionDone = true;
+  } };
+}
+
+bool Journal::finishCompaction()
+{
+  if (!m_compaction.joinable() || !m_compactionDone) return false;
+
+  m_compaction.join();
+  return completeCompaction();
+}
+
+bool Journal::completeCompaction()
+{
+  std::string const TEMP{ m_packageFile + ".compacting" };
+
+  if (!m_compactionOk || !rebase(TEMP, m_compactedHash, m_compactedSize, m_compactionOffset)) {
+    log::error("Can't compact journal {}", m_path);
+    std::remove(TEMP.c_str());
+    return false;
+  }
+
+  log::debug("Compacted journal {} into {}", m_path, m_packageFile);
+  return true;
+}
+
+void Journal::dropCompaction()
+{
+  // A fresh snapshot supersedes whatever a running compaction produces.
+  if (m_compaction.joinable()) {
+    m_compaction.join();
+    std::remove((m_packageFile + ".compacting").c_str());
+  }
+}
+
+size_t Journal::mark()
+{
+  dropCompaction();
+  flush();
+  return m_size;
+}
+
+bool Journal::rebase(std::string const &a_snapshot, uint64_t const a_hash, size_t const a_size, size_t const a_offset)
+{
+  std::string const JOURNAL_TEMP{ m_path + ".rebasing" };
+
+  // Edits logged since the snapshot was taken move over to it. A log that has no
+  // snapshot yet keeps them pending.
+  flush();
+  std::string tail(m_size > a_offset ? m_size - a_offset : 0, '\0');
+  if (!tail.empty()) {
+    std::ifstream file{ m_path, std::ios::binary };
+    file.seekg(static_cast<std::streamoff>(a_offset));
+    file.read(tail.data(), static_cast<std::streamsize>(tail.size()));
+    if (!file) {
+      log::error("Can't read journal {}", m_path);
+      return false;
+    }
+  }
+  tail += m_pending;
+
+  // Without edits to carry over there's no log to start, the first one writes it.
+  if (tail.empty()) {
+    try {
+      fs::rename(a_snapshot, m_packageFile);
+      std::remove(m_path.c_str());
+    } catch (std::exception const &a_exception) {
+      log::error("Can't replace {}: {}", m_packageFile, a_exception.what());
+      return false;
+    }
+
+    m_lastKey.clear();
+    m_size = 0;
+    m_baseSize = a_size;
+    m_baseHash = a_hash;
+    m_hasBase = true;
+    return true;
+  }
+
+  std::string const HEADER{ header_line(a_hash) };
+  {
+    std::ofstream file{ JOURNAL_TEMP, std::ios::binary | std::ios::trunc };
+    file.write(HEADER.data(), static_cast<std::streamsize>(HEADER.size()));
+    file.write(tail.data(), static_cast<std::streamsize>(tail.size()));
+    if (!file) {
+      log::error("Can't write journal {}", JOURNAL_TEMP);
+      return false;
+    }
+  }
+
+  try {
+    fs::rename(a_snapshot, m_packageFile);
+    fs::rename(JOURNAL_TEMP, m_path);
+  } catch (std::exception const &a_exception) {
+    log::error("Can't replace {}: {}", m_packageFile, a_exception.what());
+    return false;
+  }
+
+  m_pending.clear();
+  m_lastKey.clear();
+  m_size = HEADER.size() + tail.size();
+  m_baseSize = a_size;
+  m_baseHash = a_hash;
+  m_hasBase = true;
+  return true;
+}
+
+bool Journal::isReplaying()
+{
+  return s_replaying;
+}
+
+Journal *Journal::of(Package const &a_package)
+{
+  return a_package.m_journal.get();
+}
+
+void Journal::record(Json const &a_op, std::string a_key)
+{
+  if (!a_key.empty() && a_key == m_lastKey) m_pending.resize(m_lastOffset);
+
+  m_lastOffset = m_pending.size();
+  m_lastKey = std::move(a_key);
+  m_pending += a_op.dump();
+  m_pending += '\n';
+}
+
+bool Journal::hashFile(std::string const &a_filename, uint64_t &a_hash, size_t &a_size)
+{
+  std::error_code error{};
+  MappedFile const MAPPED{ a_filename, error };
+  if (error) return false;
+
+  // FNV-1a, only has to tell snapshots apart.
+  uint64_t hash{ 0xcbf29ce484222325ULL };
+  for (size_t i = 0; i < MAPPED.size(); ++i) hash = (hash ^ MAPPED.data()[i]) * 0x100000001b3ULL;
+
+  a_hash = hash;
+  a_size = MAPPED.size();
+  return true;
+}
+
+bool Journal::replay(Package &a_package, std::string const &a_path, uint64_t const a_baseHash, size_t const a_limit,
+                     size_t &a_replayed)
+{
+  std::ifstream file{ a_path, std::ios::binary };
+  if (!file.is_open()) return false;
+
+  std::string line{};
+  if (!std::getline(file, line) || file.eof()) return false;
+
+  try {
+    auto const HEADER = Json::parse(line);
+    if (HEADER.at("journal").get<int>() != VERSION || HEADER.at("base").get<uint64_t>() != a_baseHash) {
+      log::warn("Journal {} belongs to another snapshot, ignoring it", a_path);
+      return false;
+    }
+  } catch (std::exception const &a_exception) {
+    log::error("Journal {} is damaged: {}", a_path, a_exception.what());
+    return false;
+  }
+
+  ReplayScope const REPLAYING{};
+
+  size_t offset{ line.size() + 1 };
+  size_t edits{};
+  while (offset < a_limit && std::getline(file, line)) {
+    // A line without its newline was torn by a crash mid append.
+    if (file.eof() || offset + line.size() + 1 > a_limit) break;
+
+    try {
+      apply(a_package, Json::parse(line));
+    } catch (std::exception const &a_exception) {
+      log::error("Journal {} stops at edit {}: {}", a_path, edits, a_exception.what());
+      break;
+    }
+
+    offset += line.size() + 1;
+    ++edits;
+  }
+
+  log::debug("Replayed {} edits from {}", edits, a_path);
+
+  a_replayed = offset;
+  return true;
+}
+
+void Journal::apply(Package &a_root, Json const &a_op)
+{
+  Package *package{ &a_root };
+  for (auto const &ID : a_op.at("p")) {
+    Element *const element{ checked(*package, ID.get<size_t>()) };
+    if (element->hash() != Package::HASH) throw std::runtime_error{ "not a package" };
+    package = static_cast<Package *>(element);
+    package->materialize();
+  }
+
+  auto const &OP = a_op.at("op").get_ref<std::string const &>();
+  auto const ELEMENT = [&] { return checked(*package, a_op.at("id").get<size_t>()); };
+  auto const STRING = [&](char const *const a_key) { return a_op.at(a_key).get<std::string>(); };
+  auto const SOCKET = [&] { return a_op.at("socket").get<uint8_t>(); };
+  auto const TYPE = [&] { return static_cast<ValueType>(std::min(a_op.at("type").get<int>(), 2)); };
+  auto const FLAGS = [&] { return a_op.at("flags").get<uint8_t>(); };
+  auto const X = [&] { return a_op.at("x").get<double>(); };
+  auto const Y = [&] { return a_op.at("y").get<double>(); };
+
+  if (OP == "move")
+    ELEMENT()->setPosition(X(), Y());
+  else if (OP == "name")
+    ELEMENT()->setName(STRING("name"));
+  else if (OP == "iconify")
+    ELEMENT()->iconify(a_op.at("iconify").get<bool>());
+  else if (OP == "add_input")
+    ELEMENT()->addInput(TYPE(), STRING("name"), FLAGS());
+  else if (OP == "add_output")
+    ELEMENT()->addOutput(TYPE(), STRING("name"), FLAGS());
+  else if (OP == "input_name") {
+    Element *const element{ ELEMENT() };
+    checked_socket(element->m_inputs, SOCKET());
+    element->setInputName(SOCKET(), STRING("name"));
+  } else if (OP == "output_name") {
+    Element *const element{ ELEMENT() };
+    checked_socket(element->m_outputs, SOCKET());
+    element->setOutputName(SOCKET(), STRING("name"));
+  } else if (OP == "remove_input") {
+    Element *const element{ ELEMENT() };
+    if (element->m_inputs.empty()) throw std::runtime_error{ "no input to remove" };
+    element->removeInput();
+  } else if (OP == "remove_output") {
+    Element *const element{ ELEMENT() };
+    if (element->m_outputs.empty()) throw std::runtime_error{ "no output to remove" };
+    element->removeOutput();
+  } else if (OP == "clear_inputs")
+    ELEMENT()->clearInputs();
+  else if (OP == "clear_outputs")
+    ELEMENT()->clearOutputs();
+  else if (OP == "io_type") {
+    Element *const element{ ELEMENT() };
+    bool const INPUT{ a_op.at("input").get<bool>() };
+    checked_socket(INPUT ? static_cast<Element::IOSockets &>(element->m_inputs) : element->m_outputs, SOCKET());
+    element->setIOValueType(INPUT, SOCKET(), TYPE());
+  } else if (OP == "properties")
+    ELEMENT()->setProperties(a_op.at("properties"));
+  else if (OP == "add") {
+    auto const HASH = string::hash(STRING("type"));
+    if (!Registry::get().hasElement(HASH)) throw std::runtime_error{ "unknown element type " + STRING("type") };
+    size_t const NEW_ID{ a_op.at("new_id").get<size_t>() };
+    // Elements a deserialize brought in were appended after any holes, with their whole state.
+    if (a_op.count("element")) {
+      auto const &ELEMENT_JSON = a_op.at("element");
+      size_t const ID{ package->addBulk(
+          { HASH }, [&ELEMENT_JSON](size_t const, Element &a_element) { a_element.deserialize(ELEMENT_JSON); }) };
+      if (ID != NEW_ID) throw std::runtime_error{ "element ids diverged" };
+    } else {
+      Element *const element{ package->add(HASH) };
+      if (element->id() != NEW_ID) throw std::runtime_error{ "element ids diverged" };
+    }
+  } else if (OP == "remove") {
+    Element *const element{ ELEMENT() };
+    if (element == package) throw std::runtime_error{ "can't remove a package from itself" };
+    package->remove(element->id());
+  } else if (OP == "connect" || OP == "disconnect") {
+    size_t const FROM{ a_op.at("from").get<size_t>() };
+    size_t const TO{ a_op.at("to").get<size_t>() };
+    uint8_t const OUTPUT{ a_op.at("output").get<uint8_t>() };
+    uint8_t const INPUT{ a_op.at("input").get<uint8_t>() };
+    checked(*package, FROM);
+    checked(*package, TO);
+    if (!package->canConnect(FROM, OUTPUT, TO, INPUT)) throw std::runtime_error{ "sockets don't match" };
+    OP == "connect" ? package->connect(FROM, OUTPUT, TO, INPUT) : package->disconnect(FROM, OUTPUT, TO, INPUT);
+  } else if (OP == "compact")
+    package->compact();
+  else if (OP == "deserialize")
+    package->deserialize(a_op.at("package"));
+  else if (OP == "reference")
+    package->setReference(a_op.at("reference").get<bool>());
+  else if (OP == "inputs_position")
+    package->setInputsPosition(X(), Y());
+  else if (OP == "outputs_position")
+    package->setOutputsPosition(X(), Y());
+  else
+    throw std::runtime_error{ "unknown edit " + OP };
+}
+
+} // namespace spaghetti
@@ -0,0 +1,146 @@
+// MIT License
+//
+// Copyright (c) 2017-2018 Artur Wyszyński, aljen at hitomi dot pl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+#ifndef SPAGHETTI_JOURNAL_H
+#define SPAGHETTI_JOURNAL_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+#include "spaghetti/element.h"
+
+namespace spaghetti {
+
+class Package;
+
+// Edits made to a package since its file was last written, kept as an
+// append-only log of JSON lines next to it. Autosave appends what changed,
+// open() replays the log over the snapshot and a background compaction folds
+// it into a new snapshot once it grows. The first line names the snapshot the
+// log applies to, a log left behind by another snapshot is ignored.
+class Journal final {
+ public:
+  using Json = Element::Json;
+
+  static constexpr char const *const EXTENSION{ ".journal" };
+
+  // Records one edit of an element or a package. Edits made while another
+  // one is being recorded are left out, replaying the outer one repeats them.
+  // Test it before building the arguments, most edits aren't recorded.
+  class Entry final {
+   public:
+    explicit Entry(Element const &a_element);
+    // a_always records even inside another edit, for ids changing underneath it.
+    explicit Entry(Package const &a_package, bool const a_always = false);
+    ~Entry();
+
+    Entry(Entry const &) = delete;
+    Entry &operator=(Entry const &) = delete;
+
+    explicit operator bool() const { return m_recording; }
+
+    void operator()(char const *const a_op, Json a_args = Json::object()) const;
+
+   private:
+    void enter(Package const *const a_package, bool const a_always);
+
+   private:
+    Journal *m_journal{};
+    Package const *m_package{};
+    size_t m_id{};
+    bool m_hasId{};
+    bool m_recording{};
+  };
+
+  explicit Journal(std::string a_packageFile);
+  ~Journal();
+
+  Journal(Journal const &) = delete;
+  Journal &operator=(Journal const &) = delete;
+
+  std::string const &path() const { return m_path; }
+
+  // Starts an empty log for the snapshot just written to the package file, the
+  // file itself is created along with the first edit.
+  bool reset();
+  // Replays the log over the snapshot just loaded into a_package, or starts
+  // an empty one if there's none that belongs to it.
+  void replay(Package &a_package);
+
+  // Appends pending edits, compacts once the log outgrows its snapshot.
+  bool autosave(Package &a_package);
+  bool flush();
+
+  // Closes the holes in a_package first, the new snapshot numbers its elements
+  // consecutively and the edits logged meanwhile have to agree with it.
+  void startCompaction(Package &a_package);
+  bool finishCompaction();
+
+  // Edits logged from the returned offset on are the ones a snapshot of the
+  // package taken now lacks. The snapshot supersedes a running compaction.
+  size_t mark();
+  // Moves a_snapshot, written from the package when mark() returned a_offset,
+  // over the package file and starts the log over with the edits made since.
+  bool rebase(std::string const &a_snapshot, uint64_t const a_hash, size_t const a_size, size_t const a_offset);
+
+  static bool isReplaying();
+  static bool hashFile(std::string const &a_filename, uint64_t &a_hash, size_t &a_size);
+
+ private:
+  static Journal *of(Package const &a_package);
+  void record(Json const &a_op, std::string a_key);
+  bool completeCompaction();
+  void dropCompaction();
+  static bool replay(Package &a_package, std::string const &a_path, uint64_t const a_baseHash, size_t const a_limit,
+                     size_t &a_replayed);
+  static void apply(Package &a_root, Json const &a_op);
+
+ private:
+  std::string const m_packageFile;
+  std::string const m_path;
+  std::string m_pending{};
+  // Bytes in the log file, 0 while it hasn't been written yet.
+  size_t m_size{};
+  size_t m_baseSize{};
+  uint64_t m_baseHash{};
+  bool m_hasBase{};
+  // Edits may nest on the workers of a parallel load.
+  std::atomic_uint32_t m_depth{};
+
+  // Repeated moves and renames of the same target overwrite each other while pending.
+  std::string m_lastKey{};
+  size_t m_lastOffset{};
+
+  std::thread m_compaction{};
+  std::atomic_bool m_compactionDone{};
+  bool m_compactionOk{};
+  size_t m_compactionOffset{};
+  uint64_t m_compactedHash{};
+  size_t m_compactedSize{};
+};
+
+} // namespace spaghetti
+
+#endif // SPAGHETTI_JOURNAL_H
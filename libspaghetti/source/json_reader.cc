@@ -0,0 +1,314 @@
+// MIT License
+//
+// Copyright (c) 2017-2018 Artur Wyszyński, aljen at hitomi dot pl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "json_reader.h"
+
+#include <cstdlib>
+#include <stdexcept>
+
+namespace spaghetti {
+
+JsonReader::JsonReader(std::istream &a_stream, size_t const a_bufferSize)
+  : m_stream{ a_stream }
+  , m_buffer(a_bufferSize)
+{
+}
+
+JsonReader::Token JsonReader::peek()
+{
+  switch (skipWhitespace()) {
+    case '{': return Token::eObject;
+    case '[': return Token::eArray;
+    case '"': return Token::eString;
+    case 't':
+    case 'f': return Token::eBool;
+    case 'n': return Token::eNull;
+    case EOF: return Token::eEnd;
+    default: return Token::eNumber;
+  }
+}
+
+void JsonReader::beginObject()
+{
+  expect('{');
+  m_needsComma.push_back(false);
+}
+
+bool JsonReader::nextKey(std::string &a_key)
+{
+  if (skipWhitespace() == '}') {
+    get();
+    m_needsComma.pop_back();
+    return false;
+  }
+
+  if (m_needsComma.back()) expect(',');
+  m_needsComma.back() = true;
+
+  readString(a_key);
+  expect(':');
+
+  return true;
+}
+
+void JsonReader::beginArray()
+{
+  expect('[');
+  m_needsComma.push_back(false);
+}
+
+bool JsonReader::nextItem()
+{
+  if (skipWhitespace() == ']') {
+    get();
+    m_needsComma.pop_back();
+    return false;
+  }
+
+  if (m_needsComma.back()) expect(',');
+  m_needsComma.back() = true;
+
+  return true;
+}
+
+void JsonReader::readString(std::string &a_string)
+{
+  expect('"');
+  a_string.clear();
+
+  while (true) {
+    if (m_position == m_size && !fill()) fail("unterminated string");
+
+    // Copy runs without quotes or escapes straight out of the buffer.
+    size_t end{ m_position };
+    while (end < m_size && m_buffer[end] != '"' && m_buffer[end] != '\\') ++end;
+    a_string.append(&m_buffer[m_position], end - m_position);
+    m_position = end;
+    if (m_position == m_size) continue;
+
+    if (get() == '"') return;
+
+    int const ESCAPED{ get() };
+    switch (ESCAPED) {
+      case '"': a_string += '"'; break;
+      case '\\': a_string += '\\'; break;
+      case '/': a_string += '/'; break;
+      case 'b': a_string += '\b'; break;
+      case 'f': a_string += '\f'; break;
+      case 'n': a_string += '\n'; break;
+      case 'r': a_string += '\r'; break;
+      case 't': a_string += '\t'; break;
+      case 'u': readUnicode(a_string); break;
+      default: fail("invalid escape");
+    }
+  }
+}
+
+std::string JsonReader::readString()
+{
+  std::string string{};
+  readString(string);
+  return string;
+}
+
+double JsonReader::readDouble()
+{
+  readNumber();
+  return std::strtod(m_number.c_str(), nullptr);
+}
+
+uint64_t JsonReader::readUnsigned()
+{
+  bool const INTEGER{ readNumber() };
+  if (m_number[0] == '-') fail("expected unsigned number");
+  return INTEGER ? std::strtoull(m_number.c_str(), nullptr, 10)
+                 : static_cast<uint64_t>(std::strtod(m_number.c_str(), nullptr));
+}
+
+bool JsonReader::readBool()
+{
+  if (skipWhitespace() == 't') {
+    expectLiteral("true");
+    return true;
+  }
+  expectLiteral("false");
+  return false;
+}
+
+Element::Json JsonReader::readValue()
+{
+  using Json = Element::Json;
+
+  switch (peek()) {
+    case Token::eObject: {
+      Json object = Json::object();
+      std::string key{};
+      beginObject();
+      while (nextKey(key)) object[key] = readValue();
+      return object;
+    }
+    case Token::eArray: {
+      Json array = Json::array();
+      beginArray();
+      while (nextItem()) array.push_back(readValue());
+      return array;
+    }
+    case Token::eString: return readString();
+    case Token::eBool: return readBool();
+    case Token::eNull: expectLiteral("null"); return nullptr;
+    case Token::eNumber: {
+      if (readNumber()) {
+        if (m_number[0] == '-') return static_cast<int64_t>(std::strtoll(m_number.c_str(), nullptr, 10));
+        return static_cast<uint64_t>(std::strtoull(m_number.c_str(), nullptr, 10));
+      }
+      return std::strtod(m_number.c_str(), nullptr);
+    }
+    case Token::eEnd: break;
+  }
+
+  fail("unexpected end of input");
+}
+
+void JsonReader::skipValue()
+{
+  std::string ignored{};
+
+  switch (peek()) {
+    case Token::eObject:
+      beginObject();
+      while (nextKey(ignored)) skipValue();
+      break;
+    case Token::eArray:
+      beginArray();
+      while (nextItem()) skipValue();
+      break;
+    case Token::eString: readString(ignored); break;
+    case Token::eBool: readBool(); break;
+    case Token::eNull: expectLiteral("null"); break;
+    case Token::eNumber: readNumber(); break;
+    case Token::eEnd: fail("unexpected end of input");
+  }
+}
+
+bool JsonReader::fill()
+{
+  m_consumed += m_size;
+  m_position = 0;
+  m_stream.read(m_buffer.data(), static_cast<std::streamsize>(m_buffer.size()));
+  m_size = static_cast<size_t>(m_stream.gcount());
+  return m_size > 0;
+}
+
+int JsonReader::skipWhitespace()
+{
+  int character{ current() };
+  while (character == ' ' || character == '\n' || character == '\r' || character == '\t') {
+    ++m_position;
+    character = current();
+  }
+  return character;
+}
+
+void JsonReader::expect(char const a_character)
+{
+  if (skipWhitespace() != a_character) fail(std::string{ "expected '" } + a_character + "'");
+  ++m_position;
+}
+
+void JsonReader::expectLiteral(char const *const a_literal)
+{
+  for (char const *character = a_literal; *character; ++character)
+    if (get() != *character) fail(std::string{ "expected " } + a_literal);
+}
+
+// Collects the number into m_number, true if it has no fraction or exponent.
+bool JsonReader::readNumber()
+{
+  m_number.clear();
+  bool integer{ true };
+
+  int character{ skipWhitespace() };
+  while ((character >= '0' && character <= '9') || character == '-' || character == '+' || character == '.' ||
+         character == 'e' || character == 'E') {
+    if (character == '.' || character == 'e' || character == 'E') integer = false;
+    m_number += static_cast<char>(character);
+    ++m_position;
+    character = current();
+  }
+
+  if (m_number.empty()) fail("expected value");
+
+  return integer;
+}
+
+void JsonReader::readUnicode(std::string &a_string)
+{
+  uint32_t codePoint{ readHex() };
+
+  if (codePoint >= 0xD800 && codePoint <= 0xDBFF) {
+    if (get() != '\\' || get() != 'u') fail("unpaired surrogate");
+    uint32_t const LOW{ readHex() };
+    if (LOW < 0xDC00 || LOW > 0xDFFF) fail("unpaired surrogate");
+    codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (LOW - 0xDC00);
+  }
+
+  if (codePoint < 0x80) {
+    a_string += static_cast<char>(codePoint);
+  } else if (codePoint < 0x800) {
+    a_string += static_cast<char>(0xC0 | (codePoint >> 6));
+    a_string += static_cast<char>(0x80 | (codePoint & 0x3F));
+  } else if (codePoint < 0x10000) {
+    a_string += static_cast<char>(0xE0 | (codePoint >> 12));
+    a_string += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+    a_string += static_cast<char>(0x80 | (codePoint & 0x3F));
+  } else {
+    a_string += static_cast<char>(0xF0 | (codePoint >> 18));
+    a_string += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+    a_string += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+    a_string += static_cast<char>(0x80 | (codePoint & 0x3F));
+  }
+}
+
+uint32_t JsonReader::readHex()
+{
+  uint32_t value{};
+  for (int i = 0; i < 4; ++i) {
+    int const CHARACTER{ get() };
+    value <<= 4;
+    if (CHARACTER >= '0' && CHARACTER <= '9')
+      value |= static_cast<uint32_t>(CHARACTER - '0');
+    else if (CHARACTER >= 'a' && CHARACTER <= 'f')
+      value |= static_cast<uint32_t>(CHARACTER - 'a' + 10);
+    else if (CHARACTER >= 'A' && CHARACTER <= 'F')
+      value |= static_cast<uint32_t>(CHARACTER - 'A' + 10);
+    else
+      fail("invalid \\u escape");
+  }
+  return value;
+}
+
+void JsonReader::fail(std::string const &a_what) const
+{
+  throw std::runtime_error{ "JSON error at byte " + std::to_string(m_consumed + m_position) + ": " + a_what };
+}
+
+} // namespace spaghetti
@@ -0,0 +1,102 @@
+// MIT License
+//
+// Copyright (c) 2017-2018 Artur Wyszyński, aljen at hitomi dot pl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+#ifndef SPAGHETTI_JSON_READER_H
+#define SPAGHETTI_JSON_READER_H
+
+#include <cstdint>
+#include <cstdio>
+#include <istream>
+#include <string>
+#include <vector>
+
+#include "spaghetti/element.h"
+
+namespace spaghetti {
+
+// Pull tokenizer over a buffered stream. The caller walks the document with
+// begin/next calls and reads scalars in place, so nothing but the current
+// token is held in memory. Malformed input throws std::runtime_error.
+class JsonReader final {
+ public:
+  enum class Token { eObject, eArray, eString, eNumber, eBool, eNull, eEnd };
+
+  explicit JsonReader(std::istream &a_stream, size_t const a_bufferSize = 64 * 1024);
+
+  Token peek();
+
+  void beginObject();
+  // Reads the next key, false once the object is closed.
+  bool nextKey(std::string &a_key);
+
+  void beginArray();
+  // False once the array is closed.
+  bool nextItem();
+
+  void readString(std::string &a_string);
+  std::string readString();
+  double readDouble();
+  uint64_t readUnsigned();
+  bool readBool();
+
+  // Materializes whatever comes next, for keys the caller doesn't handle itself.
+  Element::Json readValue();
+  void skipValue();
+
+  size_t bufferSize() const { return m_buffer.size(); }
+
+ private:
+  int get()
+  {
+    if (m_position == m_size && !fill()) return EOF;
+    return static_cast<unsigned char>(m_buffer[m_position++]);
+  }
+
+  int current()
+  {
+    if (m_position == m_size && !fill()) return EOF;
+    return static_cast<unsigned char>(m_buffer[m_position]);
+  }
+
+  bool fill();
+  int skipWhitespace();
+  void expect(char const a_character);
+  void expectLiteral(char const *const a_literal);
+  bool readNumber();
+  void readUnicode(std::string &a_string);
+  uint32_t readHex();
+  [[noreturn]] void fail(std::string const &a_what) const;
+
+ private:
+  std::istream &m_stream;
+  std::vector<char> m_buffer{};
+  size_t m_position{};
+  size_t m_size{};
+  size_t m_consumed{};
+  std::vector<bool> m_needsComma{};
+  std::string m_number{};
+};
+
+} // namespace spaghetti
+
+#endif // SPAGHETTI_JSON_READER_H
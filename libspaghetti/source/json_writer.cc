@@ -0,0 +1,222 @@
+// MIT License
+//
+// Copyright (c) 2017-2018 Artur Wyszyński, aljen at hitomi dot pl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "json_writer.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <charconv>
+#include <clocale>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+
+namespace spaghetti {
+
+JsonWriter::JsonWriter(std::ostream &a_stream, int const a_indent, size_t const a_bufferSize)
+  : m_stream{ a_stream }
+  , m_indent{ a_indent }
+  , m_bufferSize{ a_bufferSize }
+{
+  m_buffer.reserve(a_bufferSize + 64);
+}
+
+JsonWriter::~JsonWriter()
+{
+  flush();
+}
+
+void JsonWriter::beginObject()
+{
+  prefix();
+  write('{');
+  m_counts.push_back(0);
+}
+
+void JsonWriter::endObject()
+{
+  assert(!m_counts.empty());
+  bool const EMPTY{ m_counts.back() == 0 };
+  m_counts.pop_back();
+  if (!EMPTY) newLine(m_counts.size());
+  write('}');
+}
+
+void JsonWriter::key(std::string_view const a_key)
+{
+  prefix();
+  writeString(a_key);
+  write(m_indent < 0 ? ":" : ": ");
+  m_afterKey = true;
+}
+
+void JsonWriter::beginArray()
+{
+  prefix();
+  write('[');
+  m_counts.push_back(0);
+}
+
+void JsonWriter::endArray()
+{
+  assert(!m_counts.empty());
+  bool const EMPTY{ m_counts.back() == 0 };
+  m_counts.pop_back();
+  if (!EMPTY) newLine(m_counts.size());
+  write(']');
+}
+
+void JsonWriter::value(std::string_view const a_value)
+{
+  prefix();
+  writeString(a_value);
+}
+
+void JsonWriter::value(double const a_value)
+{
+  prefix();
+
+  if (!std::isfinite(a_value)) {
+    write("null");
+    return;
+  }
+
+  // Same digits and locale handling as Json::dump(), files don't change on a resave.
+  std::array<char, 64> number{};
+  int const SIZE{ std::snprintf(number.data(), number.size(), "%.*g", std::numeric_limits<double>::digits10,
+                                a_value) };
+  assert(SIZE > 0 && static_cast<size_t>(SIZE) < number.size());
+  auto const END = std::begin(number) + SIZE;
+
+  std::lconv const *const LOCALE{ std::localeconv() };
+  char const SEPARATOR{ LOCALE->thousands_sep ? *LOCALE->thousands_sep : '\0' };
+  char const POINT{ LOCALE->decimal_point ? *LOCALE->decimal_point : '\0' };
+  auto const LAST = SEPARATOR ? std::remove(std::begin(number), END, SEPARATOR) : END;
+  if (POINT && POINT != '.') std::replace(std::begin(number), LAST, POINT, '.');
+
+  write(std::string_view{ number.data(), static_cast<size_t>(LAST - std::begin(number)) });
+  if (std::none_of(std::begin(number), LAST, [](char const a_c) { return a_c == '.' || a_c == 'e'; })) write(".0");
+}
+
+void JsonWriter::value(uint64_t const a_value)
+{
+  prefix();
+
+  std::array<char, 24> number{};
+  auto const RESULT = std::to_chars(number.data(), number.data() + number.size(), a_value);
+  write(std::string_view{ number.data(), static_cast<size_t>(RESULT.ptr - number.data()) });
+}
+
+void JsonWriter::value(int64_t const a_value)
+{
+  prefix();
+
+  std::array<char, 24> number{};
+  auto const RESULT = std::to_chars(number.data(), number.data() + number.size(), a_value);
+  write(std::string_view{ number.data(), static_cast<size_t>(RESULT.ptr - number.data()) });
+}
+
+void JsonWriter::value(bool const a_value)
+{
+  prefix();
+  write(a_value ? "true" : "false");
+}
+
+void JsonWriter::value(Element::Json const &a_json)
+{
+  switch (a_json.type()) {
+    case Element::Json::value_t::object:
+      beginObject();
+      for (auto it = a_json.begin(); it != a_json.end(); ++it) {
+        key(it.key());
+        value(it.value());
+      }
+      endObject();
+      break;
+    case Element::Json::value_t::array:
+      beginArray();
+      for (auto const &ITEM : a_json) value(ITEM);
+      endArray();
+      break;
+    case Element::Json::value_t::string: value(std::string_view{ a_json.get_ref<std::string const &>() }); break;
+    case Element::Json::value_t::boolean: value(a_json.get<bool>()); break;
+    case Element::Json::value_t::number_integer: value(a_json.get<int64_t>()); break;
+    case Element::Json::value_t::number_unsigned: value(a_json.get<uint64_t>()); break;
+    case Element::Json::value_t::number_float: value(a_json.get<double>()); break;
+    default:
+      prefix();
+      write("null");
+      break;
+  }
+}
+
+void JsonWriter::flush()
+{
+  m_stream.write(m_buffer.data(), static_cast<std::streamsize>(m_buffer.size()));
+  m_buffer.clear();
+}
+
+void JsonWriter::prefix()
+{
+  if (m_afterKey) {
+    m_afterKey = false;
+    return;
+  }
+  if (m_counts.empty()) return;
+
+  if (m_counts.back()++ > 0) write(',');
+  newLine(m_counts.size());
+}
+
+void JsonWriter::newLine(size_t const a_depth)
+{
+  if (m_indent < 0) return;
+  write('\n');
+  m_buffer.append(a_depth * static_cast<size_t>(m_indent), ' ');
+}
+
+void JsonWriter::write(std::string_view const a_string)
+{
+  m_buffer.append(a_string);
+  if (m_buffer.size() >= m_bufferSize) flush();
+}
+
+void JsonWriter::writeString(std::string_view const a_string)
+{
+  bool const PLAIN{ std::all_of(std::begin(a_string), std::end(a_string), [](char const a_c) {
+    auto const BYTE = static_cast<unsigned char>(a_c);
+    return BYTE >= 0x20 && BYTE < 0x80 && a_c != '"' && a_c != '\\';
+  }) };
+
+  // Escapes and UTF-8 checks are rare enough to leave to Json itself.
+  if (!PLAIN) {
+    write(Element::Json(std::string{ a_string }).dump());
+    return;
+  }
+
+  write('"');
+  write(a_string);
+  write('"');
+}
+
+} // namespace spaghetti
@@ -0,0 +1,88 @@
+// MIT License
+//
+// Copyright (c) 2017-2018 Artur Wyszyński, aljen at hitomi dot pl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+#ifndef SPAGHETTI_JSON_WRITER_H
+#define SPAGHETTI_JSON_WRITER_H
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "spaghetti/element.h"
+
+namespace spaghetti {
+
+// Push writer into a buffered stream, the counterpart of JsonReader. Output
+// matches Json::dump() for the same document, pretty printed with a_indent
+// spaces or compact when a_indent is negative.
+class JsonWriter final {
+ public:
+  explicit JsonWriter(std::ostream &a_stream, int const a_indent = 2, size_t const a_bufferSize = 64 * 1024);
+  ~JsonWriter();
+
+  void beginObject();
+  void endObject();
+  void key(std::string_view const a_key);
+
+  void beginArray();
+  void endArray();
+
+  void value(std::string_view const a_value);
+  void value(char const *const a_value) { value(std::string_view{ a_value }); }
+  void value(double const a_value);
+  void value(uint64_t const a_value);
+  void value(int64_t const a_value);
+  void value(bool const a_value);
+  // Writes a finished DOM, for what an element serializes on its own.
+  void value(Element::Json const &a_json);
+
+  void flush();
+
+  size_t bufferSize() const { return m_buffer.capacity(); }
+
+ private:
+  void prefix();
+  void newLine(size_t const a_depth);
+  void write(char const a_character)
+  {
+    m_buffer.push_back(a_character);
+    if (m_buffer.size() >= m_bufferSize) flush();
+  }
+  void write(std::string_view const a_string);
+  void writeString(std::string_view const a_string);
+
+ private:
+  std::ostream &m_stream;
+  int const m_indent{};
+  size_t const m_bufferSize{};
+  std::string m_buffer{};
+  // Items written so far in every open object or array.
+  std::vector<size_t> m_counts{};
+  bool m_afterKey{};
+};
+
+} // namespace spaghetti
+
+#endif // SPAGHETTI_JSON_WRITER_H
@@ -0,0 +1,111 @@
+// MIT License
+//
+// Copyright (c) 2017-2018 Artur Wyszyński, aljen at hitomi dot pl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "mapped_file.h"
+
+// clang-format off
+#if defined(_WIN64) || defined(_WIN32)
+# define WIN32_LEAN_AND_MEAN
+# include <Windows.h>
+#elif defined(__unix__) || defined(__APPLE__)
+# include <cerrno>
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <unistd.h>
+#endif
+// clang-format on
+#include "spaghetti/logger.h"
+
+namespace spaghetti {
+
+MappedFile::MappedFile(std::string a_filename, std::error_code &a_errorCode)
+  : m_filename{ std::move(a_filename) }
+{
+  log::debug("[mapped_file]: Mapping {}", m_filename);
+
+#if defined(_WIN64) || defined(_WIN32)
+  m_file = CreateFileA(m_filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                       FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+  if (m_file == INVALID_HANDLE_VALUE) {
+    m_file = nullptr;
+    a_errorCode = std::error_code(static_cast<int>(GetLastError()), std::system_category());
+    log::error("[mapped_file]: Can't open {}", m_filename);
+    return;
+  }
+
+  LARGE_INTEGER size{};
+  GetFileSizeEx(m_file, &size);
+  m_size = static_cast<size_t>(size.QuadPart);
+
+  if (m_size > 0) {
+    m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (m_mapping) m_data = static_cast<uint8_t const *>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+    if (m_data == nullptr) {
+      a_errorCode = std::error_code(static_cast<int>(GetLastError()), std::system_category());
+      log::error("[mapped_file]: Can't map {}", m_filename);
+      m_size = 0;
+      return;
+    }
+  }
+#elif defined(__unix__) || defined(__APPLE__)
+  int const FD{ ::open(m_filename.c_str(), O_RDONLY) };
+  if (FD < 0) {
+    a_errorCode = std::error_code(errno, std::system_category());
+    log::error("[mapped_file]: Can't open {}", m_filename);
+    return;
+  }
+
+  struct stat status {};
+  if (fstat(FD, &status) == 0) m_size = static_cast<size_t>(status.st_size);
+
+  if (m_size > 0) {
+    void *const DATA{ mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, FD, 0) };
+    if (DATA == MAP_FAILED) {
+      a_errorCode = std::error_code(errno, std::system_category());
+      log::error("[mapped_file]: Can't map {}", m_filename);
+      m_size = 0;
+      close(FD);
+      return;
+    }
+    m_data = static_cast<uint8_t const *>(DATA);
+  }
+
+  // The mapping keeps its own reference to the file.
+  close(FD);
+#endif
+
+  a_errorCode = std::error_code(0, std::system_category());
+}
+
+MappedFile::~MappedFile()
+{
+#if defined(_WIN64) || defined(_WIN32)
+  if (m_data) UnmapViewOfFile(m_data);
+  if (m_mapping) CloseHandle(m_mapping);
+  if (m_file) CloseHandle(m_file);
+#elif defined(__unix__) || defined(__APPLE__)
+  if (m_data) munmap(const_cast<uint8_t *>(m_data), m_size);
+#endif
+}
+
+} // namespace spaghetti
@@ -187,23 +187,23 @@ void Node::setElement(Element *const a_element)
   switch (m_type) {
     case Type::eElement:
       for (size_t i = 0; i < INPUTS.size(); ++i) {
-        QString const NAME{ QString::fromStdString(INPUTS[i].name) };
+        QString const NAME{ QString::fromStdString(string::lookup(INPUTS[i].name)) };
         addSocket(SocketType::eInput, static_cast<uint8_t>(i), NAME, INPUTS[i].type, false);
       }
       for (size_t i = 0; i < OUTPUTS.size(); ++i) {
-        QString const NAME{ QString::fromStdString(OUTPUTS[i].name) };
+        QString const NAME{ QString::fromStdString(string::lookup(OUTPUTS[i].name)) };
         addSocket(SocketType::eOutput, static_cast<uint8_t>(i), NAME, OUTPUTS[i].type, false);
       }
       break;
     case Type::eInputs:
       for (size_t i = 0; i < INPUTS.size(); ++i) {
-        QString const NAME{ QString::fromStdString(INPUTS[i].name) };
+        QString const NAME{ QString::fromStdString(string::lookup(INPUTS[i].name)) };
         addSocket(SocketType::eOutput, static_cast<uint8_t>(i), NAME, INPUTS[i].type, true);
       }
       break;
     case Type::eOutputs:
       for (size_t i = 0; i < OUTPUTS.size(); ++i) {
-        QString const NAME{ QString::fromStdString(OUTPUTS[i].name) };
+        QString const NAME{ QString::fromStdString(string::lookup(OUTPUTS[i].name)) };
         addSocket(SocketType::eInput, static_cast<uint8_t>(i), NAME, OUTPUTS[i].type, true);
       }
       break;
@@ -433,12 +433,12 @@ void Node::showIOProperties(IOSocketsType const a_type)
     auto const &IO = ios[static_cast<size_t>(i)];
 
     if (IO.flags & Element::IOSocket::eCanChangeName) {
-      QLineEdit *const ioName{ new QLineEdit{ QString::fromStdString(IO.name) } };
+      QLineEdit *const ioName{ new QLineEdit{ QString::fromStdString(string::lookup(IO.name)) } };
       QObject::connect(ioName, &QLineEdit::editingFinished,
                        [a_type, i, ioName, this]() { changeIOName(a_type, i, ioName->text()); });
       m_properties->setCellWidget(row, 0, ioName);
     } else {
-      item = new QTableWidgetItem{ QString::fromStdString(IO.name) };
+      item = new QTableWidgetItem{ QString::fromStdString(string::lookup(IO.name)) };
       item->setFlags(item->flags() & ~Qt::ItemIsEditable);
       m_properties->setItem(row, 0, item);
     }
@@ -674,7 +674,7 @@ void Node::updateOutputs()
   for (size_t i = 0; i < SIZE; ++i) {
     switch (OUTPUTS[i].type) {
       case ValueType::eBool: {
-        bool const SIGNAL{ std::get<bool>(OUTPUTS[i].value) };
+        bool const SIGNAL{ m_element->value<bool>(OUTPUTS[i]) };
         m_outputs[static_cast<int>(i)]->setSignal(SIGNAL);
         break;
       }
@@ -48,7 +48,7 @@ FloatInfo::FloatInfo()
 void FloatInfo::refreshCentralWidget()
 {
   if (!m_element) return;
-  float const value{ std::get<float>(m_element->inputs()[0].value) };
+  float const value{ m_element->value<float>(m_element->inputs()[0]) };
   m_info->setText(QString::number(static_cast<qreal>(value), 'f', 4));
 
   calculateBoundingRect();
@@ -48,7 +48,7 @@ IntInfo::IntInfo()
 void IntInfo::refreshCentralWidget()
 {
   if (!m_element) return;
-  int32_t const value{ std::get<int32_t>(m_element->inputs()[0].value) };
+  int32_t const value{ m_element->value<int32_t>(m_element->inputs()[0]) };
   m_info->setText(QString::number(value));
 
   calculateBoundingRect();
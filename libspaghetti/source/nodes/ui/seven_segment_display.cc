@@ -131,14 +131,14 @@ void SevenSegmentDisplay::refreshCentralWidget()
 
   auto const &inputs = m_element->inputs();
 
-  bool const A{ std::get<bool>(inputs[0].value) };
-  bool const B{ std::get<bool>(inputs[1].value) };
-  bool const C{ std::get<bool>(inputs[2].value) };
-  bool const D{ std::get<bool>(inputs[3].value) };
-  bool const E{ std::get<bool>(inputs[4].value) };
-  bool const F{ std::get<bool>(inputs[5].value) };
-  bool const G{ std::get<bool>(inputs[6].value) };
-  bool const DP{ std::get<bool>(inputs[7].value) };
+  bool const A{ m_element->value<bool>(inputs[0]) };
+  bool const B{ m_element->value<bool>(inputs[1]) };
+  bool const C{ m_element->value<bool>(inputs[2]) };
+  bool const D{ m_element->value<bool>(inputs[3]) };
+  bool const E{ m_element->value<bool>(inputs[4]) };
+  bool const F{ m_element->value<bool>(inputs[5]) };
+  bool const G{ m_element->value<bool>(inputs[6]) };
+  bool const DP{ m_element->value<bool>(inputs[7]) };
 
   m_widget->setState(0, A);
   m_widget->setState(1, B);
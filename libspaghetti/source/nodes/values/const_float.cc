@@ -50,7 +50,7 @@ ConstFloat::ConstFloat()
 void ConstFloat::refreshCentralWidget()
 {
   if (!m_element) return;
-  float const VALUE{ std::get<float>(m_element->outputs()[0].value) };
+  float const VALUE{ m_element->value<float>(m_element->outputs()[0]) };
   m_info->setText(QString::number(static_cast<qreal>(VALUE), 'f', 4));
 
   calculateBoundingRect();
@@ -48,7 +48,7 @@ ConstInt::ConstInt()
 void ConstInt::refreshCentralWidget()
 {
   if (!m_element) return;
-  int32_t const VALUE{ std::get<int32_t>(m_element->outputs()[0].value) };
+  int32_t const VALUE{ m_element->value<int32_t>(m_element->outputs()[0]) };
   m_info->setText(QString::number(VALUE));
 
   calculateBoundingRect();
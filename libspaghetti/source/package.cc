@@ -20,21 +20,114 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 // SOFTWARE.
 
+#include <algorithm>
+#include <exception>
 #include <fstream>
 #include <iostream>
+#include <map>
+#include <mutex>
 #include <string_view>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
 
 #include "spaghetti/package.h"
 
+#include "barrier.h"
+#include "checkpoint.h"
+#include "element_arena.h"
+#include "filesystem.h"
+#include "journal.h"
+#include "mapped_file.h"
+#include "package_binary.h"
+#include "package_cache.h"
+#include "package_loader.h"
+#include "package_snapshot.h"
+#include "package_writer.h"
 #include "elements/logic/clock.h"
+#include "partitioner.h"
+#include "realtime.h"
+#include "schedule_cache.h"
 #include "spaghetti/logger.h"
+#include "spaghetti/package_format.h"
+#include "spaghetti/recorder.h"
 #include "spaghetti/registry.h"
+#include "zlib_stream.h"
 
 namespace spaghetti {
 
+struct Package::PartitionPlan {
+  using clock_t = std::chrono::high_resolution_clock;
+
+  // Output of an element in one partition read by elements of another one,
+  // published to a boundary slot of the value store once per tick. Inputs in
+  // the reading partition are linked to that slot instead of the output.
+  struct Boundary {
+    size_t slot{};
+    Element *element{};
+    uint8_t socket{};
+  };
+
+  struct Partition {
+    Elements elements{};
+    std::vector<Boundary> exports{};
+  };
+
+  explicit PartitionPlan(size_t const a_partitions)
+    : barrier{ a_partitions }
+  {
+  }
+
+  std::vector<Partition> partitions{};
+  std::vector<uint32_t> partitionOf{};
+  std::vector<ValueStore::Index> boundary{};
+  std::vector<ValueType> boundaryTypes{};
+  Barrier barrier;
+  PartitionStats stats{};
+  // Bumped whenever edits extend the layout, a repartition job's result is only
+  // taken for the epoch it was started in.
+  size_t epoch{};
+  duration_t delta{};
+  clock_t::time_point last{ clock_t::now() };
+  bool quit{};
+};
+
+// A snapshot being written to temp next to filename, journalOffset is where the
+// journal stood when it was taken.
+struct Package::SaveJob {
+  std::string filename{};
+  std::string temp{};
+  size_t journalOffset{};
+  std::thread thread{};
+  bool written{};
+  uint64_t hash{};
+  size_t size{};
+};
+
+// partition_elements() run on a copy of the package taken between ticks, the
+// dispatch thread swaps the result in once it's done.
+struct Package::RepartitionJob {
+  std::thread thread{};
+  std::atomic_bool done{};
+  bool applied{};
+  size_t epoch{};
+  Partitioning result{};
+};
+
+namespace {
+
+enum RealtimeStatusBits : uint8_t { ePinned = 1 << 0, eFifo = 1 << 1, eMemoryLocked = 1 << 2, eAll = 0x7 };
+
+// Keeps small, freshly edited packages from being renumbered on every delete.
+size_t const MIN_HOLES_TO_COMPACT{ 64 };
+
+} // namespace
+
 Package::Package()
   : Element{}
+  , m_arena{ std::make_unique<ElementArena>() }
 {
+  m_values = &m_valueStore;
   m_elements.push_back(this);
 
   addInput(ValueType::eBool, "#1", IOSocket::eDefaultFlags);
@@ -46,8 +139,26 @@ Package::Package()
 
 Package::~Package()
 {
+  finishSave();
+  finishRepartition();
+  m_journal.reset();
+  if (Recorder *const recorder{ m_recorder }) recorder->forget(this);
+
+  // Sockets only hand their slots back when the store outlives this package,
+  // that is a nested package removed from a live parent. Element memory goes
+  // away with m_arena, slab by slab.
+  bool const STORE_OUTLIVES{ m_values && m_values != &m_valueStore };
+
   size_t const SIZE{ m_elements.size() };
-  for (size_t i = 1; i < SIZE; ++i) delete m_elements[i];
+  for (size_t i = 1; i < SIZE; ++i) {
+    Element *const element{ m_elements[i] };
+    if (!element) continue;
+
+    if (!STORE_OUTLIVES) element->m_values = nullptr;
+    element->~Element();
+  }
+
+  if (!STORE_OUTLIVES) m_values = nullptr;
 }
 
 void Package::serialize(Element::Json &a_json)
@@ -65,8 +176,13 @@ void Package::serialize(Element::Json &a_json)
   jsonPackage["path"] = m_packagePath;
   jsonPackage["icon"] = m_packageIcon;
 
+  if (m_reference) {
+    jsonPackage["reference"] = true;
+    return;
+  }
+
   auto jsonElements = Json::array();
-  // TODO(aljen): fix holes
+  // Holes are skipped, loading numbers elements densely and remaps connections by the saved ids.
   size_t const DATA_SIZE{ m_elements.size() };
   for (size_t i = 1; i < DATA_SIZE; ++i) {
     auto const element = m_elements[i];
@@ -96,6 +212,10 @@ void Package::serialize(Element::Json &a_json)
 
 void Package::deserialize(Json const &a_json)
 {
+  Journal::Entry const JOURNAL{ *this };
+  size_t const FIRST_ID{ m_elements.size() };
+  size_t const FIRST_CONNECTION{ m_connections.size() };
+
   Element::deserialize(a_json);
 
   auto const &NODE = a_json["node"];
@@ -107,8 +227,6 @@ void Package::deserialize(Json const &a_json)
   auto const OUTPUTS_POSITION_Y = OUTPUTS_POSITION["y"].get<double>();
 
   auto const &PACKAGE = a_json["package"];
-  auto const &ELEMENTS = PACKAGE["elements"];
-  auto const &CONNECTIONS = PACKAGE["connections"];
   auto const &DESCRIPTION = PACKAGE["description"].get<std::string>();
   auto const &ICON = PACKAGE["icon"].get<std::string>();
   auto const &PATH = PACKAGE["path"].get<std::string>();
@@ -119,39 +237,148 @@ void Package::deserialize(Json const &a_json)
   setInputsPosition(INPUTS_POSITION_X, INPUTS_POSITION_Y);
   setOutputsPosition(OUTPUTS_POSITION_X, OUTPUTS_POSITION_Y);
 
-  std::map<size_t, size_t> remappedIds{};
+  m_reference = PACKAGE.count("reference") && PACKAGE["reference"].get<bool>();
+  m_materialized = !m_reference;
+  if (!m_reference) deserializeContents(PACKAGE);
+
+  if (!JOURNAL) return;
 
-  for (auto const &TEMP : ELEMENTS) {
-    auto const &ELEMENT_GROUP = TEMP["element"];
-    auto const ELEMENT_TYPE = ELEMENT_GROUP["type"].get<std::string>();
-    auto const element = add(ELEMENT_TYPE.c_str());
-    auto const ELEMENT_ID = ELEMENT_GROUP["id"].get<size_t>();
-    auto const ADDED_ID = element->id();
-    element->deserialize(TEMP);
+  // The package's own fields go in as an empty package, its contents as the
+  // elements and connections they turned into. The log grows with what was
+  // added, not with the document it came from.
+  Json json = Json::object();
+  for (auto it = a_json.begin(); it != a_json.end(); ++it)
+    if (it.key() != "package") json[it.key()] = it.value();
+  for (auto it = PACKAGE.begin(); it != PACKAGE.end(); ++it)
+    if (it.key() != "elements" && it.key() != "connections") json["package"][it.key()] = it.value();
+  json["package"]["elements"] = Json::array();
+  json["package"]["connections"] = Json::array();
+  JOURNAL("deserialize", { { "package", json } });
 
-    remappedIds[ELEMENT_ID] = ADDED_ID;
+  size_t const SIZE{ m_elements.size() };
+  for (size_t i = FIRST_ID; i < SIZE; ++i) {
+    Element *const element{ m_elements[i] };
+    if (!element) continue;
+
+    Json jsonElement{};
+    element->serialize(jsonElement);
+    JOURNAL("add", { { "type", element->type() }, { "new_id", i }, { "element", jsonElement } });
   }
 
+  size_t const CONNECTIONS{ m_connections.size() };
+  for (size_t i = FIRST_CONNECTION; i < CONNECTIONS; ++i) {
+    auto const &CONNECTION = m_connections[i];
+    JOURNAL("connect", { { "from", CONNECTION.from_id },
+                         { "output", CONNECTION.from_socket },
+                         { "to", CONNECTION.to_id },
+                         { "input", CONNECTION.to_socket } });
+  }
+}
+
+void Package::deserializeContents(Json const &a_package)
+{
+  auto const &ELEMENTS = a_package["elements"];
+  auto const &CONNECTIONS = a_package["connections"];
+
+  std::map<size_t, size_t> remappedIds{ { 0, 0 } };
+
+  // Elements of types nobody registered, like those of a missing plugin, are skipped.
+  std::vector<size_t> known{};
+  std::vector<string::hash_t> types{};
+  known.reserve(ELEMENTS.size());
+  types.reserve(ELEMENTS.size());
+  for (size_t i = 0; i < ELEMENTS.size(); ++i) {
+    auto const &TYPE_NAME = ELEMENTS[i]["element"]["type"].get<std::string>();
+    string::hash_t const TYPE_HASH{ string::hash(TYPE_NAME) };
+    if (!Registry::get().hasElement(TYPE_HASH)) {
+      spaghetti::log::error("Unknown element type {}", TYPE_NAME);
+      continue;
+    }
+    known.push_back(i);
+    types.push_back(TYPE_HASH);
+  }
+
+  size_t const FIRST_ID{ addBulk(types, [&ELEMENTS, &known](size_t const a_index, Element &a_element) {
+    a_element.deserialize(ELEMENTS[known[a_index]]);
+  }) };
+
+  for (size_t i = 0; i < known.size(); ++i)
+    remappedIds[ELEMENTS[known[i]]["element"]["id"].get<size_t>()] = FIRST_ID + i;
+
   for (auto const &CONNECTION : CONNECTIONS) {
     auto const &FROM = CONNECTION["connect"];
     auto const &TO = CONNECTION["to"];
-    auto const &FROM_ID = remappedIds[FROM["id"].get<size_t>()];
+    auto const FROM_ID = remappedIds.find(FROM["id"].get<size_t>());
     auto const &FROM_SOCKET = FROM["socket"].get<uint8_t>();
-    auto const &TO_ID = remappedIds[TO["id"].get<size_t>()];
+    auto const TO_ID = remappedIds.find(TO["id"].get<size_t>());
     auto const &TO_SOCKET = TO["socket"].get<uint8_t>();
-    connect(FROM_ID, FROM_SOCKET, TO_ID, TO_SOCKET);
+    // A connection to a skipped element is dropped, a referenced file may have
+    // changed the sockets of the package using it.
+    if (FROM_ID == std::end(remappedIds) || TO_ID == std::end(remappedIds) ||
+        !canConnect(FROM_ID->second, FROM_SOCKET, TO_ID->second, TO_SOCKET)) {
+      spaghetti::log::error("Skipping connection {}@{} -> {}@{}", FROM["id"].get<size_t>(),
+                            static_cast<int>(FROM_SOCKET), TO["id"].get<size_t>(), static_cast<int>(TO_SOCKET));
+      continue;
+    }
+    connect(FROM_ID->second, FROM_SOCKET, TO_ID->second, TO_SOCKET);
+  }
+
+  m_dependencies.merge();
+}
+
+void Package::setReference(bool const a_reference)
+{
+  Journal::Entry const JOURNAL{ *this };
+  if (JOURNAL) JOURNAL("reference", { { "reference", a_reference } });
+
+  // A local copy saves the contents, they have to be there. An empty package
+  // turned into a reference gets them on first use.
+  if (!a_reference) materialize();
+  m_reference = a_reference;
+  if (m_reference && m_elements.size() == 1) m_materialized = false;
+}
+
+void Package::materialize()
+{
+  if (m_materialized) return;
+  m_materialized = true;
+
+  auto const DEFINITION = package_cache::definition(m_packagePath);
+  if (!DEFINITION) {
+    spaghetti::log::error("Can't load referenced package {}", m_packagePath);
+    return;
+  }
+
+  spaghetti::log::debug("Materializing package {}", m_packagePath);
+
+  // The contents come from the referenced file, there's nothing to journal.
+  Journal::Entry const JOURNAL{ *this };
+
+  pauseDispatchThread();
+
+  try {
+    deserializeContents(DEFINITION->at("package"));
+  } catch (std::exception const &a_exception) {
+    spaghetti::log::error("Referenced package {} is damaged: {}", m_packagePath, a_exception.what());
   }
+
+  resumeDispatchThread();
 }
 
 Element *Package::add(string::hash_t const a_hash)
 {
+  Journal::Entry const JOURNAL{ *this };
+
+  // New ids go after the referenced ones.
+  materialize();
+
   pauseDispatchThread();
 
   spaghetti::log::debug("Adding element..");
 
   spaghetti::Registry &registry{ spaghetti::Registry::get() };
 
-  Element *const element{ registry.createElement(a_hash) };
+  Element *const element{ registry.createElement(a_hash, *m_arena) };
   assert(element);
 
   size_t index{};
@@ -165,17 +392,130 @@ Element *Package::add(string::hash_t const a_hash)
     m_free.pop_back();
   }
 
-  element->m_package = this;
+  element->m_editor->package = this;
+  element->bindValueStore(m_values);
   element->m_id = index;
   element->reset();
 
+  m_partitionsDirty = true;
+
   resumeDispatchThread();
 
+  if (JOURNAL) JOURNAL("add", { { "type", element->type() }, { "new_id", index } });
+
   return element;
 }
 
+size_t Package::addBulk(std::vector<string::hash_t> const &a_types, BulkInit const &a_init)
+{
+  // Below this a load is over before the threads are up.
+  size_t const PARALLEL_MIN_ELEMENTS{ 4096 };
+  size_t const CHUNK_SIZE{ 256 };
+
+  // Nested packages of a parallel load are built by the worker that owns them.
+  static thread_local bool s_inWorker{};
+
+  pauseDispatchThread();
+
+  size_t const COUNT{ a_types.size() };
+  size_t const FIRST{ m_elements.size() };
+  m_elements.resize(FIRST + COUNT, nullptr);
+
+  spaghetti::Registry &registry{ spaghetti::Registry::get() };
+
+  std::atomic_size_t nextChunk{};
+  std::exception_ptr failure{};
+  std::mutex failureMutex{};
+
+  // Workers fill stores of their own and hand them over in one piece when done,
+  // the package store never grows under a concurrent write.
+  auto const BUILD = [&](ValueStore *const a_values) {
+    bool const STAGED{ a_values != m_values };
+    bool const WAS_IN_WORKER{ s_inWorker };
+    s_inWorker = s_inWorker || STAGED;
+
+    std::vector<Element *> built{};
+
+    for (size_t begin = nextChunk.fetch_add(CHUNK_SIZE); begin < COUNT; begin = nextChunk.fetch_add(CHUNK_SIZE)) {
+      size_t const END{ std::min(begin + CHUNK_SIZE, COUNT) };
+      for (size_t i = begin; i < END; ++i) {
+        try {
+          Element *const element{ registry.createElement(a_types[i], *m_arena) };
+          assert(element);
+
+          element->m_editor->package = this;
+          element->bindValueStore(a_values);
+          element->m_id = FIRST + i;
+          element->reset();
+          m_elements[FIRST + i] = element;
+          built.push_back(element);
+
+          a_init(i, *element);
+        } catch (...) {
+          std::lock_guard<std::mutex> lock{ failureMutex };
+          if (!failure) failure = std::current_exception();
+          nextChunk = COUNT;
+          break;
+        }
+      }
+    }
+
+    if (STAGED) {
+      auto const OFFSETS = m_values->append(*a_values);
+      for (Element *const element : built) rebase(*element, OFFSETS, m_values);
+    }
+
+    s_inWorker = WAS_IN_WORKER;
+  };
+
+  size_t const THREADS{ std::min<size_t>(std::thread::hardware_concurrency(), COUNT / CHUNK_SIZE) };
+  if (COUNT < PARALLEL_MIN_ELEMENTS || THREADS < 2 || s_inWorker) {
+    BUILD(m_values);
+  } else {
+    spaghetti::log::debug("Adding {} elements on {} threads..", COUNT, THREADS);
+
+    std::vector<std::thread> workers{};
+    workers.reserve(THREADS - 1);
+    for (size_t i = 1; i < THREADS; ++i) workers.emplace_back([&BUILD] {
+      ValueStore staging{};
+      BUILD(&staging);
+    });
+    ValueStore staging{};
+    BUILD(&staging);
+    for (auto &worker : workers) worker.join();
+  }
+
+  // Slots a failed batch never filled are free like any removed element's.
+  for (size_t i = FIRST; i < FIRST + COUNT; ++i)
+    if (!m_elements[i]) m_free.emplace_back(i);
+
+  m_partitionsDirty = true;
+
+  resumeDispatchThread();
+
+  if (failure) std::rethrow_exception(failure);
+
+  return FIRST;
+}
+
+void Package::rebase(Element &a_element, ValueStore::Offsets const &a_offsets, ValueStore *const a_values)
+{
+  for (auto &input : a_element.m_inputs) input.index += a_offsets.of(input.type);
+  for (auto &output : a_element.m_outputs) output.index += a_offsets.of(output.type);
+  a_element.m_values = a_values;
+
+  if (a_element.hash() != Package::HASH) return;
+
+  auto const &ELEMENTS = static_cast<Package &>(a_element).m_elements;
+  for (size_t i = 1; i < ELEMENTS.size(); ++i)
+    if (ELEMENTS[i]) rebase(*ELEMENTS[i], a_offsets, a_values);
+}
+
 void Package::remove(size_t const a_id)
 {
+  Journal::Entry const JOURNAL{ *this };
+  if (JOURNAL) JOURNAL("remove", { { "id", a_id } });
+
   pauseDispatchThread();
 
   spaghetti::log::debug("Removing element {}..", a_id);
@@ -184,11 +524,36 @@ void Package::remove(size_t const a_id)
   assert(a_id < m_elements.size());
   assert(std::find(std::begin(m_free), std::end(m_free), a_id) == std::end(m_free));
 
-  delete m_elements[a_id];
+  Element *const element{ m_elements[a_id] };
+
+  // Targets get slots of their own back and no connection is left pointing at the hole.
+  disconnectSockets(a_id, true, 0, element->m_inputs.size());
+  disconnectSockets(a_id, false, 0, element->m_outputs.size());
+
+  Package *root{ this };
+  while (root->package()) root = root->package();
+  if (Recorder *const recorder{ root->m_recorder }) {
+    root->pauseDispatchThread();
+    recorder->forget(element);
+    root->resumeDispatchThread();
+  }
+
+  string::hash_t const TYPE_HASH{ element->hash() };
+  void *const MEMORY{ dynamic_cast<void *>(element) };
+  Element::EditorData *const EDITOR{ element->m_editor->inArena ? element->m_editor.get() : nullptr };
+  element->~Element();
+  m_arena->deallocate(TYPE_HASH, MEMORY);
+  if (EDITOR) m_arena->deallocate(ElementArena::EDITOR_DATA, EDITOR);
   m_elements[a_id] = nullptr;
   m_free.emplace_back(a_id);
 
+  m_partitionsDirty = true;
+
   resumeDispatchThread();
+
+  // A replayed journal repeats the compaction where it was logged.
+  if (Journal::isReplaying()) return;
+  if (m_free.size() >= MIN_HOLES_TO_COMPACT && fragmentation() > m_compactionThreshold) compact();
 }
 
 Element *Package::get(size_t const a_id) const
@@ -198,9 +563,137 @@ Element *Package::get(size_t const a_id) const
   return m_elements[a_id];
 }
 
+void Package::compact()
+{
+  // Logged even from inside another edit, everything after it uses the new ids.
+  Journal::Entry const JOURNAL{ *this, true };
+  if (JOURNAL) JOURNAL("compact");
+
+  pauseDispatchThread();
+
+  size_t const SIZE{ m_elements.size() };
+
+  spaghetti::log::debug("Compacting {} elements with {} holes..", SIZE, m_free.size());
+
+  IdRemap remap(SIZE, INVALID_ID);
+  Elements elements{};
+  elements.reserve(SIZE - m_free.size());
+
+  for (size_t i = 0; i < SIZE; ++i) {
+    Element *const element{ m_elements[i] };
+    if (!element) continue;
+
+    remap[i] = elements.size();
+    element->m_id = elements.size();
+    elements.push_back(element);
+  }
+
+  m_elements = std::move(elements);
+  m_free.clear();
+
+  auto const DANGLING = std::remove_if(std::begin(m_connections), std::end(m_connections),
+                                       [&remap](Connection const &a_connection) {
+                                         return remap[a_connection.from_id] == INVALID_ID ||
+                                                remap[a_connection.to_id] == INVALID_ID;
+                                       });
+  m_connections.erase(DANGLING, std::end(m_connections));
+
+  m_dependencies.clear();
+  for (auto &&connection : m_connections) {
+    connection.from_id = remap[connection.from_id];
+    connection.to_id = remap[connection.to_id];
+    m_dependencies.add(connection.from_id, connection.to_id);
+  }
+  m_dependencies.merge();
+
+  for (auto &&element : m_elements) {
+    for (auto &&input : element->m_inputs) {
+      size_t const ID{ remap[input.id] };
+      input.id = ID == INVALID_ID ? 0 : ID;
+    }
+  }
+
+  // A layout prepared from the schedule cache is indexed by the old ids. The
+  // running one is carried over for rebuildPartitions() to extend, which also
+  // makes a repartition job started before this stale.
+  m_preparedPartitions.reset();
+  if (m_partitionPlan) {
+    auto &partitionOf = m_partitionPlan->partitionOf;
+    std::vector<uint32_t> remapped(m_elements.size());
+    for (size_t i = 0; i < SIZE && i < partitionOf.size(); ++i)
+      if (remap[i] != INVALID_ID) remapped[remap[i]] = partitionOf[i];
+    partitionOf = std::move(remapped);
+  }
+  m_partitionsDirty = true;
+
+  resumeDispatchThread();
+
+  if (m_compactionCallback) m_compactionCallback(remap);
+}
+
+float Package::fragmentation() const
+{
+  return static_cast<float>(m_free.size()) / static_cast<float>(m_elements.size());
+}
+
+Package::MemoryUsage Package::memoryUsage() const
+{
+  MemoryUsage usage{};
+  accumulateMemoryUsage(usage);
+  usage.nameBytes = string::memory_usage();
+  usage.lastLoadJsonBytes = m_lastLoadJsonBytes;
+
+  std::sort(std::begin(usage.elements), std::end(usage.elements),
+            [](auto const &a_lhs, auto const &a_rhs) { return a_lhs.bytes > a_rhs.bytes; });
+
+  return usage;
+}
+
+void Package::accumulateMemoryUsage(MemoryUsage &a_usage) const
+{
+  auto socketBytes = [](IOSockets const &a_sockets) {
+    return a_sockets.isInline() ? size_t{} : a_sockets.capacity() * sizeof(IOSocket);
+  };
+
+  size_t const SIZE{ m_elements.size() };
+  for (size_t i = 1; i < SIZE; ++i) {
+    Element const *const element{ m_elements[i] };
+    if (!element) continue;
+
+    size_t const SOCKETS{ socketBytes(element->m_inputs) + socketBytes(element->m_outputs) };
+    size_t const EDITOR{ sizeof(Element::EditorData) };
+
+    auto const TYPE_HASH = element->hash();
+    auto it = std::find_if(std::begin(a_usage.elements), std::end(a_usage.elements),
+                           [TYPE_HASH](auto const &a_type) { return a_type.hash == TYPE_HASH; });
+    if (it == std::end(a_usage.elements)) it = a_usage.elements.insert(it, { TYPE_HASH, element->type(), 0, 0 });
+
+    it->count++;
+    it->bytes += Registry::get().metaInfoFor(TYPE_HASH).elementSize + SOCKETS + EDITOR;
+
+    a_usage.socketBytes += SOCKETS;
+    // Arena held records are counted with the arena's slabs.
+    if (!element->m_editor->inArena) a_usage.editorBytes += EDITOR;
+
+    if (TYPE_HASH == Package::HASH) static_cast<Package const *>(element)->accumulateMemoryUsage(a_usage);
+  }
+
+  a_usage.arenaBytes += m_arena->memoryUsage() + m_elements.capacity() * sizeof(Element *) +
+                        m_free.capacity() * sizeof(size_t);
+  a_usage.valueBytes += m_valueStore.memoryUsage();
+  a_usage.connectionBytes += m_connections.capacity() * sizeof(Connection);
+  a_usage.dependencyBytes += m_dependencies.memoryUsage();
+}
+
 bool Package::connect(size_t const a_sourceId, uint8_t const a_outputId, size_t const a_targetId,
                       uint8_t const a_inputId)
 {
+  Journal::Entry const JOURNAL{ *this };
+  if (JOURNAL)
+    JOURNAL("connect",
+            { { "from", a_sourceId }, { "output", a_outputId }, { "to", a_targetId }, { "input", a_inputId } });
+
+  materialize();
   pauseDispatchThread();
 
   Element *const source{ get(a_sourceId) };
@@ -228,10 +721,11 @@ bool Package::connect(size_t const a_sourceId, uint8_t const a_outputId, size_t
                         static_cast<int32_t>(a_inputId), a_sourceId, source->name(), static_cast<int32_t>(a_outputId));
 
   m_connections.emplace_back(Connection{ a_sourceId, a_outputId, a_targetId, a_inputId });
+  link(m_connections.back());
+
+  m_dependencies.add(a_sourceId, a_targetId);
 
-  auto &dependencies = m_dependencies[a_sourceId];
-  auto const IT = std::find(std::begin(dependencies), std::end(dependencies), a_targetId);
-  if (IT == std::end(dependencies)) dependencies.push_back(a_targetId);
+  m_partitionsDirty = true;
 
   resumeDispatchThread();
 
@@ -241,6 +735,11 @@ bool Package::connect(size_t const a_sourceId, uint8_t const a_outputId, size_t
 bool Package::disconnect(size_t const a_sourceId, uint8_t const a_outputId, size_t const a_targetId,
                          uint8_t const a_inputId)
 {
+  Journal::Entry const JOURNAL{ *this };
+  if (JOURNAL)
+    JOURNAL("disconnect",
+            { { "from", a_sourceId }, { "output", a_outputId }, { "to", a_targetId }, { "input", a_inputId } });
+
   pauseDispatchThread();
 
   Element *const target{ get(a_targetId) };
@@ -251,38 +750,108 @@ bool Package::disconnect(size_t const a_sourceId, uint8_t const a_outputId, size
   auto &targetInput = target->m_inputs[a_inputId];
   targetInput.id = 0;
   targetInput.slot = 0;
+  if (a_targetId != 0) unlink(targetInput);
   resetIOSocketValue(targetInput);
 
   auto it = std::remove_if(std::begin(m_connections), std::end(m_connections), [=](Connection &a_connection) {
     return a_connection.from_id == a_sourceId && a_connection.from_socket == a_outputId &&
            a_connection.to_id == a_targetId && a_connection.to_socket == a_inputId;
   });
+  size_t const REMOVED{ static_cast<size_t>(std::distance(it, std::end(m_connections))) };
   m_connections.erase(it, std::end(m_connections));
 
-  auto &dependencies = m_dependencies[a_sourceId];
-  dependencies.erase(std::find(std::begin(dependencies), std::end(dependencies), a_targetId), std::end(dependencies));
+  for (size_t i = 0; i < REMOVED; ++i) m_dependencies.remove(a_sourceId, a_targetId);
+
+  m_partitionsDirty = true;
 
   resumeDispatchThread();
 
   return true;
 }
 
+void Package::link(Connection const &a_connection)
+{
+  // Sockets of the package itself are not linked, see connect().
+  if (a_connection.from_id == 0 || a_connection.to_id == 0) return;
+
+  auto const &OUTPUT = get(a_connection.from_id)->m_outputs[a_connection.from_socket];
+  auto &input = get(a_connection.to_id)->m_inputs[a_connection.to_socket];
+
+  if (!input.linked) m_values->release(input.type, input.index);
+  input.index = OUTPUT.index;
+  input.linked = true;
+}
+
+void Package::unlink(IOSocket &a_input)
+{
+  if (!a_input.linked) return;
+
+  auto const INDEX = m_values->allocate(a_input.type);
+  m_values->copy(a_input.type, a_input.index, INDEX);
+  a_input.index = INDEX;
+  a_input.linked = false;
+}
+
+void Package::disconnectSockets(size_t const a_id, bool const a_inputs, size_t const a_first, size_t const a_last)
+{
+  auto const AFFECTED = [=](Connection const &a_connection) {
+    size_t const ID{ a_inputs ? a_connection.to_id : a_connection.from_id };
+    size_t const SOCKET{ a_inputs ? a_connection.to_socket : a_connection.from_socket };
+    return ID == a_id && SOCKET >= a_first && SOCKET < a_last;
+  };
+
+  // Loading clears the sockets of every element, skip the scan when nothing is connected.
+  bool connected{};
+  if (a_inputs) {
+    auto const &INPUTS = m_elements[a_id]->m_inputs;
+    for (size_t i = a_first; i < a_last && i < INPUTS.size(); ++i) connected = connected || INPUTS[i].linked;
+    // Inputs fed by the package's own inputs aren't linked.
+    if (!connected)
+      m_dependencies.forEachTarget(0, [&](size_t const a_target) { connected = connected || a_target == a_id; });
+  } else {
+    m_dependencies.forEachTarget(a_id, [&connected](size_t const) { connected = true; });
+  }
+  if (!connected) return;
+
+  pauseDispatchThread();
+
+  for (auto const &CONNECTION : m_connections) {
+    if (!AFFECTED(CONNECTION)) continue;
+
+    Element *const target{ CONNECTION.to_id != 0 ? m_elements[CONNECTION.to_id] : nullptr };
+    if (target) {
+      auto &input = target->m_inputs[CONNECTION.to_socket];
+      input.id = 0;
+      input.slot = 0;
+      unlink(input);
+      resetIOSocketValue(input);
+    }
+    m_dependencies.remove(CONNECTION.from_id, CONNECTION.to_id);
+  }
+
+  m_connections.erase(std::remove_if(std::begin(m_connections), std::end(m_connections), AFFECTED),
+                      std::end(m_connections));
+
+  m_partitionsDirty = true;
+
+  resumeDispatchThread();
+}
+
 void Package::dispatchThreadFunction()
 {
+  if (m_dispatchPartitions > 1) {
+    dispatchPartitioned();
+    return;
+  }
+
+  applyRealtime(0);
+
   using clock_t = std::chrono::high_resolution_clock;
   auto last = clock_t::now();
 
   while (!m_quit) {
     auto const NOW = clock_t::now();
     auto const DELTA = NOW - last;
-    for (auto &&connection : m_connections) {
-      Element *const source{ get(connection.from_id) };
-      Element *const target{ get(connection.to_id) };
-
-      auto const &SOURCE_OUTPUTS = source->outputs();
-      auto &targetInputs = target->inputs();
-      targetInputs[connection.to_socket].value = SOURCE_OUTPUTS[connection.from_socket].value;
-    }
 
     for (auto &&element : m_elements) {
       if (!element) continue;
@@ -291,29 +860,341 @@ void Package::dispatchThreadFunction()
       element->calculate();
     }
 
+    if (Recorder *const recorder{ m_recorder.load(std::memory_order_acquire) }) recorder->sample();
+
     last = NOW;
-    std::this_thread::sleep_for(std::chrono::milliseconds(1));
-
-    if (m_pause) {
-      spaghetti::log::trace("Pause requested..");
-      m_paused = true;
-      spaghetti::log::trace("Pausing..");
-      while (m_pause) std::this_thread::yield();
-      m_paused = false;
-      spaghetti::log::trace("Pause stopped..");
+    waitForNextTick();
+
+    if (m_pause) waitWhilePaused();
+  }
+}
+
+void Package::dispatchPartitioned()
+{
+  size_t const PARTITIONS{ m_dispatchPartitions };
+
+  spaghetti::log::debug("Starting partitioned dispatch with {} partitions..", PARTITIONS);
+
+  m_partitionPlan = std::make_unique<PartitionPlan>(PARTITIONS);
+  // Not between ticks yet, edits since the layout was prepared are partitioned in full.
+  bool const PREPARED{ m_preparedPartitions && m_preparedPartitions->partitionOf.size() == m_elements.size() };
+  if (!PREPARED)
+    m_preparedPartitions = std::make_unique<Partitioning>(partition_elements(m_elements, m_connections, PARTITIONS));
+  rebuildPartitions();
+
+  std::vector<std::thread> workers{};
+  for (size_t i = 1; i < PARTITIONS; ++i) workers.emplace_back(&Package::dispatchPartition, this, i);
+
+  dispatchPartition(0);
+
+  for (auto &&worker : workers) worker.join();
+
+  for (auto const &CONNECTION : m_connections) link(CONNECTION);
+
+  size_t const BOUNDARY_SIZE{ m_partitionPlan->boundary.size() };
+  for (size_t i = 0; i < BOUNDARY_SIZE; ++i)
+    m_values->release(m_partitionPlan->boundaryTypes[i], m_partitionPlan->boundary[i]);
+  m_partitionPlan.reset();
+}
+
+void Package::dispatchPartition(size_t const a_index)
+{
+  auto &plan = *m_partitionPlan;
+
+  applyRealtime(a_index);
+
+  auto tickCompleted = [this, &plan] {
+    if (Recorder *const recorder{ m_recorder.load(std::memory_order_acquire) }) recorder->sample();
+
+    waitForNextTick();
+
+    if (m_pause) waitWhilePaused();
+
+    if (m_partitionsDirty) rebuildPartitions();
+    updateRepartition();
+
+    auto const NOW = PartitionPlan::clock_t::now();
+    plan.delta = NOW - plan.last;
+    plan.last = NOW;
+    plan.quit = m_quit;
+  };
+
+  auto &values = *m_values;
+
+  while (!plan.quit) {
+    auto &partition = plan.partitions[a_index];
+
+    for (auto &&element : partition.elements) {
+      element->update(plan.delta);
+      element->calculate();
     }
+
+    plan.barrier.wait();
+
+    for (auto const &EXPORT : partition.exports)
+      values.copy(plan.boundaryTypes[EXPORT.slot], EXPORT.element->outputs()[EXPORT.socket].index,
+                  plan.boundary[EXPORT.slot]);
+
+    plan.barrier.wait(tickCompleted);
   }
 }
 
+void Package::rebuildPartitions()
+{
+  auto &plan = *m_partitionPlan;
+  size_t const PARTITIONS{ plan.barrier.count() };
+
+  // The layout the package was opened or started with comes from the cache. After
+  // edits the previous one is extended here and a proper one is worked out by a
+  // repartition job, off this thread.
+  bool const PREPARED{ m_preparedPartitions && m_preparedPartitions->loads.size() == PARTITIONS &&
+                       m_preparedPartitions->partitionOf.size() == m_elements.size() };
+  if (PREPARED) {
+    applyPartitioning(*m_preparedPartitions);
+  } else {
+    applyPartitioning(extend_partitioning(plan.partitionOf, m_elements, m_connections, PARTITIONS));
+    plan.epoch++;
+  }
+  m_preparedPartitions.reset();
+}
+
+void Package::applyPartitioning(Partitioning const &a_result)
+{
+  auto &plan = *m_partitionPlan;
+  size_t const PARTITIONS{ plan.barrier.count() };
+
+  plan.partitionOf = a_result.partitionOf;
+  plan.partitions.assign(PARTITIONS, {});
+  size_t const BOUNDARY_SIZE{ plan.boundary.size() };
+  for (size_t i = 0; i < BOUNDARY_SIZE; ++i) m_values->release(plan.boundaryTypes[i], plan.boundary[i]);
+  plan.boundary.clear();
+  plan.boundaryTypes.clear();
+
+  size_t const SIZE{ m_elements.size() };
+  for (size_t i = 0; i < SIZE; ++i)
+    if (m_elements[i]) plan.partitions[a_result.partitionOf[i]].elements.push_back(m_elements[i]);
+
+  // One boundary slot per source socket and reading partition, so fan-out to
+  // many elements of the same partition is exchanged only once.
+  std::map<std::tuple<size_t, uint8_t, uint32_t>, size_t> slots{};
+  for (auto const &CONNECTION : m_connections) {
+    if (CONNECTION.from_id == 0 || CONNECTION.to_id == 0) continue;
+
+    uint32_t const FROM{ a_result.partitionOf[CONNECTION.from_id] };
+    uint32_t const TO{ a_result.partitionOf[CONNECTION.to_id] };
+
+    if (FROM == TO) {
+      link(CONNECTION);
+      continue;
+    }
+
+    auto const KEY = std::make_tuple(CONNECTION.from_id, CONNECTION.from_socket, TO);
+    auto it = slots.find(KEY);
+    if (it == std::end(slots)) {
+      Element *const source{ get(CONNECTION.from_id) };
+      auto const &OUTPUT = source->outputs()[CONNECTION.from_socket];
+      size_t const SLOT{ plan.boundary.size() };
+      plan.boundary.push_back(m_values->allocate(OUTPUT.type));
+      plan.boundaryTypes.push_back(OUTPUT.type);
+      m_values->copy(OUTPUT.type, OUTPUT.index, plan.boundary.back());
+      plan.partitions[FROM].exports.push_back({ SLOT, source, CONNECTION.from_socket });
+      it = slots.emplace(KEY, SLOT).first;
+    }
+
+    auto &input = get(CONNECTION.to_id)->m_inputs[CONNECTION.to_socket];
+    if (!input.linked) m_values->release(input.type, input.index);
+    input.index = plan.boundary[it->second];
+    input.linked = true;
+  }
+
+  plan.stats = PartitionStats{ PARTITIONS, a_result.cutSize, a_result.imbalance };
+  m_partitionsDirty = false;
+
+  spaghetti::log::info("Partitioned into {} parts, cut connections: {}, load imbalance: {:.1f}%", PARTITIONS,
+                       a_result.cutSize, a_result.imbalance * 100.0);
+}
+
+void Package::updateRepartition()
+{
+  auto &plan = *m_partitionPlan;
+  RepartitionJob *const JOB{ m_repartition.get() };
+
+  // One job at a time, edits made while it runs are left to the next one.
+  if (JOB && !JOB->done.load(std::memory_order_acquire)) return;
+
+  if (JOB && JOB->epoch == plan.epoch) {
+    if (!JOB->applied) {
+      JOB->applied = true;
+      applyPartitioning(JOB->result);
+    }
+    return;
+  }
+
+  // Not edited since dispatch started, the layout is a full one already.
+  if (plan.epoch == 0) return;
+
+  startRepartition();
+}
+
+void Package::startRepartition()
+{
+  finishRepartition();
+
+  auto job = std::make_unique<RepartitionJob>();
+  job->epoch = m_partitionPlan->epoch;
+  job->thread = std::thread([pending = job.get(), costs = element_costs(m_elements), connections = m_connections,
+                             PARTITIONS = m_dispatchPartitions] {
+    pending->result = partition_elements(costs, connections, PARTITIONS);
+    pending->done.store(true, std::memory_order_release);
+  });
+  m_repartition = std::move(job);
+}
+
+void Package::finishRepartition()
+{
+  if (!m_repartition) return;
+
+  m_repartition->thread.join();
+  m_repartition.reset();
+}
+
+void Package::preparePartitions()
+{
+  if (m_dispatchPartitions < 2) return;
+
+  m_preparedPartitions =
+      std::make_unique<Partitioning>(schedule_cache::partition(m_elements, m_connections, m_dispatchPartitions));
+  m_partitionsDirty = true;
+}
+
+void Package::applyRealtime(size_t const a_index)
+{
+  if (!m_realtimeOptions.enabled) return;
+
+  auto const STATUS = apply_realtime(m_realtimeOptions, a_index);
+
+  // Memory is locked once in startDispatchThread(), not per thread.
+  uint8_t bits{ eMemoryLocked };
+  if (STATUS.pinned) bits |= ePinned;
+  if (STATUS.fifo) bits |= eFifo;
+  m_realtimeStatus &= bits;
+}
+
+void Package::waitForNextTick()
+{
+  using clock_t = std::chrono::steady_clock;
+
+  auto const PERIOD = m_tickOptions.period;
+  clock_t::time_point deadline{};
+
+  if (m_tickOptions.highResolution) {
+    // Absolute deadlines don't accumulate drift, after an overrun of a whole
+    // period the schedule restarts instead of bursting to catch up.
+    auto const NOW = clock_t::now();
+    m_tickDeadline += PERIOD;
+    if (m_tickDeadline + PERIOD < NOW) m_tickDeadline = NOW + PERIOD;
+    deadline = m_tickDeadline;
+    precise_sleep_until(deadline, m_tickOptions.spin);
+  } else {
+    deadline = clock_t::now() + PERIOD;
+    std::this_thread::sleep_for(PERIOD);
+  }
+
+  auto const WOKE_UP = clock_t::now();
+
+  int64_t const LATENCY{ std::chrono::duration_cast<std::chrono::nanoseconds>(WOKE_UP - deadline).count() };
+  int64_t worst{ m_worstWakeUpLatency };
+  while (LATENCY > worst && !m_worstWakeUpLatency.compare_exchange_weak(worst, LATENCY)) {
+  }
+
+  if (m_lastWakeUp != clock_t::time_point{}) {
+    int64_t const ACHIEVED{ std::chrono::duration_cast<std::chrono::nanoseconds>(WOKE_UP - m_lastWakeUp).count() };
+    int64_t const AVERAGE{ m_measuredTickPeriod };
+    m_measuredTickPeriod = AVERAGE == 0 ? ACHIEVED : AVERAGE + (ACHIEVED - AVERAGE) / 16;
+  }
+  m_lastWakeUp = WOKE_UP;
+}
+
+void Package::setTickOptions(TickOptions const &a_options)
+{
+  pauseDispatchThread();
+
+  m_tickOptions = a_options;
+  m_tickOptions.period = std::max(m_tickOptions.period, std::chrono::nanoseconds{ 1000 });
+  m_tickOptions.spin = std::clamp(m_tickOptions.spin, std::chrono::nanoseconds{}, m_tickOptions.period);
+  m_tickDeadline = std::chrono::steady_clock::now();
+  m_lastWakeUp = {};
+  m_measuredTickPeriod = 0;
+
+  resumeDispatchThread();
+}
+
+Package::RealtimeStatus Package::realtimeStatus() const
+{
+  uint8_t const BITS{ m_realtimeStatus };
+  return RealtimeStatus{ (BITS & ePinned) != 0, (BITS & eFifo) != 0, (BITS & eMemoryLocked) != 0 };
+}
+
+void Package::setDispatchPartitions(size_t const a_partitions)
+{
+  size_t const PARTITIONS{ std::max<size_t>(a_partitions, 1) };
+  if (PARTITIONS == m_dispatchPartitions) return;
+
+  bool const RESTART{ m_dispatchThreadStarted };
+  if (RESTART) quitDispatchThread();
+
+  m_dispatchPartitions = PARTITIONS;
+  m_partitionsDirty = true;
+
+  if (RESTART) startDispatchThread();
+}
+
+Package::PartitionStats Package::partitionStats()
+{
+  pauseDispatchThread();
+
+  PartitionStats stats{};
+  if (m_partitionPlan) {
+    stats = m_partitionPlan->stats;
+  } else if (m_dispatchPartitions > 1) {
+    Partitioning result{};
+    if (!schedule_cache::lookup(m_elements, m_connections, m_dispatchPartitions, result))
+      result = partition_elements(m_elements, m_connections, m_dispatchPartitions);
+    stats = PartitionStats{ m_dispatchPartitions, result.cutSize, result.imbalance };
+  }
+
+  resumeDispatchThread();
+
+  return stats;
+}
+
 void Package::startDispatchThread()
 {
   if (m_dispatchThreadStarted) return;
 
+  materialize();
+  preparePartitions();
+
   spaghetti::log::trace("Starting dispatch thread..");
+  m_quit = false;
+  m_worstWakeUpLatency = 0;
+  m_tickDeadline = std::chrono::steady_clock::now();
+  m_lastWakeUp = {};
+  m_measuredTickPeriod = 0;
+  m_memoryLocked = m_realtimeOptions.enabled && m_realtimeOptions.lockMemory && lock_memory();
+  m_realtimeStatus = m_realtimeOptions.enabled ? (m_memoryLocked ? eAll : ePinned | eFifo) : 0;
   m_dispatchThread = std::thread(&Package::dispatchThreadFunction, this);
   m_dispatchThreadStarted = true;
 }
 
+void Package::startDispatchThread(RealtimeOptions const &a_options)
+{
+  if (m_dispatchThreadStarted) return;
+
+  setRealtimeOptions(a_options);
+  startDispatchThread();
+}
+
 void Package::quitDispatchThread()
 {
   if (!m_dispatchThreadStarted) return;
@@ -322,7 +1203,8 @@ void Package::quitDispatchThread()
 
   if (m_pause) {
     spaghetti::log::trace("Dispatch thread paused, waiting..");
-    while (m_pause) std::this_thread::yield();
+    std::unique_lock<std::mutex> lock{ m_pauseMutex };
+    m_pauseChanged.wait(lock, [this] { return !m_pause; });
   }
 
   m_quit = true;
@@ -331,25 +1213,39 @@ void Package::quitDispatchThread()
     m_dispatchThread.join();
     spaghetti::log::trace("After dispatch thread join..");
   }
+  finishRepartition();
+  if (m_memoryLocked) {
+    unlock_memory();
+    m_memoryLocked = false;
+  }
   m_dispatchThreadStarted = false;
 }
 
 void Package::pauseDispatchThread()
 {
+  // A nested package's slots are read by the dispatch thread of the store's owner.
+  Package *const OWNER{ storeOwner() };
+  if (OWNER != this) OWNER->pauseDispatchThread();
+
   m_pauseCount++;
 
   spaghetti::log::trace("Trying to pause dispatch thread ({})..", m_pauseCount.load());
 
   if (m_pauseCount > 1) return;
-
-  m_pause = true;
+  if (!m_dispatchThreadStarted) return;
 
   spaghetti::log::trace("Pausing dispatch thread ({})..", m_pauseCount.load());
-  while (!m_paused) std::this_thread::yield();
+
+  std::unique_lock<std::mutex> lock{ m_pauseMutex };
+  m_pause = true;
+  m_pauseChanged.wait(lock, [this] { return m_paused.load(); });
 }
 
 void Package::resumeDispatchThread()
 {
+  Package *const OWNER{ storeOwner() };
+  if (OWNER != this) OWNER->resumeDispatchThread();
+
   m_pauseCount--;
 
   spaghetti::log::trace("Trying to resume dispatch thread ({})..", m_pauseCount.load());
@@ -358,7 +1254,31 @@ void Package::resumeDispatchThread()
 
   spaghetti::log::trace("Resuming dispatch thread ({})..", m_pauseCount.load());
 
-  m_pause = false;
+  {
+    std::lock_guard<std::mutex> lock{ m_pauseMutex };
+    m_pause = false;
+  }
+  m_pauseChanged.notify_all();
+}
+
+Package *Package::storeOwner()
+{
+  Package *owner{ this };
+  while (owner->m_values != &owner->m_valueStore && owner->package()) owner = owner->package();
+  return owner;
+}
+
+void Package::waitWhilePaused()
+{
+  spaghetti::log::trace("Pausing..");
+
+  std::unique_lock<std::mutex> lock{ m_pauseMutex };
+  m_paused = true;
+  m_pauseChanged.notify_all();
+  m_pauseChanged.wait(lock, [this] { return !m_pause; });
+  m_paused = false;
+
+  spaghetti::log::trace("Pause stopped..");
 }
 
 void Package::open(std::string const &a_filename)
@@ -367,30 +1287,397 @@ void Package::open(std::string const &a_filename)
 
   pauseDispatchThread();
 
-  std::ifstream file{ a_filename };
-  if (!file.is_open()) return;
+  m_journal.reset();
+  openSnapshot(a_filename);
 
-  Json json{};
-  file >> json;
+  // Nested packages are journaled along with the root they live in.
+  if (!package()) {
+    auto journal = std::make_unique<Journal>(a_filename);
+    journal->replay(*this);
+    m_journal = std::move(journal);
+  }
 
-  deserialize(json);
+  if (m_dispatchThreadStarted) preparePartitions();
 
   resumeDispatchThread();
 }
 
-void Package::save(std::string const &a_filename)
+void Package::openSnapshot(std::string const &a_filename)
+{
+  if (package_format::format_for(a_filename) == package_format::Format::eBinary)
+    openBinary(a_filename);
+  else
+    openJson(a_filename);
+}
+
+void Package::openJson(std::string const &a_filename)
+{
+  std::ifstream file{ a_filename, std::ios::binary };
+  if (!file.is_open()) return;
+
+  auto const LOAD = [this, &a_filename](std::istream &a_stream) {
+    PackageLoader loader{ a_stream };
+    try {
+      loader.load(*this);
+    } catch (std::exception const &a_exception) {
+      spaghetti::log::error("Can't load {}: {}", a_filename, a_exception.what());
+    }
+
+    m_lastLoadJsonBytes = loader.peakBytes();
+  };
+
+  // Compressed packages are inflated a chunk at a time as the loader asks for more.
+  if (package_format::format_for(a_filename) == package_format::Format::eCompressed) {
+    InflateBuffer inflate{ file };
+    std::istream stream{ &inflate };
+    LOAD(stream);
+  } else
+    LOAD(file);
+}
+
+void Package::openBinary(std::string const &a_filename)
+{
+  std::error_code error{};
+  MappedFile const MAPPED{ a_filename, error };
+  if (error) return;
+
+  binary::View view{ MAPPED.data(), MAPPED.size() };
+  if (!view.validate()) {
+    spaghetti::log::error("{} is not a valid binary package", a_filename);
+    return;
+  }
+
+  m_lastLoadJsonBytes = 0;
+
+  // Records are validated, but CBOR extras are only decoded on demand.
+  try {
+    load(view, 0);
+  } catch (std::exception const &a_exception) {
+    spaghetti::log::error("{} is damaged: {}", a_filename, a_exception.what());
+  }
+}
+
+void Package::load(binary::View const &a_view, uint32_t const a_package)
+{
+  auto const &PACKAGE = a_view.package(a_package);
+
+  loadElement(*this, a_view, PACKAGE.element);
+  setPackageDescription(std::string{ a_view.string(PACKAGE.description) });
+  setPackageIcon(std::string{ a_view.string(PACKAGE.icon) });
+  setPackagePath(std::string{ a_view.string(PACKAGE.path) });
+  setInputsPosition(PACKAGE.inputsX, PACKAGE.inputsY);
+  setOutputsPosition(PACKAGE.outputsX, PACKAGE.outputsY);
+
+  auto const &RECORD = a_view.element(PACKAGE.element);
+  if (RECORD.extraSize) {
+    auto const EXTRAS = a_view.extras(PACKAGE.element);
+    auto const EXTRA_PACKAGE = EXTRAS.find("package");
+    m_reference = EXTRA_PACKAGE != EXTRAS.end() && EXTRA_PACKAGE->value("reference", false);
+    m_materialized = !m_reference;
+    if (m_reference) return;
+  }
+
+  Registry const &registry{ Registry::get() };
+
+  // Id 0 is the package itself, its inputs and outputs are the boundary.
+  std::unordered_map<uint64_t, size_t> remappedIds{ { 0, 0 } };
+  remappedIds.reserve(PACKAGE.elementCount + 1);
+
+  std::vector<string::hash_t> types{};
+  std::vector<uint32_t> indices{};
+  types.reserve(PACKAGE.elementCount);
+  indices.reserve(PACKAGE.elementCount);
+
+  for (uint32_t i = 0; i < PACKAGE.elementCount; ++i) {
+    uint32_t const INDEX{ PACKAGE.firstElement + i };
+    auto const TYPE_NAME = a_view.string(a_view.element(INDEX).type);
+    auto const TYPE_HASH = string::hash(TYPE_NAME);
+
+    if (!registry.hasElement(TYPE_HASH)) {
+      spaghetti::log::error("Unknown element type {}", std::string{ TYPE_NAME });
+      continue;
+    }
+
+    types.push_back(TYPE_HASH);
+    indices.push_back(INDEX);
+  }
+
+  size_t const FIRST_ID{ addBulk(types, [&a_view, &indices](size_t const a_index, Element &a_element) {
+    uint32_t const INDEX{ indices[a_index] };
+    auto const &ELEMENT_RECORD = a_view.element(INDEX);
+
+    // Only elements with keys of their own go through the JSON path.
+    if (a_element.hash() == Package::HASH) {
+      if (ELEMENT_RECORD.package != binary::NONE)
+        static_cast<Package &>(a_element).load(a_view, ELEMENT_RECORD.package);
+      else
+        loadElement(a_element, a_view, INDEX);
+    } else if (ELEMENT_RECORD.extraSize)
+      a_element.deserialize(binary::element_json(a_view, INDEX));
+    else
+      loadElement(a_element, a_view, INDEX);
+  }) };
+
+  for (size_t i = 0; i < indices.size(); ++i) remappedIds[a_view.element(indices[i]).id] = FIRST_ID + i;
+
+  for (uint32_t i = 0; i < PACKAGE.connectionCount; ++i) {
+    auto const &CONNECTION = a_view.connection(PACKAGE.firstConnection + i);
+    auto const FROM = remappedIds.find(CONNECTION.from);
+    auto const TO = remappedIds.find(CONNECTION.to);
+    if (FROM == std::end(remappedIds) || TO == std::end(remappedIds)) {
+      spaghetti::log::error("Skipping connection {} -> {}, missing element", CONNECTION.from, CONNECTION.to);
+      continue;
+    }
+
+    if (!canConnect(FROM->second, CONNECTION.fromSocket, TO->second, CONNECTION.toSocket)) {
+      spaghetti::log::error("Skipping connection {} -> {}, socket mismatch", CONNECTION.from, CONNECTION.to);
+      continue;
+    }
+    connect(FROM->second, CONNECTION.fromSocket, TO->second, CONNECTION.toSocket);
+  }
+
+  m_dependencies.merge();
+}
+
+bool Package::canConnect(size_t const a_sourceId, uint8_t const a_outputId, size_t const a_targetId,
+                         uint8_t const a_inputId) const
+{
+  // Id 0 is the package itself, its inputs feed elements and elements feed its outputs.
+  IOSockets const &SOURCES{ a_sourceId == 0 ? static_cast<IOSockets const &>(m_inputs) : get(a_sourceId)->m_outputs };
+  IOSockets const &TARGETS{ a_targetId == 0 ? static_cast<IOSockets const &>(m_outputs) : get(a_targetId)->m_inputs };
+  return a_outputId < SOURCES.size() && a_inputId < TARGETS.size() &&
+         SOURCES[a_outputId].type == TARGETS[a_inputId].type;
+}
+
+void Package::loadElement(Element &a_element, binary::View const &a_view, uint32_t const a_index)
+{
+  auto const &RECORD = a_view.element(a_index);
+
+  a_element.setName(std::string{ a_view.string(RECORD.name) });
+  a_element.setPosition(RECORD.x, RECORD.y);
+  a_element.clearInputs();
+  a_element.clearOutputs();
+  a_element.setMinInputs(RECORD.minInputs);
+  a_element.setMaxInputs(RECORD.maxInputs);
+  a_element.setMinOutputs(RECORD.minOutputs);
+  a_element.setMaxOutputs(RECORD.maxOutputs);
+  a_element.setDefaultNewInputFlags(RECORD.defaultNewInputFlags);
+  a_element.setDefaultNewOutputFlags(RECORD.defaultNewOutputFlags);
+  a_element.iconify(RECORD.iconify != 0);
+
+  uint32_t const INPUTS_END{ RECORD.firstSocket + RECORD.inputs };
+  uint32_t const OUTPUTS_END{ INPUTS_END + RECORD.outputs };
+  for (uint32_t i = RECORD.firstSocket; i < OUTPUTS_END; ++i) {
+    auto const &SOCKET = a_view.socket(i);
+    auto const TYPE = static_cast<ValueType>(SOCKET.type);
+    std::string const NAME{ a_view.string(SOCKET.name) };
+    i < INPUTS_END ? a_element.addInput(TYPE, NAME, SOCKET.flags) : a_element.addOutput(TYPE, NAME, SOCKET.flags);
+  }
+}
+
+void Package::save(std::string const &a_filename, bool const a_compact)
+{
+  startSave(a_filename, a_compact);
+  finishSave();
+}
+
+void Package::startSave(std::string const &a_filename, bool const a_compact, SaveCallback a_callback)
 {
   spaghetti::log::debug("Saving package {}", a_filename);
 
+  finishSave();
+
+  // Loading numbers elements consecutively, a journal started now has to use
+  // the ids the next open() hands out.
   pauseDispatchThread();
+  compactTree();
+  auto snapshot = std::make_unique<PackageSnapshot>(*this);
+  resumeDispatchThread();
 
-  Json json{};
-  serialize(json);
+  auto job = std::make_unique<SaveJob>();
+  job->filename = a_filename;
+  job->temp = a_filename + ".saving";
 
-  std::ofstream file{ a_filename };
-  file << json.dump(2);
+  if (!package()) {
+    if (!m_journal || m_journal->path() != a_filename + Journal::EXTENSION)
+      m_journal = std::make_unique<Journal>(a_filename);
+    job->journalOffset = m_journal->mark();
+  }
+
+  package_format::Format const FORMAT{ package_format::format_for(a_filename) };
+  SaveJob &saving{ *job };
+  job->thread = std::thread{ [&saving, FORMAT, a_compact, snapshot = std::move(snapshot), a_callback] {
+    saving.written = writeSnapshot(*snapshot, saving.temp, FORMAT, a_compact);
+    saving.written = saving.written && Journal::hashFile(saving.temp, saving.hash, saving.size);
+    if (a_callback) a_callback(saving.written);
+  } };
+
+  m_save = std::move(job);
+}
+
+bool Package::finishSave()
+{
+  if (!m_save) return false;
+
+  auto const JOB = std::move(m_save);
+  JOB->thread.join();
+
+  bool saved{ JOB->written };
+  if (saved && m_journal)
+    saved = m_journal->rebase(JOB->temp, JOB->hash, JOB->size, JOB->journalOffset);
+  else if (saved) {
+    try {
+      fs::rename(JOB->temp, JOB->filename);
+    } catch (std::exception const &a_exception) {
+      spaghetti::log::error("Can't replace {}: {}", JOB->filename, a_exception.what());
+      saved = false;
+    }
+  }
+
+  if (!saved) {
+    spaghetti::log::error("Saving {} failed", JOB->filename);
+    std::remove(JOB->temp.c_str());
+  }
+
+  return saved;
+}
+
+bool Package::autosave()
+{
+  if (!m_journal) return false;
+
+  // Compacting would race the snapshot a save in flight puts in place.
+  return m_save ? m_journal->flush() : m_journal->autosave(*this);
+}
+
+void Package::compactJournal()
+{
+  if (m_journal && !m_save) m_journal->startCompaction(*this);
+}
+
+std::vector<uint8_t> Package::checkpoint()
+{
+  pauseDispatchThread();
+
+  std::vector<uint8_t> buffer{};
+  Checkpoint::save(*this, buffer);
 
   resumeDispatchThread();
+
+  return buffer;
+}
+
+bool Package::restore(uint8_t const *const a_data, size_t const a_size)
+{
+  pauseDispatchThread();
+  bool const RESTORED{ Checkpoint::restore(*this, a_data, a_size) };
+  resumeDispatchThread();
+
+  return RESTORED;
+}
+
+bool Package::saveCheckpoint(std::string const &a_filename)
+{
+  auto const BUFFER = checkpoint();
+
+  // A crash mid-write keeps the previous checkpoint.
+  std::string const TEMP{ a_filename + ".tmp" };
+  {
+    std::ofstream file{ TEMP, std::ios::binary | std::ios::trunc };
+    file.write(reinterpret_cast<char const *>(BUFFER.data()), static_cast<std::streamsize>(BUFFER.size()));
+    if (!file.good()) {
+      spaghetti::log::error("Can't write checkpoint {}", TEMP);
+      return false;
+    }
+  }
+
+  try {
+    fs::rename(TEMP, a_filename);
+  } catch (std::exception const &a_exception) {
+    spaghetti::log::error("Can't write checkpoint {}: {}", a_filename, a_exception.what());
+    return false;
+  }
+
+  return true;
+}
+
+bool Package::loadCheckpoint(std::string const &a_filename)
+{
+  std::error_code error{};
+  MappedFile const MAPPED{ a_filename, error };
+  if (error) {
+    spaghetti::log::error("Can't open checkpoint {}: {}", a_filename, error.message());
+    return false;
+  }
+
+  return restore(MAPPED.data(), MAPPED.size());
+}
+
+void Package::compactTree()
+{
+  if (!m_free.empty()) compact();
+
+  for (auto &&element : m_elements)
+    if (element != this && element->hash() == HASH) static_cast<Package *>(element)->compactTree();
+}
+
+bool Package::saveSnapshot(std::string const &a_filename, package_format::Format const a_format,
+                           bool const a_compact)
+{
+  return writeSnapshot(PackageSnapshot{ *this }, a_filename, a_format, a_compact);
+}
+
+bool Package::writeSnapshot(PackageSnapshot const &a_snapshot, std::string const &a_filename,
+                            package_format::Format const a_format, bool const a_compact)
+{
+  if (a_format == package_format::Format::eBinary) {
+    std::vector<uint8_t> binary{};
+    if (!binary::snapshot_to_binary(a_snapshot, binary)) {
+      spaghetti::log::error("Can't convert {}", a_filename);
+      return false;
+    }
+
+    std::ofstream file{ a_filename, std::ios::binary };
+    file.write(reinterpret_cast<char const *>(binary.data()), static_cast<std::streamsize>(binary.size()));
+    if (!file) spaghetti::log::error("Can't write {}", a_filename);
+    return static_cast<bool>(file);
+  }
+
+  if (a_format == package_format::Format::eCompressed) {
+    std::ofstream file{ a_filename, std::ios::binary };
+    DeflateBuffer deflate{ file };
+    std::ostream stream{ &deflate };
+    PackageWriter writer{ stream, a_compact };
+    writer.write(a_snapshot);
+    bool const WRITTEN{ stream && deflate.finish() };
+    if (!WRITTEN) spaghetti::log::error("Can't write {}", a_filename);
+    return WRITTEN;
+  }
+
+  // Written as it's walked, no document of the whole package in between.
+  std::ofstream file{ a_filename };
+  PackageWriter writer{ file, a_compact };
+  writer.write(a_snapshot);
+  if (!file) spaghetti::log::error("Can't write {}", a_filename);
+  return static_cast<bool>(file);
+}
+
+void Package::setInputsPosition(double const a_x, double const a_y)
+{
+  Journal::Entry const JOURNAL{ *this };
+  if (JOURNAL) JOURNAL("inputs_position", { { "x", a_x }, { "y", a_y } });
+
+  m_inputsPosition.x = a_x;
+  m_inputsPosition.y = a_y;
+}
+
+void Package::setOutputsPosition(double const a_x, double const a_y)
+{
+  Journal::Entry const JOURNAL{ *this };
+  if (JOURNAL) JOURNAL("outputs_position", { { "x", a_x }, { "y", a_y } });
+
+  m_outputsPosition.x = a_x;
+  m_outputsPosition.y = a_y;
 }
 
 } // namespace spaghetti
@@ -0,0 +1,181 @@
+// MIT License
+//
+// Copyright (c) 2017-2018 Artur Wyszyński, aljen at hitomi dot pl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+#ifndef SPAGHETTI_PACKAGE_BINARY_H
+#define SPAGHETTI_PACKAGE_BINARY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "spaghetti/element.h"
+
+namespace spaghetti {
+class PackageSnapshot;
+} // namespace spaghetti
+
+namespace spaghetti::binary {
+
+// Layout of a .package.bin image, native endian, every section 8 byte aligned:
+//
+//   Header | packages | elements | sockets | connections | strings | blobs
+//
+// Package 0 is the root, its own element record is element 0. Elements of a
+// package are contiguous, nested packages always have a higher index than
+// their parent. Strings are NUL terminated and referenced by byte offset.
+
+constexpr char const MAGIC[8]{ 'S', 'P', 'A', 'G', 'P', 'K', 'G', '\0' };
+constexpr uint32_t VERSION{ 1 };
+constexpr uint32_t NONE{ UINT32_MAX };
+
+struct Section {
+  uint64_t offset{};
+  uint64_t count{};
+};
+
+struct Header {
+  char magic[8]{};
+  uint32_t version{};
+  uint32_t endian{};
+  uint64_t fileSize{};
+  // FNV-1a of everything past the header.
+  uint32_t checksum{};
+  uint32_t reserved{};
+  Section packages{};
+  Section elements{};
+  Section sockets{};
+  Section connections{};
+  Section strings{};
+  Section blobs{};
+};
+
+struct PackageRecord {
+  uint32_t element{};
+  uint32_t firstElement{};
+  uint32_t elementCount{};
+  uint32_t firstConnection{};
+  uint32_t connectionCount{};
+  uint32_t description{};
+  uint32_t path{};
+  uint32_t icon{};
+  double inputsX{};
+  double inputsY{};
+  double outputsX{};
+  double outputsY{};
+};
+
+struct ElementRecord {
+  uint64_t id{};
+  uint32_t type{};
+  uint32_t name{};
+  uint32_t firstSocket{};
+  uint32_t package{ NONE };
+  // CBOR of the keys Element::serialize() doesn't know about, size 0 if none.
+  uint32_t extra{};
+  uint32_t extraSize{};
+  double x{};
+  double y{};
+  uint8_t inputs{};
+  uint8_t outputs{};
+  uint8_t minInputs{};
+  uint8_t maxInputs{};
+  uint8_t minOutputs{};
+  uint8_t maxOutputs{};
+  uint8_t defaultNewInputFlags{};
+  uint8_t defaultNewOutputFlags{};
+  uint8_t iconify{};
+  uint8_t padding[7]{};
+};
+
+struct SocketRecord {
+  uint32_t name{};
+  // Socket index within its side, ValueType and IOSocket flags.
+  uint8_t socket{};
+  uint8_t type{};
+  uint8_t flags{};
+  uint8_t padding{};
+};
+
+struct ConnectionRecord {
+  uint64_t from{};
+  uint64_t to{};
+  uint8_t fromSocket{};
+  uint8_t toSocket{};
+  uint8_t padding[6]{};
+};
+
+static_assert(sizeof(Header) == 128);
+static_assert(sizeof(PackageRecord) == 64);
+static_assert(sizeof(ElementRecord) == 64);
+static_assert(sizeof(SocketRecord) == 8);
+static_assert(sizeof(ConnectionRecord) == 24);
+static_assert(std::is_trivially_copyable_v<ElementRecord>);
+
+constexpr uint32_t ENDIAN_MARK{ 0x01020304 };
+
+// Read-only view over a mapped image. Nothing is accessed before validate()
+// succeeded, after that every index and offset stored in it is in range.
+class View final {
+ public:
+  View(uint8_t const *const a_data, size_t const a_size)
+    : m_data{ a_data }
+    , m_size{ a_size }
+  {
+  }
+
+  bool validate();
+
+  PackageRecord const &package(size_t const a_index) const { return m_packages[a_index]; }
+  ElementRecord const &element(size_t const a_index) const { return m_elements[a_index]; }
+  SocketRecord const &socket(size_t const a_index) const { return m_sockets[a_index]; }
+  ConnectionRecord const &connection(size_t const a_index) const { return m_connections[a_index]; }
+  std::string_view string(uint32_t const a_offset) const { return m_strings + a_offset; }
+
+  // Base keys of an element rebuilt from its record, without children or extras.
+  Element::Json elementJson(size_t const a_index) const;
+  Element::Json extras(size_t const a_index) const;
+
+ private:
+  uint8_t const *m_data{};
+  size_t m_size{};
+  Header m_header{};
+  PackageRecord const *m_packages{};
+  ElementRecord const *m_elements{};
+  SocketRecord const *m_sockets{};
+  ConnectionRecord const *m_connections{};
+  char const *m_strings{};
+  uint8_t const *m_blobs{};
+};
+
+// Full serialized form of an element, nested packages included.
+Element::Json element_json(View const &a_view, uint32_t const a_element);
+
+// Image of a snapshot built from its records, byte for byte what json_to_binary()
+// makes of the JSON it's saved as.
+bool snapshot_to_binary(PackageSnapshot const &a_snapshot, std::vector<uint8_t> &a_binary);
+
+} // namespace spaghetti::binary
+
+#endif // SPAGHETTI_PACKAGE_BINARY_H
@@ -0,0 +1,169 @@
+// MIT License
+//
+// Copyright (c) 2017-2018 Artur Wyszyński, aljen at hitomi dot pl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "package_cache.h"
+
+#include <fstream>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "filesystem.h"
+#include "mapped_file.h"
+#include "spaghetti/logger.h"
+#include "spaghetti/package_format.h"
+#include "spaghetti/registry.h"
+#include "zlib_stream.h"
+
+namespace spaghetti::package_cache {
+
+namespace {
+
+using Json = Element::Json;
+using Modified = decltype(fs::last_write_time(fs::path{}));
+
+struct Entry {
+  Modified modified{};
+  uintmax_t size{};
+  Definition definition{};
+};
+
+struct Cache {
+  std::mutex mutex{};
+  std::unordered_map<std::string, Entry> entries{};
+};
+
+Cache &cache()
+{
+  static Cache s_cache{};
+  return s_cache;
+}
+
+bool is_file(fs::path const &a_path)
+{
+  try {
+    return fs::is_regular_file(a_path);
+  } catch (std::exception const &) {
+    return false;
+  }
+}
+
+Definition parse(std::string const &a_filename)
+{
+  auto json = std::make_shared<Json>();
+
+  try {
+    if (package_format::format_for(a_filename) == package_format::Format::eBinary) {
+      std::error_code error{};
+      MappedFile const MAPPED{ a_filename, error };
+      if (error || !package_format::binary_to_json(MAPPED.data(), MAPPED.size(), *json)) return {};
+    } else {
+      std::ifstream file{ a_filename, std::ios::binary };
+      if (!file.is_open()) return {};
+
+      if (package_format::format_for(a_filename) == package_format::Format::eCompressed) {
+        InflateBuffer buffer{ file };
+        std::istream stream{ &buffer };
+        stream >> *json;
+      } else
+        file >> *json;
+    }
+  } catch (std::exception const &a_exception) {
+    log::error("Can't load package {}: {}", a_filename, a_exception.what());
+    return {};
+  }
+
+  return json;
+}
+
+} // namespace
+
+Definition definition(std::string const &a_path)
+{
+  std::string const FILENAME{ resolve(a_path) };
+  if (FILENAME.empty()) return {};
+
+  Modified modified{};
+  uintmax_t size{};
+  try {
+    modified = fs::last_write_time(FILENAME);
+    size = fs::file_size(FILENAME);
+  } catch (std::exception const &a_exception) {
+    log::error("Can't stat package {}: {}", FILENAME, a_exception.what());
+    return {};
+  }
+
+  // Parsing under the lock, packages referencing the same file wait for one parse.
+  auto &cached = cache();
+  std::lock_guard<std::mutex> const LOCK{ cached.mutex };
+
+  auto &entry = cached.entries[FILENAME];
+  if (!entry.definition || entry.modified != modified || entry.size != size) {
+    log::debug("Loading package definition {}", FILENAME);
+    entry.definition = parse(FILENAME);
+    entry.modified = modified;
+    entry.size = size;
+  }
+
+  return entry.definition;
+}
+
+std::string resolve(std::string const &a_path)
+{
+  if (a_path.empty()) return {};
+
+  fs::path const PATH{ a_path };
+  std::vector<fs::path> candidates{ PATH };
+  if (PATH.is_relative()) {
+    Registry const &registry{ Registry::get() };
+    candidates.push_back(fs::path{ registry.userPackagesPath() } / PATH);
+    candidates.push_back(fs::path{ registry.systemPackagesPath() } / PATH);
+  }
+
+  for (auto const &CANDIDATE : candidates) {
+    if (is_file(CANDIDATE)) return CANDIDATE.string();
+
+    for (auto const EXTENSION :
+         { package_format::JSON_EXTENSION, package_format::COMPRESSED_EXTENSION, package_format::BINARY_EXTENSION }) {
+      fs::path const WITH_EXTENSION{ CANDIDATE.string() + EXTENSION };
+      if (is_file(WITH_EXTENSION)) return WITH_EXTENSION.string();
+    }
+  }
+
+  return {};
+}
+
+void clear()
+{
+  auto &cached = cache();
+  std::lock_guard<std::mutex> const LOCK{ cached.mutex };
+  cached.entries.clear();
+}
+
+size_t size()
+{
+  auto &cached = cache();
+  std::lock_guard<std::mutex> const LOCK{ cached.mutex };
+  return cached.entries.size();
+}
+
+} // namespace spaghetti::package_cache
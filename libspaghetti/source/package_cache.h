@@ -0,0 +1,51 @@
+// MIT License
+//
+// Copyright (c) 2017-2018 Artur Wyszyński, aljen at hitomi dot pl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+#ifndef SPAGHETTI_PACKAGE_CACHE_H
+#define SPAGHETTI_PACKAGE_CACHE_H
+
+#include <memory>
+#include <string>
+
+#include "spaghetti/element.h"
+
+namespace spaghetti::package_cache {
+
+// Package files referenced by other packages, parsed when first instantiated and
+// then shared read-only by every instance. An entry is parsed again when its
+// file's modification time or size changes.
+using Definition = std::shared_ptr<Element::Json const>;
+
+// Serialized package at a_path, null when there's no such file or it doesn't load.
+Definition definition(std::string const &a_path);
+
+// File a package path refers to, empty if none. Relative paths are looked up as
+// given, then in the user's and the system's packages, with or without extension.
+std::string resolve(std::string const &a_path);
+
+void clear();
+size_t size();
+
+} // namespace spaghetti::package_cache
+
+#endif // SPAGHETTI_PACKAGE_CACHE_H
@@ -0,0 +1,731 @@
+// MIT License
+//
+// Copyright (c) 2017-2018 Artur Wyszyński, aljen at hitomi dot pl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "spaghetti/package_format.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <unordered_map>
+
+#include "mapped_file.h"
+#include "package_binary.h"
+#include "package_snapshot.h"
+#include "spaghetti/logger.h"
+#include "spaghetti/package.h"
+#include "zlib_stream.h"
+
+namespace spaghetti {
+
+namespace {
+
+using Json = Element::Json;
+
+constexpr char const *const SOCKET_TYPES[]{ "bool", "int", "float" };
+
+bool ends_with(std::string_view const a_string, std::string_view const a_suffix)
+{
+  return a_string.size() >= a_suffix.size() && a_string.substr(a_string.size() - a_suffix.size()) == a_suffix;
+}
+
+size_t align(size_t const a_offset)
+{
+  return (a_offset + 7) & ~size_t{ 7 };
+}
+
+uint32_t checksum(uint8_t const *const a_data, size_t const a_size)
+{
+  size_t const HEADER{ sizeof(binary::Header) };
+  return static_cast<uint32_t>(
+      string::hash(std::string_view{ reinterpret_cast<char const *>(a_data) + HEADER, a_size - HEADER }));
+}
+
+bool is_package(Json const &a_json)
+{
+  return a_json.at("element").at("type").get<std::string>() == Package::TYPE;
+}
+
+bool is_plain_socket(Json const &a_socket)
+{
+  return a_socket.size() == 4 && a_socket.count("socket") && a_socket.count("type") && a_socket.count("name") &&
+         a_socket.count("flags");
+}
+
+bool is_reference(Json const &a_extras)
+{
+  auto const PACKAGE = a_extras.find("package");
+  return PACKAGE != a_extras.end() && PACKAGE->value("reference", false);
+}
+
+// References carry no elements or connections, only the path they refer to.
+Json const &array_or_empty(Json const &a_object, char const *const a_key)
+{
+  static Json const EMPTY = Json::array();
+  auto const FOUND = a_object.find(a_key);
+  return FOUND != a_object.end() ? *FOUND : EMPTY;
+}
+
+void erase_if_empty(Json &a_json, char const *const a_key)
+{
+  auto const IT = a_json.find(a_key);
+  if (IT != a_json.end() && IT->is_object() && IT->empty()) a_json.erase(IT);
+}
+
+// What's left of an element after removing everything the fixed records hold,
+// e.g. the value of a constant or the interval of a clock.
+Json extras_of(Json a_json, bool const a_isPackage)
+{
+  auto &element = a_json["element"];
+  for (auto const KEY : { "id", "name", "type", "min_inputs", "max_inputs", "min_outputs", "max_outputs",
+                          "default_new_input_flags", "default_new_output_flags" })
+    element.erase(KEY);
+
+  auto const &IO = element["io"];
+  bool const PLAIN_IO{ IO.size() == 2 && IO.count("inputs") && IO.count("outputs") &&
+                       std::all_of(IO["inputs"].begin(), IO["inputs"].end(), is_plain_socket) &&
+                       std::all_of(IO["outputs"].begin(), IO["outputs"].end(), is_plain_socket) };
+  if (PLAIN_IO) element.erase("io");
+
+  auto &node = a_json["node"];
+  node.erase("iconify");
+  node["position"].erase("x");
+  node["position"].erase("y");
+  erase_if_empty(node, "position");
+
+  if (a_isPackage) {
+    for (auto const KEY : { "inputs_position", "outputs_position" }) {
+      node[KEY].erase("x");
+      node[KEY].erase("y");
+      erase_if_empty(node, KEY);
+    }
+
+    auto &package = a_json["package"];
+    for (auto const KEY : { "description", "path", "icon", "elements", "connections" }) package.erase(KEY);
+    erase_if_empty(a_json, "package");
+  }
+
+  erase_if_empty(a_json, "element");
+  erase_if_empty(a_json, "node");
+
+  return a_json;
+}
+
+void merge(Json &a_target, Json const &a_patch)
+{
+  if (!a_target.is_object() || !a_patch.is_object()) {
+    a_target = a_patch;
+    return;
+  }
+
+  for (auto it = a_patch.cbegin(); it != a_patch.cend(); ++it) merge(a_target[it.key()], it.value());
+}
+
+uint32_t index(size_t const a_value)
+{
+  if (a_value >= binary::NONE) throw std::length_error("package too large for the binary format");
+  return static_cast<uint32_t>(a_value);
+}
+
+class Writer final {
+ public:
+  void write(Json const &a_root, std::vector<uint8_t> &a_binary);
+  // Same image as writing the JSON a_snapshot is saved as, without building it.
+  void write(PackageSnapshot const &a_snapshot, std::vector<uint8_t> &a_binary);
+
+ private:
+  void finish(std::vector<uint8_t> &a_binary);
+  uint32_t string(std::string const &a_string);
+  uint8_t sockets(Json const &a_sockets);
+  uint8_t sockets(PackageSnapshot const &a_snapshot, uint32_t const a_first, uint32_t const a_count);
+  void element(Json const &a_json);
+  void element(PackageSnapshot const &a_snapshot, uint32_t const a_element);
+  void package(Json const &a_json, uint32_t const a_element);
+  void package(PackageSnapshot const &a_snapshot, uint32_t const a_package, uint32_t const a_element);
+
+ private:
+  std::vector<binary::PackageRecord> m_packages{};
+  std::vector<binary::ElementRecord> m_elements{};
+  std::vector<binary::SocketRecord> m_sockets{};
+  std::vector<binary::ConnectionRecord> m_connections{};
+  std::vector<char> m_strings{};
+  std::unordered_map<std::string, uint32_t> m_stringOffsets{};
+  std::vector<uint8_t> m_blobs{};
+};
+
+void Writer::write(Json const &a_root, std::vector<uint8_t> &a_binary)
+{
+  element(a_root);
+  package(a_root, 0);
+  finish(a_binary);
+}
+
+void Writer::write(PackageSnapshot const &a_snapshot, std::vector<uint8_t> &a_binary)
+{
+  element(a_snapshot, a_snapshot.packages()[0].element);
+  package(a_snapshot, 0, 0);
+  finish(a_binary);
+}
+
+void Writer::finish(std::vector<uint8_t> &a_binary)
+{
+  binary::Header header{};
+  std::memcpy(header.magic, binary::MAGIC, sizeof(header.magic));
+  header.version = binary::VERSION;
+  header.endian = binary::ENDIAN_MARK;
+
+  size_t offset{ sizeof(binary::Header) };
+  auto place = [&offset](binary::Section &a_section, size_t const a_count, size_t const a_bytes) {
+    offset = align(offset);
+    a_section = { offset, a_count };
+    offset += a_bytes;
+  };
+  place(header.packages, m_packages.size(), m_packages.size() * sizeof(binary::PackageRecord));
+  place(header.elements, m_elements.size(), m_elements.size() * sizeof(binary::ElementRecord));
+  place(header.sockets, m_sockets.size(), m_sockets.size() * sizeof(binary::SocketRecord));
+  place(header.connections, m_connections.size(), m_connections.size() * sizeof(binary::ConnectionRecord));
+  place(header.strings, m_strings.size(), m_strings.size());
+  place(header.blobs, m_blobs.size(), m_blobs.size());
+  header.fileSize = offset;
+
+  a_binary.assign(offset, 0);
+  auto copy = [&a_binary](binary::Section const &a_section, auto const &a_data) {
+    if (a_data.empty()) return;
+    std::memcpy(a_binary.data() + a_section.offset, a_data.data(), a_data.size() * sizeof(a_data[0]));
+  };
+  copy(header.packages, m_packages);
+  copy(header.elements, m_elements);
+  copy(header.sockets, m_sockets);
+  copy(header.connections, m_connections);
+  copy(header.strings, m_strings);
+  copy(header.blobs, m_blobs);
+
+  header.checksum = checksum(a_binary.data(), a_binary.size());
+  std::memcpy(a_binary.data(), &header, sizeof(header));
+}
+
+uint32_t Writer::string(std::string const &a_string)
+{
+  if (a_string.find('\0') != std::string::npos) throw std::invalid_argument("string with embedded NUL");
+
+  auto const IT = m_stringOffsets.find(a_string);
+  if (IT != m_stringOffsets.end()) return IT->second;
+
+  uint32_t const OFFSET{ index(m_strings.size()) };
+  m_strings.insert(m_strings.end(), a_string.begin(), a_string.end());
+  m_strings.push_back('\0');
+  m_stringOffsets.emplace(a_string, OFFSET);
+
+  return OFFSET;
+}
+
+uint8_t Writer::sockets(Json const &a_sockets)
+{
+  if (a_sockets.size() > UINT8_MAX) throw std::length_error("too many sockets");
+
+  for (auto const &SOCKET : a_sockets) {
+    auto const TYPE = SOCKET.at("type").get<std::string>();
+    auto const TYPE_IT = std::find(std::begin(SOCKET_TYPES), std::end(SOCKET_TYPES), TYPE);
+    if (TYPE_IT == std::end(SOCKET_TYPES)) throw std::invalid_argument("unknown socket type " + TYPE);
+
+    binary::SocketRecord record{};
+    record.name = string(SOCKET.at("name").get<std::string>());
+    record.socket = SOCKET.at("socket").get<uint8_t>();
+    record.type = static_cast<uint8_t>(std::distance(std::begin(SOCKET_TYPES), TYPE_IT));
+    record.flags = SOCKET.at("flags").get<uint8_t>();
+    m_sockets.push_back(record);
+  }
+
+  return static_cast<uint8_t>(a_sockets.size());
+}
+
+uint8_t Writer::sockets(PackageSnapshot const &a_snapshot, uint32_t const a_first, uint32_t const a_count)
+{
+  if (a_count > UINT8_MAX) throw std::length_error("too many sockets");
+
+  auto const &SOCKETS = a_snapshot.sockets();
+  for (uint32_t i = 0; i < a_count; ++i) {
+    auto const &SOCKET = SOCKETS[a_first + i];
+
+    binary::SocketRecord record{};
+    record.name = string(string::lookup(SOCKET.name));
+    record.socket = static_cast<uint8_t>(i);
+    record.type = static_cast<uint8_t>(SOCKET.type);
+    record.flags = SOCKET.flags;
+    m_sockets.push_back(record);
+  }
+
+  return static_cast<uint8_t>(a_count);
+}
+
+void Writer::element(Json const &a_json)
+{
+  auto const &ELEMENT = a_json.at("element");
+  auto const &NODE = a_json.at("node");
+  auto const &IO = ELEMENT.at("io");
+
+  binary::ElementRecord record{};
+  record.id = ELEMENT.at("id").get<uint64_t>();
+  record.type = string(ELEMENT.at("type").get<std::string>());
+  record.name = string(ELEMENT.at("name").get<std::string>());
+  record.minInputs = ELEMENT.at("min_inputs").get<uint8_t>();
+  record.maxInputs = ELEMENT.at("max_inputs").get<uint8_t>();
+  record.minOutputs = ELEMENT.at("min_outputs").get<uint8_t>();
+  record.maxOutputs = ELEMENT.at("max_outputs").get<uint8_t>();
+  record.defaultNewInputFlags = ELEMENT.at("default_new_input_flags").get<uint8_t>();
+  record.defaultNewOutputFlags = ELEMENT.at("default_new_output_flags").get<uint8_t>();
+  record.x = NODE.at("position").at("x").get<double>();
+  record.y = NODE.at("position").at("y").get<double>();
+  record.iconify = NODE.at("iconify").get<bool>();
+
+  record.firstSocket = index(m_sockets.size());
+  record.inputs = sockets(IO.at("inputs"));
+  record.outputs = sockets(IO.at("outputs"));
+
+  auto const EXTRAS = extras_of(a_json, is_package(a_json));
+  if (!EXTRAS.empty()) {
+    auto const CBOR = Json::to_cbor(EXTRAS);
+    record.extra = index(m_blobs.size());
+    record.extraSize = index(CBOR.size());
+    m_blobs.insert(m_blobs.end(), CBOR.begin(), CBOR.end());
+  }
+
+  m_elements.push_back(record);
+}
+
+void Writer::element(PackageSnapshot const &a_snapshot, uint32_t const a_element)
+{
+  auto const &ELEMENT = a_snapshot.elements()[a_element];
+
+  // Keys of its own only exist as JSON, the records are split out of it.
+  if (ELEMENT.custom != PackageSnapshot::NONE) {
+    element(a_snapshot.customs()[ELEMENT.custom]);
+    return;
+  }
+
+  binary::ElementRecord record{};
+  record.id = ELEMENT.id;
+  record.type = string(ELEMENT.type);
+  record.name = string(string::lookup(ELEMENT.name));
+  record.minInputs = ELEMENT.minInputs;
+  record.maxInputs = ELEMENT.maxInputs;
+  record.minOutputs = ELEMENT.minOutputs;
+  record.maxOutputs = ELEMENT.maxOutputs;
+  record.defaultNewInputFlags = ELEMENT.defaultNewInputFlags;
+  record.defaultNewOutputFlags = ELEMENT.defaultNewOutputFlags;
+  record.x = static_cast<double>(ELEMENT.position.x);
+  record.y = static_cast<double>(ELEMENT.position.y);
+  record.iconify = ELEMENT.iconified;
+
+  record.firstSocket = index(m_sockets.size());
+  record.inputs = sockets(a_snapshot, ELEMENT.firstSocket, ELEMENT.inputs);
+  record.outputs = sockets(a_snapshot, ELEMENT.firstSocket + ELEMENT.inputs, ELEMENT.outputs);
+
+  // The reference flag is all extras_of() leaves of a package.
+  if (ELEMENT.package != PackageSnapshot::NONE && a_snapshot.packages()[ELEMENT.package].reference) {
+    static auto const REFERENCE = Json::to_cbor(Json{ { "package", { { "reference", true } } } });
+    record.extra = index(m_blobs.size());
+    record.extraSize = index(REFERENCE.size());
+    m_blobs.insert(m_blobs.end(), REFERENCE.begin(), REFERENCE.end());
+  }
+
+  m_elements.push_back(record);
+}
+
+void Writer::package(Json const &a_json, uint32_t const a_element)
+{
+  // Reserve the index first so nested packages always come after their parent.
+  uint32_t const INDEX{ index(m_packages.size()) };
+  m_packages.emplace_back();
+  m_elements[a_element].package = INDEX;
+
+  auto const &NODE = a_json.at("node");
+  auto const &PACKAGE = a_json.at("package");
+  auto const &ELEMENTS = array_or_empty(PACKAGE, "elements");
+  auto const &CONNECTIONS = array_or_empty(PACKAGE, "connections");
+
+  binary::PackageRecord record{};
+  record.element = a_element;
+  record.description = string(PACKAGE.at("description").get<std::string>());
+  record.path = string(PACKAGE.at("path").get<std::string>());
+  record.icon = string(PACKAGE.at("icon").get<std::string>());
+  record.inputsX = NODE.at("inputs_position").at("x").get<double>();
+  record.inputsY = NODE.at("inputs_position").at("y").get<double>();
+  record.outputsX = NODE.at("outputs_position").at("x").get<double>();
+  record.outputsY = NODE.at("outputs_position").at("y").get<double>();
+
+  record.firstElement = index(m_elements.size());
+  record.elementCount = index(ELEMENTS.size());
+  for (auto const &ELEMENT : ELEMENTS) element(ELEMENT);
+
+  record.firstConnection = index(m_connections.size());
+  record.connectionCount = index(CONNECTIONS.size());
+  for (auto const &CONNECTION : CONNECTIONS) {
+    auto const &FROM = CONNECTION.at("connect");
+    auto const &TO = CONNECTION.at("to");
+
+    binary::ConnectionRecord connection{};
+    connection.from = FROM.at("id").get<uint64_t>();
+    connection.fromSocket = FROM.at("socket").get<uint8_t>();
+    connection.to = TO.at("id").get<uint64_t>();
+    connection.toSocket = TO.at("socket").get<uint8_t>();
+    m_connections.push_back(connection);
+  }
+
+  m_packages[INDEX] = record;
+
+  uint32_t i{};
+  for (auto const &ELEMENT : ELEMENTS) {
+    if (is_package(ELEMENT)) package(ELEMENT, record.firstElement + i);
+    ++i;
+  }
+}
+
+void Writer::package(PackageSnapshot const &a_snapshot, uint32_t const a_package, uint32_t const a_element)
+{
+  // Reserve the index first so nested packages always come after their parent.
+  uint32_t const INDEX{ index(m_packages.size()) };
+  m_packages.emplace_back();
+  m_elements[a_element].package = INDEX;
+
+  auto const &PACKAGE = a_snapshot.packages()[a_package];
+  auto const &CHILDREN = a_snapshot.children();
+
+  binary::PackageRecord record{};
+  record.element = a_element;
+  record.description = string(PACKAGE.description);
+  record.path = string(PACKAGE.path);
+  record.icon = string(PACKAGE.icon);
+  record.inputsX = static_cast<double>(PACKAGE.inputsPosition.x);
+  record.inputsY = static_cast<double>(PACKAGE.inputsPosition.y);
+  record.outputsX = static_cast<double>(PACKAGE.outputsPosition.x);
+  record.outputsY = static_cast<double>(PACKAGE.outputsPosition.y);
+
+  record.firstElement = index(m_elements.size());
+  record.elementCount = index(PACKAGE.children);
+  for (size_t i = 0; i < PACKAGE.children; ++i) element(a_snapshot, CHILDREN[PACKAGE.firstChild + i]);
+
+  auto const &CONNECTIONS = a_snapshot.connections();
+  record.firstConnection = index(m_connections.size());
+  record.connectionCount = index(PACKAGE.connections);
+  for (size_t i = 0; i < PACKAGE.connections; ++i) {
+    auto const &CONNECTION = CONNECTIONS[PACKAGE.firstConnection + i];
+
+    binary::ConnectionRecord connection{};
+    connection.from = CONNECTION.from_id;
+    connection.fromSocket = CONNECTION.from_socket;
+    connection.to = CONNECTION.to_id;
+    connection.toSocket = CONNECTION.to_socket;
+    m_connections.push_back(connection);
+  }
+
+  m_packages[INDEX] = record;
+
+  for (size_t i = 0; i < PACKAGE.children; ++i) {
+    uint32_t const CHILD{ a_snapshot.elements()[CHILDREN[PACKAGE.firstChild + i]].package };
+    if (CHILD != PackageSnapshot::NONE) package(a_snapshot, CHILD, record.firstElement + static_cast<uint32_t>(i));
+  }
+}
+
+} // namespace
+
+namespace binary {
+
+Json package_json(View const &a_view, uint32_t const a_package);
+
+Json element_json(View const &a_view, uint32_t const a_element)
+{
+  auto const &RECORD = a_view.element(a_element);
+  // Not brace initialized, that would wrap the value in an array.
+  Json json = RECORD.package == NONE ? a_view.elementJson(a_element) : package_json(a_view, RECORD.package);
+
+  if (RECORD.extraSize) merge(json, a_view.extras(a_element));
+
+  return json;
+}
+
+Json package_json(View const &a_view, uint32_t const a_package)
+{
+  auto const &PACKAGE = a_view.package(a_package);
+  Json json = a_view.elementJson(PACKAGE.element);
+
+  auto &jsonNode = json["node"];
+  jsonNode["inputs_position"]["x"] = PACKAGE.inputsX;
+  jsonNode["inputs_position"]["y"] = PACKAGE.inputsY;
+  jsonNode["outputs_position"]["x"] = PACKAGE.outputsX;
+  jsonNode["outputs_position"]["y"] = PACKAGE.outputsY;
+
+  auto &jsonPackage = json["package"];
+  jsonPackage["description"] = std::string{ a_view.string(PACKAGE.description) };
+  jsonPackage["path"] = std::string{ a_view.string(PACKAGE.path) };
+  jsonPackage["icon"] = std::string{ a_view.string(PACKAGE.icon) };
+
+  if (a_view.element(PACKAGE.element).extraSize && is_reference(a_view.extras(PACKAGE.element))) return json;
+
+  auto jsonElements = Json::array();
+  for (uint32_t i = 0; i < PACKAGE.elementCount; ++i)
+    jsonElements.push_back(element_json(a_view, PACKAGE.firstElement + i));
+  jsonPackage["elements"] = jsonElements;
+
+  auto jsonConnections = Json::array();
+  for (uint32_t i = 0; i < PACKAGE.connectionCount; ++i) {
+    auto const &CONNECTION = a_view.connection(PACKAGE.firstConnection + i);
+    Json jsonConnection{};
+    jsonConnection["connect"]["id"] = CONNECTION.from;
+    jsonConnection["connect"]["socket"] = CONNECTION.fromSocket;
+    jsonConnection["to"]["id"] = CONNECTION.to;
+    jsonConnection["to"]["socket"] = CONNECTION.toSocket;
+    jsonConnections.push_back(jsonConnection);
+  }
+  jsonPackage["connections"] = jsonConnections;
+
+  return json;
+}
+
+bool View::validate()
+{
+  if (m_size < sizeof(Header) || reinterpret_cast<uintptr_t>(m_data) % alignof(uint64_t) != 0) return false;
+
+  std::memcpy(&m_header, m_data, sizeof(Header));
+  if (std::memcmp(m_header.magic, MAGIC, sizeof(MAGIC)) != 0) return false;
+  if (m_header.version != VERSION || m_header.endian != ENDIAN_MARK || m_header.fileSize != m_size) return false;
+  if (m_header.checksum != checksum(m_data, m_size)) return false;
+
+  auto section = [this](Section const &a_section, size_t const a_recordSize) -> uint8_t const * {
+    if (a_section.offset % alignof(uint64_t) != 0 || a_section.offset > m_size) return nullptr;
+    if (a_section.count >= NONE || a_section.count > (m_size - a_section.offset) / a_recordSize) return nullptr;
+    return m_data + a_section.offset;
+  };
+
+  auto const PACKAGES = section(m_header.packages, sizeof(PackageRecord));
+  auto const ELEMENTS = section(m_header.elements, sizeof(ElementRecord));
+  auto const SOCKETS = section(m_header.sockets, sizeof(SocketRecord));
+  auto const CONNECTIONS = section(m_header.connections, sizeof(ConnectionRecord));
+  auto const STRINGS = section(m_header.strings, 1);
+  auto const BLOBS = section(m_header.blobs, 1);
+  if (!PACKAGES || !ELEMENTS || !SOCKETS || !CONNECTIONS || !STRINGS || !BLOBS) return false;
+
+  m_packages = reinterpret_cast<PackageRecord const *>(PACKAGES);
+  m_elements = reinterpret_cast<ElementRecord const *>(ELEMENTS);
+  m_sockets = reinterpret_cast<SocketRecord const *>(SOCKETS);
+  m_connections = reinterpret_cast<ConnectionRecord const *>(CONNECTIONS);
+  m_strings = reinterpret_cast<char const *>(STRINGS);
+  m_blobs = BLOBS;
+
+  uint64_t const PACKAGES_COUNT{ m_header.packages.count };
+  uint64_t const ELEMENTS_COUNT{ m_header.elements.count };
+  uint64_t const STRINGS_SIZE{ m_header.strings.count };
+
+  // Any offset below the size is then a terminated string.
+  if (PACKAGES_COUNT == 0 || ELEMENTS_COUNT == 0 || STRINGS_SIZE == 0 || m_strings[STRINGS_SIZE - 1] != '\0')
+    return false;
+
+  for (uint64_t i = 0; i < m_header.sockets.count; ++i) {
+    auto const &SOCKET = m_sockets[i];
+    if (SOCKET.name >= STRINGS_SIZE || SOCKET.type > static_cast<uint8_t>(ValueType::eFloat)) return false;
+  }
+
+  for (uint64_t i = 0; i < ELEMENTS_COUNT; ++i) {
+    auto const &ELEMENT = m_elements[i];
+    if (ELEMENT.type >= STRINGS_SIZE || ELEMENT.name >= STRINGS_SIZE) return false;
+    if (uint64_t{ ELEMENT.firstSocket } + ELEMENT.inputs + ELEMENT.outputs > m_header.sockets.count) return false;
+    if (uint64_t{ ELEMENT.extra } + ELEMENT.extraSize > m_header.blobs.count) return false;
+    if (ELEMENT.package != NONE && ELEMENT.package >= PACKAGES_COUNT) return false;
+
+    for (uint32_t s = 0; s < ELEMENT.inputs; ++s)
+      if (m_sockets[ELEMENT.firstSocket + s].socket != s) return false;
+    for (uint32_t s = 0; s < ELEMENT.outputs; ++s)
+      if (m_sockets[ELEMENT.firstSocket + ELEMENT.inputs + s].socket != s) return false;
+  }
+
+  // Every nested package has to be reachable exactly once, from a parent with
+  // a lower index, which also rules out cycles.
+  if (m_packages[0].element != 0) return false;
+  std::vector<uint8_t> reached(PACKAGES_COUNT);
+  reached[0] = 1;
+
+  for (uint64_t i = 0; i < PACKAGES_COUNT; ++i) {
+    auto const &PACKAGE = m_packages[i];
+    if (PACKAGE.element >= ELEMENTS_COUNT || m_elements[PACKAGE.element].package != i) return false;
+    if (uint64_t{ PACKAGE.firstElement } + PACKAGE.elementCount > ELEMENTS_COUNT) return false;
+    if (uint64_t{ PACKAGE.firstConnection } + PACKAGE.connectionCount > m_header.connections.count) return false;
+    if (PACKAGE.description >= STRINGS_SIZE || PACKAGE.path >= STRINGS_SIZE || PACKAGE.icon >= STRINGS_SIZE)
+      return false;
+
+    for (uint32_t e = 0; e < PACKAGE.elementCount; ++e) {
+      uint32_t const NESTED{ m_elements[PACKAGE.firstElement + e].package };
+      if (NESTED == NONE) continue;
+      if (NESTED <= i || reached[NESTED]++) return false;
+    }
+  }
+
+  return std::all_of(reached.begin(), reached.end(), [](uint8_t const a_reached) { return a_reached == 1; });
+}
+
+Json View::elementJson(size_t const a_index) const
+{
+  auto const &RECORD = m_elements[a_index];
+
+  auto sockets = [this](uint32_t const a_first, uint8_t const a_count) {
+    auto jsonSockets = Json::array();
+    for (uint32_t i = 0; i < a_count; ++i) {
+      auto const &SOCKET = m_sockets[a_first + i];
+      Json socket{};
+      socket["socket"] = SOCKET.socket;
+      socket["type"] = SOCKET_TYPES[SOCKET.type];
+      socket["name"] = std::string{ string(SOCKET.name) };
+      socket["flags"] = SOCKET.flags;
+      jsonSockets.push_back(socket);
+    }
+    return jsonSockets;
+  };
+
+  Json json{};
+  auto &jsonElement = json["element"];
+  jsonElement["id"] = RECORD.id;
+  jsonElement["name"] = std::string{ string(RECORD.name) };
+  jsonElement["type"] = std::string{ string(RECORD.type) };
+  jsonElement["min_inputs"] = RECORD.minInputs;
+  jsonElement["max_inputs"] = RECORD.maxInputs;
+  jsonElement["min_outputs"] = RECORD.minOutputs;
+  jsonElement["max_outputs"] = RECORD.maxOutputs;
+  jsonElement["default_new_input_flags"] = RECORD.defaultNewInputFlags;
+  jsonElement["default_new_output_flags"] = RECORD.defaultNewOutputFlags;
+  jsonElement["io"]["inputs"] = sockets(RECORD.firstSocket, RECORD.inputs);
+  jsonElement["io"]["outputs"] = sockets(RECORD.firstSocket + RECORD.inputs, RECORD.outputs);
+
+  auto &jsonNode = json["node"];
+  jsonNode["position"]["x"] = RECORD.x;
+  jsonNode["position"]["y"] = RECORD.y;
+  jsonNode["iconify"] = RECORD.iconify != 0;
+
+  return json;
+}
+
+Json View::extras(size_t const a_index) const
+{
+  auto const &RECORD = m_elements[a_index];
+  if (RECORD.extraSize == 0) return {};
+  return Json::from_cbor(m_blobs + RECORD.extra, size_t{ RECORD.extraSize });
+}
+
+bool snapshot_to_binary(PackageSnapshot const &a_snapshot, std::vector<uint8_t> &a_binary)
+{
+  try {
+    Writer{}.write(a_snapshot, a_binary);
+  } catch (std::exception const &a_exception) {
+    log::error("[package_format]: Can't convert to binary: {}", a_exception.what());
+    return false;
+  }
+
+  return true;
+}
+
+} // namespace binary
+
+namespace package_format {
+
+Format format_for(std::string_view const a_filename)
+{
+  if (ends_with(a_filename, BINARY_EXTENSION)) return Format::eBinary;
+  if (ends_with(a_filename, COMPRESSED_EXTENSION)) return Format::eCompressed;
+  return Format::eJson;
+}
+
+bool json_to_binary(Json const &a_json, std::vector<uint8_t> &a_binary)
+{
+  try {
+    Writer{}.write(a_json, a_binary);
+  } catch (std::exception const &a_exception) {
+    log::error("[package_format]: Can't convert to binary: {}", a_exception.what());
+    return false;
+  }
+
+  return true;
+}
+
+bool binary_to_json(uint8_t const *const a_data, size_t const a_size, Json &a_json)
+{
+  binary::View view{ a_data, a_size };
+  if (!view.validate()) {
+    log::error("[package_format]: Invalid binary package");
+    return false;
+  }
+
+  try {
+    a_json = binary::element_json(view, 0);
+  } catch (std::exception const &a_exception) {
+    log::error("[package_format]: Can't convert to JSON: {}", a_exception.what());
+    return false;
+  }
+
+  return true;
+}
+
+bool convert(std::string const &a_from, std::string const &a_to)
+{
+  Json json{};
+
+  if (format_for(a_from) == Format::eBinary) {
+    std::error_code error{};
+    MappedFile const MAPPED{ a_from, error };
+    if (error || !binary_to_json(MAPPED.data(), MAPPED.size(), json)) return false;
+  } else {
+    std::ifstream file{ a_from, std::ios::binary };
+    if (!file.is_open()) return false;
+    try {
+      if (format_for(a_from) == Format::eCompressed) {
+        InflateBuffer buffer{ file };
+        std::istream stream{ &buffer };
+        stream >> json;
+      } else
+        file >> json;
+    } catch (std::exception const &a_exception) {
+      log::error("[package_format]: Can't parse {}: {}", a_from, a_exception.what());
+      return false;
+    }
+  }
+
+  if (format_for(a_to) == Format::eBinary) {
+    std::vector<uint8_t> binary{};
+    if (!json_to_binary(json, binary)) return false;
+    std::ofstream file{ a_to, std::ios::binary };
+    file.write(reinterpret_cast<char const *>(binary.data()), static_cast<std::streamsize>(binary.size()));
+    return file.good();
+  }
+
+  if (format_for(a_to) == Format::eCompressed) {
+    std::ofstream file{ a_to, std::ios::binary };
+    DeflateBuffer buffer{ file };
+    std::ostream stream{ &buffer };
+    stream << json.dump(2);
+    return stream.good() && buffer.finish();
+  }
+
+  std::ofstream file{ a_to };
+  file << json.dump(2);
+  return file.good();
+}
+
+} // namespace package_format
+
+} // namespace spaghetti
@@ -0,0 +1,410 @@
+// MIT License
+//
+// Copyright (c) 2017-2018 Artur Wyszyński, aljen at hitomi dot pl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "package_loader.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "spaghetti/logger.h"
+#include "spaghetti/registry.h"
+
+namespace spaghetti {
+
+PackageLoader::PackageLoader(std::istream &a_stream)
+  : m_reader{ a_stream }
+{
+}
+
+void PackageLoader::load(Package &a_package)
+{
+  Fields fields{};
+  bool applied{};
+
+  std::string key{};
+  m_reader.beginObject();
+  while (m_reader.nextKey(key)) {
+    if (key == "element")
+      readElementGroup(fields);
+    else if (key == "node")
+      readNodeGroup(fields);
+    else if (key == "package" && fields.hasElement && !fields.hasExtras()) {
+      apply(a_package, fields);
+      applied = true;
+      readPackageGroup(a_package);
+    } else
+      fields.extras[key] = m_reader.readValue();
+  }
+
+  // Out of order documents and packages with extras end up here with the whole
+  // package as a DOM, so its deserialize() sees every key.
+  if (!applied)
+    a_package.deserialize(toJson(fields));
+  else
+    applyNode(a_package, fields);
+}
+
+void PackageLoader::readElement(Package &a_parent, RemappedIds &a_remappedIds, Batch &a_batch)
+{
+  // Enough elements per batch for Package::addBulk() to spread them over threads.
+  size_t const BATCH_SIZE{ 8192 };
+
+  Fields fields{};
+  Element *element{};
+
+  std::string key{};
+  m_reader.beginObject();
+  while (m_reader.nextKey(key)) {
+    if (key == "element")
+      readElementGroup(fields);
+    else if (key == "node")
+      readNodeGroup(fields);
+    else if (key == "package" && fields.hasElement && !fields.hasExtras() &&
+             string::hash(fields.type) == Package::HASH) {
+      // Nested packages stream straight into the freshly added element, after
+      // the elements read before it so ids keep the document order. One with
+      // extras is batched with its contents, init() deserializes it whole.
+      flush(a_parent, a_remappedIds, a_batch);
+      element = create(a_parent, fields, a_remappedIds);
+      apply(*element, fields);
+      readPackageGroup(*static_cast<Package *>(element));
+    } else
+      fields.extras[key] = m_reader.readValue();
+  }
+
+  if (element) {
+    applyNode(*element, fields);
+    return;
+  }
+
+  if (!Registry::get().hasElement(string::hash(fields.type))) {
+    log::error("Unknown element type {}", fields.type);
+    return;
+  }
+
+  a_batch.push_back(std::move(fields));
+  if (a_batch.size() == BATCH_SIZE) flush(a_parent, a_remappedIds, a_batch);
+}
+
+void PackageLoader::readElementGroup(Fields &a_fields)
+{
+  auto readByte = [this] { return static_cast<uint8_t>(m_reader.readUnsigned()); };
+
+  a_fields.hasElement = true;
+
+  std::string key{};
+  m_reader.beginObject();
+  while (m_reader.nextKey(key)) {
+    if (key == "id")
+      a_fields.id = m_reader.readUnsigned();
+    else if (key == "name")
+      m_reader.readString(a_fields.name);
+    else if (key == "type")
+      m_reader.readString(a_fields.type);
+    else if (key == "min_inputs")
+      a_fields.minInputs = readByte();
+    else if (key == "max_inputs")
+      a_fields.maxInputs = readByte();
+    else if (key == "min_outputs")
+      a_fields.minOutputs = readByte();
+    else if (key == "max_outputs")
+      a_fields.maxOutputs = readByte();
+    else if (key == "default_new_input_flags")
+      a_fields.defaultNewInputFlags = readByte();
+    else if (key == "default_new_output_flags")
+      a_fields.defaultNewOutputFlags = readByte();
+    else if (key == "io") {
+      std::string ioKey{};
+      m_reader.beginObject();
+      while (m_reader.nextKey(ioKey)) {
+        if (ioKey == "inputs")
+          readSockets(a_fields.inputs, a_fields);
+        else if (ioKey == "outputs")
+          readSockets(a_fields.outputs, a_fields);
+        else
+          a_fields.extras["element"]["io"][ioKey] = m_reader.readValue();
+      }
+    } else
+      a_fields.extras["element"][key] = m_reader.readValue();
+  }
+}
+
+void PackageLoader::readSockets(std::vector<Socket> &a_sockets, Fields &a_fields)
+{
+  std::string key{}, type{};
+
+  m_reader.beginArray();
+  while (m_reader.nextItem()) {
+    Socket socket{};
+
+    m_reader.beginObject();
+    while (m_reader.nextKey(key)) {
+      if (key == "socket")
+        socket.index = static_cast<uint8_t>(m_reader.readUnsigned());
+      else if (key == "name")
+        m_reader.readString(socket.name);
+      else if (key == "flags")
+        socket.flags = static_cast<uint8_t>(m_reader.readUnsigned());
+      else if (key == "type") {
+        m_reader.readString(type);
+        if (type == "bool")
+          socket.type = ValueType::eBool;
+        else if (type == "int")
+          socket.type = ValueType::eInt;
+        else if (type == "float")
+          socket.type = ValueType::eFloat;
+        else
+          throw std::runtime_error{ "unknown socket type " + type };
+      } else {
+        socket.extras[key] = m_reader.readValue();
+        a_fields.hasSocketExtras = true;
+      }
+    }
+
+    if (socket.index != a_sockets.size()) throw std::runtime_error{ "sockets out of order" };
+    a_sockets.emplace_back(std::move(socket));
+  }
+}
+
+void PackageLoader::readNodeGroup(Fields &a_fields)
+{
+  std::string key{};
+  m_reader.beginObject();
+  while (m_reader.nextKey(key)) {
+    if (key == "position")
+      readPosition(a_fields.position);
+    else if (key == "iconify")
+      a_fields.iconify = m_reader.readBool();
+    else if (key == "inputs_position")
+      readPosition(a_fields.inputsPosition);
+    else if (key == "outputs_position")
+      readPosition(a_fields.outputsPosition);
+    else
+      a_fields.extras["node"][key] = m_reader.readValue();
+  }
+}
+
+void PackageLoader::readPosition(Element::Vec2 &a_position)
+{
+  std::string key{};
+  m_reader.beginObject();
+  while (m_reader.nextKey(key)) {
+    if (key == "x")
+      a_position.x = m_reader.readDouble();
+    else if (key == "y")
+      a_position.y = m_reader.readDouble();
+    else
+      m_reader.skipValue();
+  }
+}
+
+void PackageLoader::readPackageGroup(Package &a_package)
+{
+  // Connections come first in sorted documents, they wait for the elements.
+  RemappedIds remappedIds{ { 0, 0 } };
+  Package::Connections connections{};
+  Batch batch{};
+
+  std::string key{};
+  m_reader.beginObject();
+  while (m_reader.nextKey(key)) {
+    if (key == "description")
+      a_package.setPackageDescription(m_reader.readString());
+    else if (key == "path")
+      a_package.setPackagePath(m_reader.readString());
+    else if (key == "icon")
+      a_package.setPackageIcon(m_reader.readString());
+    else if (key == "reference") {
+      a_package.m_reference = m_reader.readBool();
+      a_package.m_materialized = !a_package.m_reference;
+    } else if (key == "elements") {
+      m_reader.beginArray();
+      while (m_reader.nextItem()) readElement(a_package, remappedIds, batch);
+      flush(a_package, remappedIds, batch);
+    } else if (key == "connections") {
+      m_reader.beginArray();
+      while (m_reader.nextItem()) connections.push_back(readConnection());
+    } else
+      m_reader.skipValue();
+  }
+
+  size_t const PENDING{ batch.capacity() * sizeof(Fields) + connections.capacity() * sizeof(Package::Connection) +
+                        remappedIds.size() * (sizeof(RemappedIds::value_type) + 2 * sizeof(void *)) };
+  m_peakPendingBytes = std::max(m_peakPendingBytes, PENDING);
+
+  for (auto const &CONNECTION : connections) {
+    auto const FROM = remappedIds.find(CONNECTION.from_id);
+    auto const TO = remappedIds.find(CONNECTION.to_id);
+    if (FROM == std::end(remappedIds) || TO == std::end(remappedIds) ||
+        !a_package.canConnect(FROM->second, CONNECTION.from_socket, TO->second, CONNECTION.to_socket)) {
+      log::error("Skipping connection {}@{} -> {}@{}", CONNECTION.from_id, static_cast<int>(CONNECTION.from_socket),
+                 CONNECTION.to_id, static_cast<int>(CONNECTION.to_socket));
+      continue;
+    }
+    a_package.connect(FROM->second, CONNECTION.from_socket, TO->second, CONNECTION.to_socket);
+  }
+
+  a_package.m_dependencies.merge();
+}
+
+Package::Connection PackageLoader::readConnection()
+{
+  Package::Connection connection{};
+
+  std::string key{}, endKey{};
+  m_reader.beginObject();
+  while (m_reader.nextKey(key)) {
+    if (key != "connect" && key != "to") {
+      m_reader.skipValue();
+      continue;
+    }
+
+    bool const FROM{ key == "connect" };
+    m_reader.beginObject();
+    while (m_reader.nextKey(endKey)) {
+      if (endKey == "id")
+        (FROM ? connection.from_id : connection.to_id) = m_reader.readUnsigned();
+      else if (endKey == "socket")
+        (FROM ? connection.from_socket : connection.to_socket) = static_cast<uint8_t>(m_reader.readUnsigned());
+      else
+        m_reader.skipValue();
+    }
+  }
+
+  return connection;
+}
+
+void PackageLoader::flush(Package &a_parent, RemappedIds &a_remappedIds, Batch &a_batch)
+{
+  if (a_batch.empty()) return;
+
+  std::vector<string::hash_t> types{};
+  types.reserve(a_batch.size());
+  for (auto const &FIELDS : a_batch) types.push_back(string::hash(FIELDS.type));
+
+  size_t const FIRST_ID{ a_parent.addBulk(
+    types, [&a_batch](size_t const a_index, Element &a_element) { init(a_element, a_batch[a_index]); }) };
+
+  for (size_t i = 0; i < a_batch.size(); ++i) a_remappedIds[a_batch[i].id] = FIRST_ID + i;
+
+  a_batch.clear();
+}
+
+Element *PackageLoader::create(Package &a_parent, Fields const &a_fields, RemappedIds &a_remappedIds)
+{
+  auto const HASH = string::hash(a_fields.type);
+  if (!Registry::get().hasElement(HASH)) {
+    log::error("Unknown element type {}", a_fields.type);
+    return nullptr;
+  }
+
+  Element *const element{ a_parent.add(HASH) };
+  a_remappedIds[a_fields.id] = element->id();
+
+  return element;
+}
+
+void PackageLoader::apply(Element &a_element, Fields const &a_fields)
+{
+  a_element.setName(a_fields.name);
+  a_element.clearInputs();
+  a_element.clearOutputs();
+  a_element.setMinInputs(a_fields.minInputs);
+  a_element.setMaxInputs(a_fields.maxInputs);
+  a_element.setMinOutputs(a_fields.minOutputs);
+  a_element.setMaxOutputs(a_fields.maxOutputs);
+  a_element.setDefaultNewInputFlags(a_fields.defaultNewInputFlags);
+  a_element.setDefaultNewOutputFlags(a_fields.defaultNewOutputFlags);
+
+  for (auto const &SOCKET : a_fields.inputs) a_element.addInput(SOCKET.type, SOCKET.name, SOCKET.flags);
+  for (auto const &SOCKET : a_fields.outputs) a_element.addOutput(SOCKET.type, SOCKET.name, SOCKET.flags);
+
+  applyNode(a_element, a_fields);
+}
+
+void PackageLoader::applyNode(Element &a_element, Fields const &a_fields)
+{
+  a_element.setPosition(a_fields.position.x, a_fields.position.y);
+  a_element.iconify(a_fields.iconify);
+
+  if (a_element.hash() == Package::HASH) {
+    auto &package = static_cast<Package &>(a_element);
+    package.setInputsPosition(a_fields.inputsPosition.x, a_fields.inputsPosition.y);
+    package.setOutputsPosition(a_fields.outputsPosition.x, a_fields.outputsPosition.y);
+  }
+}
+
+void PackageLoader::init(Element &a_element, Fields const &a_fields)
+{
+  if (!a_fields.hasExtras())
+    apply(a_element, a_fields);
+  else
+    a_element.deserialize(toJson(a_fields));
+}
+
+PackageLoader::Json PackageLoader::toJson(Fields const &a_fields)
+{
+  auto sockets = [](std::vector<Socket> const &a_sockets) {
+    auto jsonSockets = Json::array();
+    for (auto const &SOCKET : a_sockets) {
+      Json socket = SOCKET.extras.is_null() ? Json::object() : SOCKET.extras;
+      socket["socket"] = SOCKET.index;
+      socket["type"] = SOCKET.type == ValueType::eBool ? "bool" : SOCKET.type == ValueType::eInt ? "int" : "float";
+      socket["name"] = SOCKET.name;
+      socket["flags"] = SOCKET.flags;
+      jsonSockets.push_back(socket);
+    }
+    return jsonSockets;
+  };
+
+  // Extras only hold keys not written below, so they can be the base.
+  Json json = a_fields.extras.is_null() ? Json::object() : a_fields.extras;
+
+  auto &jsonElement = json["element"];
+  jsonElement["id"] = a_fields.id;
+  jsonElement["name"] = a_fields.name;
+  jsonElement["type"] = a_fields.type;
+  jsonElement["min_inputs"] = a_fields.minInputs;
+  jsonElement["max_inputs"] = a_fields.maxInputs;
+  jsonElement["min_outputs"] = a_fields.minOutputs;
+  jsonElement["max_outputs"] = a_fields.maxOutputs;
+  jsonElement["default_new_input_flags"] = a_fields.defaultNewInputFlags;
+  jsonElement["default_new_output_flags"] = a_fields.defaultNewOutputFlags;
+  jsonElement["io"]["inputs"] = sockets(a_fields.inputs);
+  jsonElement["io"]["outputs"] = sockets(a_fields.outputs);
+
+  auto &jsonNode = json["node"];
+  jsonNode["position"]["x"] = a_fields.position.x;
+  jsonNode["position"]["y"] = a_fields.position.y;
+  jsonNode["iconify"] = a_fields.iconify;
+
+  if (string::hash(a_fields.type) != Package::HASH) return json;
+
+  jsonNode["inputs_position"]["x"] = a_fields.inputsPosition.x;
+  jsonNode["inputs_position"]["y"] = a_fields.inputsPosition.y;
+  jsonNode["outputs_position"]["x"] = a_fields.outputsPosition.x;
+  jsonNode["outputs_position"]["y"] = a_fields.outputsPosition.y;
+
+  return json;
+}
+
+} // namespace spaghetti
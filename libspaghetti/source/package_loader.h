@@ -0,0 +1,112 @@
+// MIT License
+//
+// Copyright (c) 2017-2018 Artur Wyszyński, aljen at hitomi dot pl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+#ifndef SPAGHETTI_PACKAGE_LOADER_H
+#define SPAGHETTI_PACKAGE_LOADER_H
+
+#include <istream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "json_reader.h"
+#include "spaghetti/package.h"
+
+namespace spaghetti {
+
+// Builds a package while its JSON is being tokenized, elements and
+// connections are created as they're read instead of from a finished DOM.
+// Keys an element type adds on top of Element::serialize() are collected
+// per element and handed to its deserialize(), which keeps plugins working.
+// A package with such keys ahead of its contents is read as a DOM like any
+// element with extras. Plain elements are read in batches and built by
+// Package::addBulk().
+class PackageLoader final {
+ public:
+  explicit PackageLoader(std::istream &a_stream);
+
+  // Throws std::runtime_error on malformed input.
+  void load(Package &a_package);
+
+  size_t peakBytes() const { return m_reader.bufferSize() + m_peakPendingBytes; }
+
+ private:
+  using Json = Element::Json;
+  using RemappedIds = std::unordered_map<uint64_t, size_t>;
+
+  struct Socket {
+    std::string name{};
+    ValueType type{};
+    uint8_t flags{};
+    uint8_t index{};
+    Json extras{};
+  };
+
+  struct Fields {
+    std::string type{};
+    std::string name{};
+    uint64_t id{};
+    uint8_t minInputs{};
+    uint8_t maxInputs{};
+    uint8_t minOutputs{};
+    uint8_t maxOutputs{};
+    uint8_t defaultNewInputFlags{};
+    uint8_t defaultNewOutputFlags{};
+    std::vector<Socket> inputs{};
+    std::vector<Socket> outputs{};
+    Element::Vec2 position{};
+    Element::Vec2 inputsPosition{};
+    Element::Vec2 outputsPosition{};
+    bool iconify{};
+    bool hasElement{};
+    bool hasSocketExtras{};
+    Json extras{};
+
+    bool hasExtras() const { return !extras.is_null() || hasSocketExtras; }
+  };
+
+  using Batch = std::vector<Fields>;
+
+  void readElement(Package &a_parent, RemappedIds &a_remappedIds, Batch &a_batch);
+  void readElementGroup(Fields &a_fields);
+  void readSockets(std::vector<Socket> &a_sockets, Fields &a_fields);
+  void readNodeGroup(Fields &a_fields);
+  void readPosition(Element::Vec2 &a_position);
+  void readPackageGroup(Package &a_package);
+  Package::Connection readConnection();
+  void flush(Package &a_parent, RemappedIds &a_remappedIds, Batch &a_batch);
+
+  static Element *create(Package &a_parent, Fields const &a_fields, RemappedIds &a_remappedIds);
+  static void apply(Element &a_element, Fields const &a_fields);
+  static void applyNode(Element &a_element, Fields const &a_fields);
+  static void init(Element &a_element, Fields const &a_fields);
+  static Json toJson(Fields const &a_fields);
+
+ private:
+  JsonReader m_reader;
+  size_t m_peakPendingBytes{};
+};
+
+} // namespace spaghetti
+
+#endif // SPAGHETTI_PACKAGE_LOADER_H
@@ -0,0 +1,110 @@
+// MIT License
+//
+// Copyright (c) 2017-2018 Artur Wyszyński, aljen at hitomi dot pl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "package_snapshot.h"
+
+#include "spaghetti/registry.h"
+
+namespace spaghetti {
+
+PackageSnapshot::PackageSnapshot(Package &a_package)
+{
+  addPackage(a_package, add(a_package));
+}
+
+uint32_t PackageSnapshot::add(Element &a_element)
+{
+  auto const INDEX = static_cast<uint32_t>(m_elements.size());
+
+  ElementRecord record{};
+  record.type = a_element.type();
+  record.id = a_element.id();
+  record.name = a_element.nameHandle();
+  record.position = a_element.position();
+  record.iconified = a_element.isIconified();
+  record.minInputs = a_element.minInputs();
+  record.maxInputs = a_element.maxInputs();
+  record.minOutputs = a_element.minOutputs();
+  record.maxOutputs = a_element.maxOutputs();
+  record.defaultNewInputFlags = a_element.defaultNewInputFlags();
+  record.defaultNewOutputFlags = a_element.defaultNewOutputFlags();
+  record.firstSocket = static_cast<uint32_t>(m_sockets.size());
+  record.inputs = static_cast<uint32_t>(a_element.inputs().size());
+  record.outputs = static_cast<uint32_t>(a_element.outputs().size());
+
+  for (auto const *const SOCKETS : { &a_element.inputs(), &a_element.outputs() })
+    for (auto const &SOCKET : *SOCKETS) m_sockets.push_back({ SOCKET.name, SOCKET.type, SOCKET.flags });
+
+  if (a_element.hash() != Package::HASH && Registry::get().metaInfoFor(a_element.hash()).customSerialize) {
+    record.custom = static_cast<uint32_t>(m_customs.size());
+    m_customs.emplace_back();
+    a_element.serialize(m_customs.back());
+  }
+
+  m_elements.push_back(record);
+  return INDEX;
+}
+
+void PackageSnapshot::addPackage(Package &a_package, uint32_t const a_element)
+{
+  auto const INDEX = static_cast<uint32_t>(m_packages.size());
+  m_elements[a_element].package = INDEX;
+
+  PackageRecord record{};
+  record.element = a_element;
+  record.description = a_package.packageDescription();
+  record.icon = a_package.packageIcon();
+  record.path = a_package.packagePath();
+  record.reference = a_package.isReference();
+  record.inputsPosition = a_package.inputsPosition();
+  record.outputsPosition = a_package.outputsPosition();
+  m_packages.push_back(std::move(record));
+
+  // A reference is written without its contents, they belong to the file it refers to.
+  if (a_package.isReference()) return;
+
+  auto const &CONNECTIONS = a_package.connections();
+  m_packages[INDEX].firstConnection = m_connections.size();
+  m_packages[INDEX].connections = CONNECTIONS.size();
+  m_connections.insert(std::end(m_connections), std::begin(CONNECTIONS), std::end(CONNECTIONS));
+
+  // Children of nested packages are added while walking this one's, its own are kept
+  // aside to stay in one range.
+  std::vector<uint32_t> children{};
+  auto const &ELEMENTS = a_package.elements();
+  size_t const SIZE{ ELEMENTS.size() };
+  children.reserve(SIZE);
+  for (size_t i = 1; i < SIZE; ++i) {
+    Element *const ELEMENT{ ELEMENTS[i] };
+    if (!ELEMENT) continue;
+
+    uint32_t const CHILD{ add(*ELEMENT) };
+    children.push_back(CHILD);
+    if (ELEMENT->hash() == Package::HASH) addPackage(static_cast<Package &>(*ELEMENT), CHILD);
+  }
+
+  m_packages[INDEX].firstChild = m_children.size();
+  m_packages[INDEX].children = children.size();
+  m_children.insert(std::end(m_children), std::begin(children), std::end(children));
+}
+
+} // namespace spaghetti
@@ -0,0 +1,115 @@
+// MIT License
+//
+// Copyright (c) 2017-2018 Artur Wyszyński, aljen at hitomi dot pl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+#ifndef SPAGHETTI_PACKAGE_SNAPSHOT_H
+#define SPAGHETTI_PACKAGE_SNAPSHOT_H
+
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "spaghetti/package.h"
+
+namespace spaghetti {
+
+// What a package file holds, copied out of a package and everything nested in
+// it in one flat pass. Writing it takes no locks and doesn't touch the package,
+// which can be edited and dispatched meanwhile. Names stay interned handles kept
+// alive by a string::Hold, element types with keys of their own are kept as their
+// serialize() output.
+class PackageSnapshot final {
+ public:
+  using Json = Element::Json;
+
+  static constexpr uint32_t const NONE{ std::numeric_limits<uint32_t>::max() };
+
+  struct Socket {
+    string::handle_t name{};
+    ValueType type{};
+    uint8_t flags{};
+  };
+
+  struct ElementRecord {
+    char const *type{};
+    size_t id{};
+    string::handle_t name{};
+    Element::Vec2 position{};
+    bool iconified{};
+    uint8_t minInputs{};
+    uint8_t maxInputs{};
+    uint8_t minOutputs{};
+    uint8_t maxOutputs{};
+    uint8_t defaultNewInputFlags{};
+    uint8_t defaultNewOutputFlags{};
+    uint32_t firstSocket{};
+    uint32_t inputs{};
+    uint32_t outputs{};
+    // Into packages() for a package, into customs() for a type serializing itself.
+    uint32_t package{ NONE };
+    uint32_t custom{ NONE };
+  };
+
+  struct PackageRecord {
+    uint32_t element{};
+    std::string description{};
+    std::string icon{};
+    std::string path{};
+    bool reference{};
+    Element::Vec2 inputsPosition{};
+    Element::Vec2 outputsPosition{};
+    // Ranges of connections() and children(), empty for a reference.
+    size_t firstConnection{};
+    size_t connections{};
+    size_t firstChild{};
+    size_t children{};
+  };
+
+  explicit PackageSnapshot(Package &a_package);
+
+  // The package the snapshot was taken of is the first one.
+  std::vector<PackageRecord> const &packages() const { return m_packages; }
+  std::vector<ElementRecord> const &elements() const { return m_elements; }
+  std::vector<Socket> const &sockets() const { return m_sockets; }
+  Package::Connections const &connections() const { return m_connections; }
+  // Element records of every package's elements, in the order they're written.
+  std::vector<uint32_t> const &children() const { return m_children; }
+  std::vector<Json> const &customs() const { return m_customs; }
+
+ private:
+  uint32_t add(Element &a_element);
+  void addPackage(Package &a_package, uint32_t const a_element);
+
+ private:
+  // First in, last out: names copied below outlive renames until the file is written.
+  string::Hold m_hold{};
+  std::vector<PackageRecord> m_packages{};
+  std::vector<ElementRecord> m_elements{};
+  std::vector<Socket> m_sockets{};
+  Package::Connections m_connections{};
+  std::vector<uint32_t> m_children{};
+  std::vector<Json> m_customs{};
+};
+
+} // namespace spaghetti
+
+#endif // SPAGHETTI_PACKAGE_SNAPSHOT_H
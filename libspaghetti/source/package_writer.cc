@@ -0,0 +1,229 @@
+// MIT License
+//
+// Copyright (c) 2017-2018 Artur Wyszyński, aljen at hitomi dot pl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "package_writer.h"
+
+namespace spaghetti {
+
+namespace {
+
+char const *socket_type(ValueType const a_type)
+{
+  switch (a_type) {
+    case ValueType::eBool: return "bool";
+    case ValueType::eInt: return "int";
+    case ValueType::eFloat: return "float";
+  }
+  return "unknown";
+}
+
+} // namespace
+
+PackageWriter::PackageWriter(std::ostream &a_stream, bool const a_compact)
+  : m_writer{ a_stream, a_compact ? -1 : 2 }
+{
+}
+
+void PackageWriter::write(PackageSnapshot const &a_snapshot)
+{
+  m_snapshot = &a_snapshot;
+  writePackage(0);
+  m_writer.flush();
+  m_snapshot = nullptr;
+}
+
+void PackageWriter::writeElement(uint32_t const a_element)
+{
+  auto const &ELEMENT = m_snapshot->elements()[a_element];
+
+  if (ELEMENT.package != PackageSnapshot::NONE) {
+    writePackage(ELEMENT.package);
+    return;
+  }
+
+  if (ELEMENT.custom != PackageSnapshot::NONE) {
+    m_writer.value(m_snapshot->customs()[ELEMENT.custom]);
+    return;
+  }
+
+  // Keys in the order Json keeps them, sorted.
+  m_writer.beginObject();
+  m_writer.key("element");
+  writeElementGroup(ELEMENT);
+  m_writer.key("node");
+  writeNodeGroup(ELEMENT, nullptr);
+  m_writer.endObject();
+}
+
+void PackageWriter::writePackage(uint32_t const a_package)
+{
+  auto const &PACKAGE = m_snapshot->packages()[a_package];
+  auto const &ELEMENT = m_snapshot->elements()[PACKAGE.element];
+
+  m_writer.beginObject();
+  m_writer.key("element");
+  writeElementGroup(ELEMENT);
+  m_writer.key("node");
+  writeNodeGroup(ELEMENT, &PACKAGE);
+  m_writer.key("package");
+  writePackageGroup(PACKAGE);
+  m_writer.endObject();
+}
+
+void PackageWriter::writeElementGroup(ElementRecord const &a_element)
+{
+  m_writer.beginObject();
+  m_writer.key("default_new_input_flags");
+  m_writer.value(uint64_t{ a_element.defaultNewInputFlags });
+  m_writer.key("default_new_output_flags");
+  m_writer.value(uint64_t{ a_element.defaultNewOutputFlags });
+  m_writer.key("id");
+  m_writer.value(static_cast<uint64_t>(a_element.id));
+  m_writer.key("io");
+  m_writer.beginObject();
+  m_writer.key("inputs");
+  writeSockets(a_element.firstSocket, a_element.inputs);
+  m_writer.key("outputs");
+  writeSockets(a_element.firstSocket + a_element.inputs, a_element.outputs);
+  m_writer.endObject();
+  m_writer.key("max_inputs");
+  m_writer.value(uint64_t{ a_element.maxInputs });
+  m_writer.key("max_outputs");
+  m_writer.value(uint64_t{ a_element.maxOutputs });
+  m_writer.key("min_inputs");
+  m_writer.value(uint64_t{ a_element.minInputs });
+  m_writer.key("min_outputs");
+  m_writer.value(uint64_t{ a_element.minOutputs });
+  m_writer.key("name");
+  m_writer.value(std::string_view{ string::lookup(a_element.name) });
+  m_writer.key("type");
+  m_writer.value(a_element.type);
+  m_writer.endObject();
+}
+
+void PackageWriter::writeSockets(uint32_t const a_first, uint32_t const a_count)
+{
+  auto const &SOCKETS = m_snapshot->sockets();
+
+  m_writer.beginArray();
+  for (uint32_t i = 0; i < a_count; ++i) {
+    auto const &SOCKET = SOCKETS[a_first + i];
+    m_writer.beginObject();
+    m_writer.key("flags");
+    m_writer.value(uint64_t{ SOCKET.flags });
+    m_writer.key("name");
+    m_writer.value(std::string_view{ string::lookup(SOCKET.name) });
+    m_writer.key("socket");
+    m_writer.value(static_cast<uint64_t>(i));
+    m_writer.key("type");
+    m_writer.value(socket_type(SOCKET.type));
+    m_writer.endObject();
+  }
+  m_writer.endArray();
+}
+
+void PackageWriter::writeNodeGroup(ElementRecord const &a_element,
+                                   PackageSnapshot::PackageRecord const *const a_package)
+{
+  m_writer.beginObject();
+  m_writer.key("iconify");
+  m_writer.value(a_element.iconified);
+  if (a_package) {
+    m_writer.key("inputs_position");
+    writePosition(a_package->inputsPosition);
+    m_writer.key("outputs_position");
+    writePosition(a_package->outputsPosition);
+  }
+  m_writer.key("position");
+  writePosition(a_element.position);
+  m_writer.endObject();
+}
+
+void PackageWriter::writePosition(Element::Vec2 const &a_position)
+{
+  m_writer.beginObject();
+  m_writer.key("x");
+  m_writer.value(static_cast<double>(a_position.x));
+  m_writer.key("y");
+  m_writer.value(static_cast<double>(a_position.y));
+  m_writer.endObject();
+}
+
+void PackageWriter::writePackageGroup(PackageSnapshot::PackageRecord const &a_package)
+{
+  bool const REFERENCE{ a_package.reference };
+
+  m_writer.beginObject();
+
+  if (!REFERENCE) {
+    auto const &CONNECTIONS = m_snapshot->connections();
+    m_writer.key("connections");
+    m_writer.beginArray();
+    for (size_t i = 0; i < a_package.connections; ++i) writeConnection(CONNECTIONS[a_package.firstConnection + i]);
+    m_writer.endArray();
+  }
+
+  m_writer.key("description");
+  m_writer.value(std::string_view{ a_package.description });
+
+  if (!REFERENCE) {
+    auto const &CHILDREN = m_snapshot->children();
+    m_writer.key("elements");
+    m_writer.beginArray();
+    for (size_t i = 0; i < a_package.children; ++i) writeElement(CHILDREN[a_package.firstChild + i]);
+    m_writer.endArray();
+  }
+
+  m_writer.key("icon");
+  m_writer.value(std::string_view{ a_package.icon });
+  m_writer.key("path");
+  m_writer.value(std::string_view{ a_package.path });
+
+  if (REFERENCE) {
+    m_writer.key("reference");
+    m_writer.value(true);
+  }
+
+  m_writer.endObject();
+}
+
+void PackageWriter::writeConnection(Package::Connection const &a_connection)
+{
+  m_writer.beginObject();
+  m_writer.key("connect");
+  m_writer.beginObject();
+  m_writer.key("id");
+  m_writer.value(static_cast<uint64_t>(a_connection.from_id));
+  m_writer.key("socket");
+  m_writer.value(uint64_t{ a_connection.from_socket });
+  m_writer.endObject();
+  m_writer.key("to");
+  m_writer.beginObject();
+  m_writer.key("id");
+  m_writer.value(static_cast<uint64_t>(a_connection.to_id));
+  m_writer.key("socket");
+  m_writer.value(uint64_t{ a_connection.to_socket });
+  m_writer.endObject();
+  m_writer.endObject();
+}
+
+} // namespace spaghetti
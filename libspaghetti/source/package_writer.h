@@ -0,0 +1,62 @@
+// MIT License
+//
+// Copyright (c) 2017-2018 Artur Wyszyński, aljen at hitomi dot pl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+#ifndef SPAGHETTI_PACKAGE_WRITER_H
+#define SPAGHETTI_PACKAGE_WRITER_H
+
+#include <ostream>
+
+#include "json_writer.h"
+#include "package_snapshot.h"
+
+namespace spaghetti {
+
+// Writes a package snapshot as JSON, the counterpart of PackageLoader. Only
+// element types with keys of their own were serialize()d, one element at a
+// time, while the snapshot was taken.
+class PackageWriter final {
+ public:
+  PackageWriter(std::ostream &a_stream, bool const a_compact);
+
+  void write(PackageSnapshot const &a_snapshot);
+
+ private:
+  using ElementRecord = PackageSnapshot::ElementRecord;
+
+  void writeElement(uint32_t const a_element);
+  void writePackage(uint32_t const a_package);
+  void writeElementGroup(ElementRecord const &a_element);
+  void writeSockets(uint32_t const a_first, uint32_t const a_count);
+  void writeNodeGroup(ElementRecord const &a_element, PackageSnapshot::PackageRecord const *const a_package);
+  void writePosition(Element::Vec2 const &a_position);
+  void writePackageGroup(PackageSnapshot::PackageRecord const &a_package);
+  void writeConnection(Package::Connection const &a_connection);
+
+ private:
+  JsonWriter m_writer;
+  PackageSnapshot const *m_snapshot{};
+};
+
+} // namespace spaghetti
+
+#endif // SPAGHETTI_PACKAGE_WRITER_H
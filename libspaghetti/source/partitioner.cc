@@ -0,0 +1,243 @@
+// MIT License
+//
+// Copyright (c) 2017-2018 Artur Wyszyński, aljen at hitomi dot pl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "partitioner.h"
+
+#include <algorithm>
+#include <deque>
+#include <numeric>
+
+#include "elements/all.h"
+
+namespace spaghetti {
+
+namespace {
+
+float type_cost(string::hash_t const a_hash)
+{
+  using namespace elements;
+
+  switch (a_hash) {
+    case math::Cos::HASH:
+    case math::Sin::HASH: return 4.0f;
+    case math::BCD::HASH:
+    case ui::BCDToSevenSegmentDisplay::HASH:
+    case values::RandomBool::HASH: return 3.0f;
+    case logic::MultiplexerInt::HASH:
+    case logic::DemultiplexerInt::HASH:
+    case math::Divide::HASH:
+    case math::DivideIf::HASH: return 2.0f;
+    case logic::Blinker::HASH:
+    case logic::Clock::HASH: return 1.5f;
+    case Package::HASH: return 0.5f;
+    default: return 1.0f;
+  }
+}
+
+} // namespace
+
+float element_cost(Element const *const a_element)
+{
+  float const SOCKETS{ static_cast<float>(a_element->inputs().size() + a_element->outputs().size()) };
+  return type_cost(a_element->hash()) + 0.125f * SOCKETS;
+}
+
+std::vector<float> element_costs(Package::Elements const &a_elements)
+{
+  size_t const SIZE{ a_elements.size() };
+
+  std::vector<float> costs(SIZE, 0.0f);
+  for (size_t i = 0; i < SIZE; ++i)
+    if (a_elements[i]) costs[i] = element_cost(a_elements[i]);
+
+  return costs;
+}
+
+Partitioning partition_elements(Package::Elements const &a_elements, Package::Connections const &a_connections,
+                                size_t const a_partitions)
+{
+  return partition_elements(element_costs(a_elements), a_connections, a_partitions);
+}
+
+Partitioning partition_elements(std::vector<float> const &a_costs, Package::Connections const &a_connections,
+                                size_t const a_partitions)
+{
+  size_t const SIZE{ a_costs.size() };
+  size_t const PARTS{ std::max<size_t>(a_partitions, 1) };
+
+  Partitioning result{};
+  result.partitionOf.assign(SIZE, 0);
+  result.loads.assign(PARTS, 0.0f);
+
+  // Undirected adjacency, package IO (id 0) is pinned to the first partition
+  // and doesn't pull anything towards it.
+  std::vector<std::vector<size_t>> neighbours(SIZE);
+  for (auto const &CONNECTION : a_connections) {
+    if (CONNECTION.from_id == 0 || CONNECTION.to_id == 0) continue;
+    if (CONNECTION.from_id == CONNECTION.to_id) continue;
+    neighbours[CONNECTION.from_id].push_back(CONNECTION.to_id);
+    neighbours[CONNECTION.to_id].push_back(CONNECTION.from_id);
+  }
+
+  float const TOTAL{ std::accumulate(std::begin(a_costs), std::end(a_costs), 0.0f) };
+  float const TARGET{ TOTAL / static_cast<float>(PARTS) };
+  float const MAX_LOAD{ TARGET * 1.05f };
+
+  std::vector<bool> visited(SIZE, false);
+  visited[0] = true;
+  result.loads[0] += a_costs[0];
+
+  size_t part{};
+  std::deque<size_t> queue{};
+  for (size_t seed = 1; seed < SIZE; ++seed) {
+    if (visited[seed] || a_costs[seed] <= 0.0f) continue;
+
+    visited[seed] = true;
+    queue.push_back(seed);
+
+    while (!queue.empty()) {
+      size_t const CURRENT{ queue.front() };
+      queue.pop_front();
+
+      if (result.loads[part] + a_costs[CURRENT] > TARGET && result.loads[part] > 0.0f && part + 1 < PARTS) ++part;
+
+      result.partitionOf[CURRENT] = static_cast<uint32_t>(part);
+      result.loads[part] += a_costs[CURRENT];
+
+      for (size_t const NEIGHBOUR : neighbours[CURRENT]) {
+        if (visited[NEIGHBOUR]) continue;
+        visited[NEIGHBOUR] = true;
+        queue.push_back(NEIGHBOUR);
+      }
+    }
+  }
+
+  // Refinement, move boundary elements to the neighbouring partition that
+  // removes the most cut connections as long as it doesn't break the balance.
+  std::vector<int32_t> links(PARTS, 0);
+  constexpr size_t const MAX_PASSES{ 8 };
+  for (size_t pass = 0; pass < MAX_PASSES && PARTS > 1; ++pass) {
+    size_t moves{};
+
+    for (size_t i = 1; i < SIZE; ++i) {
+      if (a_costs[i] <= 0.0f || neighbours[i].empty()) continue;
+
+      uint32_t const FROM{ result.partitionOf[i] };
+      for (size_t const NEIGHBOUR : neighbours[i]) links[result.partitionOf[NEIGHBOUR]]++;
+
+      uint32_t best{ FROM };
+      int32_t bestGain{};
+      for (size_t const NEIGHBOUR : neighbours[i]) {
+        uint32_t const TO{ result.partitionOf[NEIGHBOUR] };
+        if (TO == FROM) continue;
+
+        int32_t const GAIN{ links[TO] - links[FROM] };
+        bool const FITS{ result.loads[TO] + a_costs[i] <= MAX_LOAD };
+        bool const BALANCES{ GAIN == 0 && result.loads[TO] + a_costs[i] < result.loads[FROM] };
+        if (FITS && (GAIN > bestGain || (GAIN == bestGain && best == FROM && BALANCES))) {
+          best = TO;
+          bestGain = GAIN;
+        }
+      }
+
+      for (size_t const NEIGHBOUR : neighbours[i]) links[result.partitionOf[NEIGHBOUR]] = 0;
+
+      if (best == FROM) continue;
+
+      result.loads[FROM] -= a_costs[i];
+      result.loads[best] += a_costs[i];
+      result.partitionOf[i] = best;
+      ++moves;
+    }
+
+    if (moves == 0) break;
+  }
+
+  for (auto const &CONNECTION : a_connections)
+    if (result.partitionOf[CONNECTION.from_id] != result.partitionOf[CONNECTION.to_id]) ++result.cutSize;
+
+  float const HEAVIEST{ *std::max_element(std::begin(result.loads), std::end(result.loads)) };
+  result.imbalance = TARGET > 0.0f ? static_cast<double>(HEAVIEST / TARGET) - 1.0 : 0.0;
+
+  return result;
+}
+
+Partitioning extend_partitioning(std::vector<uint32_t> const &a_previous, Package::Elements const &a_elements,
+                                 Package::Connections const &a_connections, size_t const a_partitions)
+{
+  size_t const SIZE{ a_elements.size() };
+  size_t const PARTS{ std::max<size_t>(a_partitions, 1) };
+  uint32_t const UNPLACED{ static_cast<uint32_t>(PARTS) };
+
+  Partitioning result{};
+  result.partitionOf.assign(SIZE, UNPLACED);
+  result.loads.assign(PARTS, 0.0f);
+
+  std::vector<float> const COSTS{ element_costs(a_elements) };
+
+  // Package IO stays with the first partition, like in partition_elements().
+  result.partitionOf[0] = 0;
+  result.loads[0] += COSTS[0];
+  for (size_t i = 1; i < SIZE; ++i) {
+    if (!a_elements[i] || i >= a_previous.size() || a_previous[i] >= PARTS) continue;
+    result.partitionOf[i] = a_previous[i];
+    result.loads[a_previous[i]] += COSTS[i];
+  }
+
+  for (auto const &CONNECTION : a_connections) {
+    size_t const FROM{ CONNECTION.from_id };
+    size_t const TO{ CONNECTION.to_id };
+    if (FROM == 0 || TO == 0) continue;
+
+    if (result.partitionOf[TO] == UNPLACED && result.partitionOf[FROM] != UNPLACED) {
+      result.partitionOf[TO] = result.partitionOf[FROM];
+      result.loads[result.partitionOf[TO]] += COSTS[TO];
+    } else if (result.partitionOf[FROM] == UNPLACED && result.partitionOf[TO] != UNPLACED) {
+      result.partitionOf[FROM] = result.partitionOf[TO];
+      result.loads[result.partitionOf[FROM]] += COSTS[FROM];
+    }
+  }
+
+  for (size_t i = 1; i < SIZE; ++i) {
+    if (result.partitionOf[i] != UNPLACED) continue;
+    if (!a_elements[i]) {
+      result.partitionOf[i] = 0;
+      continue;
+    }
+
+    auto const LIGHTEST = std::min_element(std::begin(result.loads), std::end(result.loads));
+    result.partitionOf[i] = static_cast<uint32_t>(std::distance(std::begin(result.loads), LIGHTEST));
+    *LIGHTEST += COSTS[i];
+  }
+
+  for (auto const &CONNECTION : a_connections)
+    if (result.partitionOf[CONNECTION.from_id] != result.partitionOf[CONNECTION.to_id]) ++result.cutSize;
+
+  float const TOTAL{ std::accumulate(std::begin(result.loads), std::end(result.loads), 0.0f) };
+  float const TARGET{ TOTAL / static_cast<float>(PARTS) };
+  float const HEAVIEST{ *std::max_element(std::begin(result.loads), std::end(result.loads)) };
+  result.imbalance = TARGET > 0.0f ? static_cast<double>(HEAVIEST / TARGET) - 1.0 : 0.0;
+
+  return result;
+}
+
+} // namespace spaghetti
@@ -0,0 +1,65 @@
+// MIT License
+//
+// Copyright (c) 2017-2018 Artur Wyszyński, aljen at hitomi dot pl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+#ifndef SPAGHETTI_PARTITIONER_H
+#define SPAGHETTI_PARTITIONER_H
+
+#include <vector>
+
+#include "spaghetti/package.h"
+
+namespace spaghetti {
+
+// Estimated cost of one update() + calculate() of an element, in units of a
+// two input gate.
+float element_cost(Element const *const a_element);
+
+struct Partitioning {
+  std::vector<uint32_t> partitionOf{};
+  std::vector<float> loads{};
+  size_t cutSize{};
+  double imbalance{};
+};
+
+// element_cost() of every element, 0 for ids without one.
+std::vector<float> element_costs(Package::Elements const &a_elements);
+
+// Splits elements into a_partitions parts with balanced cost and as few
+// connections crossing parts as possible. Greedy BFS growth followed by
+// Fiduccia-Mattheyses style refinement passes.
+Partitioning partition_elements(Package::Elements const &a_elements, Package::Connections const &a_connections,
+                                size_t const a_partitions);
+// The same on element_costs() and a copy of the connections, so it can run on
+// another thread while the package is edited and dispatched.
+Partitioning partition_elements(std::vector<float> const &a_costs, Package::Connections const &a_connections,
+                                size_t const a_partitions);
+
+// Keeps elements where a_previous put them and places the rest next to a
+// connected element or on the lightest part. A single pass, cheap enough to
+// run between two ticks, the split only gets worse until partitioned again.
+Partitioning extend_partitioning(std::vector<uint32_t> const &a_previous, Package::Elements const &a_elements,
+                                 Package::Connections const &a_connections, size_t const a_partitions);
+
+} // namespace spaghetti
+
+#endif // SPAGHETTI_PARTITIONER_H
@@ -0,0 +1,195 @@
+// MIT License
+//
+// Copyright (c) 2017-2018 Artur Wyszyński, aljen at hitomi dot pl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "realtime.h"
+
+#if defined(_WIN64) || defined(_WIN32)
+# define WIN32_LEAN_AND_MEAN
+# include <Windows.h>
+#elif defined(__linux__)
+# include <pthread.h>
+# include <sched.h>
+# include <sys/mman.h>
+# include <time.h>
+#endif
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+#include "spaghetti/logger.h"
+
+namespace spaghetti {
+
+namespace {
+
+// Touch the stack up front so the first deep call in the dispatch loop
+// doesn't take a page fault.
+void prefault_stack()
+{
+  constexpr size_t const SIZE{ 256 * 1024 };
+  volatile char stack[SIZE];
+  for (size_t i = 0; i < SIZE; i += 4096) stack[i] = 0;
+  (void)stack[0];
+}
+
+// Workers go on consecutive cores from a_cpu, wrapping around the ones the
+// system has and an affinity mask can hold.
+size_t pinned_cpu(int32_t const a_cpu, size_t const a_index)
+{
+  size_t cpus{ std::max(std::thread::hardware_concurrency(), 1u) };
+#if defined(_WIN64) || defined(_WIN32)
+  cpus = std::min<size_t>(cpus, sizeof(DWORD_PTR) * CHAR_BIT);
+#elif defined(__linux__)
+  cpus = std::min<size_t>(cpus, CPU_SETSIZE);
+#endif
+
+  size_t const WANTED{ static_cast<size_t>(a_cpu) + a_index };
+  if (WANTED >= cpus)
+    log::warn("[realtime]: No cpu {}, dispatch thread {} shares cpu {}", WANTED, a_index, WANTED % cpus);
+  return WANTED % cpus;
+}
+
+std::mutex s_lockMutex{};
+size_t s_lockCount{};
+
+} // namespace
+
+Package::RealtimeStatus apply_realtime(Package::RealtimeOptions const &a_options, size_t const a_index)
+{
+  Package::RealtimeStatus status{};
+
+  if (!a_options.enabled) return status;
+
+#if defined(_WIN64) || defined(_WIN32)
+  HANDLE const THREAD{ GetCurrentThread() };
+
+  if (a_options.cpu >= 0) {
+    DWORD_PTR const MASK{ DWORD_PTR{ 1 } << pinned_cpu(a_options.cpu, a_index) };
+    status.pinned = SetThreadAffinityMask(THREAD, MASK) != 0;
+    if (!status.pinned) log::warn("[realtime]: SetThreadAffinityMask failed: {}", GetLastError());
+  }
+
+  // There's no SCHED_FIFO, the highest priority of the normal scheduler is the
+  // closest. status.fifo stays false, it isn't the same guarantee.
+  if (SetThreadPriority(THREAD, THREAD_PRIORITY_TIME_CRITICAL) == 0)
+    log::warn("[realtime]: SetThreadPriority failed: {}", GetLastError());
+  else
+    log::info("[realtime]: SCHED_FIFO isn't available, running at THREAD_PRIORITY_TIME_CRITICAL");
+
+#elif defined(__linux__)
+  pthread_t const THREAD{ pthread_self() };
+
+  if (a_options.cpu >= 0) {
+    size_t const CPU{ pinned_cpu(a_options.cpu, a_index) };
+    cpu_set_t cpus{};
+    CPU_ZERO(&cpus);
+    CPU_SET(CPU, &cpus);
+    int const ERROR{ pthread_setaffinity_np(THREAD, sizeof(cpus), &cpus) };
+    status.pinned = ERROR == 0;
+    if (!status.pinned) log::warn("[realtime]: Can't pin to cpu {}: {}", CPU, strerror(ERROR));
+  }
+
+  sched_param param{};
+  int const MIN_PRIORITY{ sched_get_priority_min(SCHED_FIFO) };
+  int const MAX_PRIORITY{ sched_get_priority_max(SCHED_FIFO) };
+  param.sched_priority = std::clamp(a_options.priority, MIN_PRIORITY, MAX_PRIORITY);
+  int const ERROR{ pthread_setschedparam(THREAD, SCHED_FIFO, &param) };
+  status.fifo = ERROR == 0;
+  if (!status.fifo)
+    log::warn("[realtime]: Can't switch to SCHED_FIFO({}): {}, staying on default scheduler", param.sched_priority,
+              strerror(ERROR));
+
+  // Memory itself is locked once per dispatch by lock_memory(), with MCL_FUTURE the
+  // stack pages touched here stay resident.
+  if (a_options.lockMemory) prefault_stack();
+#else
+  log::warn("[realtime]: Real-time dispatch is not supported on this platform");
+#endif
+
+  log::info("[realtime]: Dispatch thread {}: pinned: {}, fifo: {}", a_index, status.pinned, status.fifo);
+
+  return status;
+}
+
+bool lock_memory()
+{
+  std::lock_guard<std::mutex> lock{ s_lockMutex };
+
+  if (s_lockCount > 0) {
+    ++s_lockCount;
+    return true;
+  }
+
+#if defined(__linux__)
+  if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+    log::warn("[realtime]: Can't lock memory: {}", strerror(errno));
+    return false;
+  }
+
+  log::info("[realtime]: Memory locked");
+  ++s_lockCount;
+  return true;
+#else
+  log::warn("[realtime]: Locking memory is not supported on this platform");
+  return false;
+#endif
+}
+
+void unlock_memory()
+{
+  std::lock_guard<std::mutex> lock{ s_lockMutex };
+
+  if (s_lockCount == 0 || --s_lockCount > 0) return;
+
+#if defined(__linux__)
+  munlockall();
+  log::info("[realtime]: Memory unlocked");
+#endif
+}
+
+void precise_sleep_until(std::chrono::steady_clock::time_point const a_deadline, std::chrono::nanoseconds const a_spin)
+{
+  using clock_t = std::chrono::steady_clock;
+
+  auto const WAKE_UP = a_deadline - a_spin;
+
+#if defined(__linux__)
+  // libstdc++'s steady_clock is CLOCK_MONOTONIC, so the time point can be
+  // handed to clock_nanosleep as an absolute deadline.
+  auto const SINCE_EPOCH = std::chrono::duration_cast<std::chrono::nanoseconds>(WAKE_UP.time_since_epoch()).count();
+  timespec deadline{};
+  deadline.tv_sec = static_cast<time_t>(SINCE_EPOCH / 1000000000);
+  deadline.tv_nsec = static_cast<long>(SINCE_EPOCH % 1000000000);
+  while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, nullptr) == EINTR) {
+  }
+#else
+  std::this_thread::sleep_until(WAKE_UP);
+#endif
+
+  while (clock_t::now() < a_deadline) {
+  }
+}
+
+} // namespace spaghetti
@@ -0,0 +1,50 @@
+// MIT License
+//
+// Copyright (c) 2017-2018 Artur Wyszyński, aljen at hitomi dot pl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+#ifndef SPAGHETTI_REALTIME_H
+#define SPAGHETTI_REALTIME_H
+
+#include <chrono>
+
+#include "spaghetti/package.h"
+
+namespace spaghetti {
+
+// Applies a_options to the calling thread, a_index offsets the pinned CPU so
+// partition workers land on consecutive cores. Anything the process isn't
+// privileged to do is logged and skipped.
+Package::RealtimeStatus apply_realtime(Package::RealtimeOptions const &a_options, size_t const a_index);
+
+// Locks the process' memory for real-time dispatch. Counted, so packages dispatching
+// side by side lock once and the last unlock_memory() releases it. Returns false if
+// the lock couldn't be taken, unlock_memory() must then not be called.
+bool lock_memory();
+void unlock_memory();
+
+// Sleeps until an absolute a_deadline on the monotonic clock, the last a_spin
+// before it is busy-waited to hide the scheduler's wake-up jitter.
+void precise_sleep_until(std::chrono::steady_clock::time_point const a_deadline, std::chrono::nanoseconds const a_spin);
+
+} // namespace spaghetti
+
+#endif // SPAGHETTI_REALTIME_H
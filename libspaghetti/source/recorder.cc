@@ -0,0 +1,381 @@
+// MIT License
+//
+// Copyright (c) 2017-2018 Artur Wyszyński, aljen at hitomi dot pl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "spaghetti/recorder.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cctype>
+#include <cstring>
+#include <deque>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "spaghetti/logger.h"
+#include "binary_trace_writer.h"
+#include "spaghetti/package.h"
+#include "spaghetti/trace_reader.h"
+#include "spsc_ring.h"
+#include "trace_writer.h"
+#include "vcd_writer.h"
+
+namespace spaghetti {
+
+namespace {
+
+using clock_t = std::chrono::steady_clock;
+
+// Changes the writer takes from the ring at once.
+size_t const WRITE_BATCH{ 4096 };
+// How long the writer sleeps once it has caught up.
+std::chrono::milliseconds const WRITER_IDLE{ 2 };
+
+bool ends_with(std::string_view const a_string, std::string_view const a_suffix)
+{
+  return a_string.size() >= a_suffix.size() && a_string.substr(a_string.size() - a_suffix.size()) == a_suffix;
+}
+
+struct Signal {
+  Signal(Element *const a_element, uint8_t const a_socket, ValueType const a_type)
+    : element{ a_element }
+    , socket{ a_socket }
+    , type{ a_type }
+  {
+  }
+
+  // Cleared when the element is removed.
+  Element *element{};
+  uint8_t socket{};
+  ValueType type{};
+  std::atomic_bool enabled{ true };
+  // Dispatch thread only, whether last holds what the trace shows.
+  bool known{};
+  uint32_t last{};
+};
+
+std::string sanitized(std::string const &a_name)
+{
+  std::string name{ a_name };
+  for (auto &c : name)
+    if (!std::isalnum(static_cast<unsigned char>(c))) c = '_';
+  return name.empty() ? "_" : name;
+}
+
+// Element names needn't be unique or set at all.
+std::string label(Element const &a_element)
+{
+  std::string const NAME{ a_element.name() };
+  return sanitized(NAME.empty() ? a_element.type() : NAME) + "_" + std::to_string(a_element.id());
+}
+
+} // namespace
+
+struct Recorder::PIMPL {
+  PIMPL(Package &a_package, Options const &a_options)
+    : package{ &a_package }
+    , options{ a_options }
+  {
+  }
+
+  // Null once the package is gone.
+  Package *package{};
+  Options options{};
+  std::deque<Signal> signals{};
+
+  std::unique_ptr<SpscRing<TraceChange>> ring{};
+  std::unique_ptr<TraceWriter> writer{};
+  std::thread thread{};
+  std::atomic_bool recording{};
+  std::atomic_bool stopping{};
+  clock_t::time_point start{};
+
+  std::atomic_uint64_t ticks{};
+  std::atomic_uint64_t changes{};
+  std::atomic_uint64_t dropped{};
+  std::atomic_uint64_t sampleNanoseconds{};
+  uint64_t bytesWritten{};
+};
+
+Recorder::Recorder(Package &a_package)
+  : Recorder{ a_package, Options{} }
+{
+}
+
+Recorder::Recorder(Package &a_package, Options const &a_options)
+  : m_pimpl{ std::make_unique<PIMPL>(a_package, a_options) }
+{
+  int64_t timescale{ 1 };
+  while (timescale * 10 <= m_pimpl->options.timescale.count()) timescale *= 10;
+  m_pimpl->options.timescale = std::chrono::nanoseconds{ timescale };
+
+  assert(!a_package.m_recorder);
+
+  a_package.pauseDispatchThread();
+  a_package.m_recorder = this;
+  a_package.resumeDispatchThread();
+}
+
+Recorder::~Recorder()
+{
+  stop();
+
+  Package *const package{ m_pimpl->package };
+  if (!package) return;
+
+  package->pauseDispatchThread();
+  package->m_recorder = nullptr;
+  package->resumeDispatchThread();
+}
+
+Recorder::SignalId Recorder::addSignal(Element &a_element, uint8_t const a_output)
+{
+  assert(!isRecording());
+  assert(a_output < a_element.outputs().size());
+
+  auto &signals = m_pimpl->signals;
+  signals.emplace_back(&a_element, a_output, a_element.outputs()[a_output].type);
+  return static_cast<SignalId>(signals.size() - 1);
+}
+
+size_t Recorder::signals() const
+{
+  return m_pimpl->signals.size();
+}
+
+void Recorder::setEnabled(SignalId const a_signal, bool const a_enabled)
+{
+  m_pimpl->signals[a_signal].enabled = a_enabled;
+}
+
+bool Recorder::isEnabled(SignalId const a_signal) const
+{
+  return m_pimpl->signals[a_signal].enabled;
+}
+
+bool Recorder::start(std::string const &a_filename)
+{
+  auto &pimpl = *m_pimpl;
+  if (pimpl.recording || !pimpl.package) return false;
+
+  std::vector<TraceSignal> signals{};
+  for (auto &signal : pimpl.signals) {
+    signal.known = false;
+    if (!signal.element) {
+      signals.push_back({ "removed", "removed", signal.type });
+      continue;
+    }
+
+    std::string scope{ pimpl.package->name().empty() ? std::string{ "package" } : sanitized(pimpl.package->name()) };
+    std::vector<Package const *> parents{};
+    for (Package const *parent{ signal.element->package() }; parent && parent != pimpl.package;
+         parent = parent->package())
+      parents.push_back(parent);
+    for (auto it = parents.rbegin(); it != parents.rend(); ++it) scope += "." + label(**it);
+
+    Element const &ELEMENT{ *signal.element };
+    std::string const SOCKET{ sanitized(string::lookup(ELEMENT.outputs()[signal.socket].name)) };
+    signals.push_back({ scope, label(ELEMENT) + "_" + SOCKET, signal.type });
+  }
+
+  if (ends_with(a_filename, TraceReader::EXTENSION))
+    pimpl.writer = std::make_unique<BinaryTraceWriter>();
+  else
+    pimpl.writer = std::make_unique<VcdWriter>();
+  if (!pimpl.writer->open(a_filename, signals, pimpl.options.timescale)) {
+    log::error("[recorder]: Can't open {}", a_filename);
+    pimpl.writer.reset();
+    return false;
+  }
+
+  size_t const CAPACITY{ std::max<size_t>(pimpl.options.bufferBytes / sizeof(TraceChange), 1) };
+  pimpl.ring = std::make_unique<SpscRing<TraceChange>>(CAPACITY);
+  pimpl.ticks = 0;
+  pimpl.changes = 0;
+  pimpl.dropped = 0;
+  pimpl.sampleNanoseconds = 0;
+  pimpl.bytesWritten = 0;
+  pimpl.stopping = false;
+  pimpl.thread = std::thread(&Recorder::writeChanges, this);
+
+  pimpl.package->pauseDispatchThread();
+  pimpl.start = clock_t::now();
+  pimpl.recording = true;
+  pimpl.package->resumeDispatchThread();
+
+  log::info("[recorder]: Recording {} signals into {}", pimpl.signals.size(), a_filename);
+  return true;
+}
+
+bool Recorder::stop()
+{
+  auto &pimpl = *m_pimpl;
+  if (!pimpl.recording) return false;
+
+  if (pimpl.package) pimpl.package->pauseDispatchThread();
+  pimpl.recording = false;
+  if (pimpl.package) pimpl.package->resumeDispatchThread();
+
+  pimpl.stopping = true;
+  pimpl.thread.join();
+
+  bool const WRITTEN{ pimpl.writer->close(pimpl.bytesWritten) };
+  pimpl.writer.reset();
+  pimpl.ring.reset();
+
+  if (!WRITTEN) log::error("[recorder]: Trace is incomplete");
+  if (pimpl.dropped > 0) log::warn("[recorder]: {} changes didn't fit the buffer", pimpl.dropped.load());
+  log::info("[recorder]: Recorded {} changes over {} ticks, {} bytes", pimpl.changes.load(), pimpl.ticks.load(),
+            pimpl.bytesWritten);
+
+  return WRITTEN;
+}
+
+bool Recorder::isRecording() const
+{
+  return m_pimpl->recording;
+}
+
+Recorder::Stats Recorder::stats() const
+{
+  auto const &pimpl = *m_pimpl;
+
+  Stats stats{};
+  stats.ticks = pimpl.ticks;
+  stats.changes = pimpl.changes;
+  stats.dropped = pimpl.dropped;
+  stats.bytesWritten = pimpl.recording ? 0 : pimpl.bytesWritten;
+  stats.sampleTime = std::chrono::nanoseconds{ pimpl.sampleNanoseconds };
+  return stats;
+}
+
+void Recorder::sample()
+{
+  auto &pimpl = *m_pimpl;
+  if (!pimpl.recording.load(std::memory_order_acquire)) return;
+
+  auto const NOW = clock_t::now();
+  uint64_t const TIME{ static_cast<uint64_t>((NOW - pimpl.start) / pimpl.options.timescale) };
+
+  auto &ring = *pimpl.ring;
+  uint64_t changes{};
+  uint64_t dropped{};
+  uint32_t id{};
+
+  for (auto &signal : pimpl.signals) {
+    uint32_t const SIGNAL{ id++ };
+
+    Element const *const ELEMENT{ signal.element };
+    bool const ENABLED{ ELEMENT && signal.enabled.load(std::memory_order_relaxed) &&
+                        signal.socket < ELEMENT->outputs().size() &&
+                        ELEMENT->outputs()[signal.socket].type == signal.type };
+    if (!ENABLED) {
+      if (!signal.known) continue;
+      if (ring.push({ TIME, SIGNAL, TraceChange::Kind::eUnknown, 0 })) {
+        signal.known = false;
+        changes++;
+      } else
+        dropped++;
+      continue;
+    }
+
+    auto const &OUTPUT = ELEMENT->outputs()[signal.socket];
+    auto const &VALUES = ELEMENT->values();
+
+    uint32_t bits{};
+    TraceChange::Kind kind{};
+    switch (signal.type) {
+      case ValueType::eBool:
+        bits = VALUES.get<bool>(OUTPUT.index);
+        kind = TraceChange::Kind::eBool;
+        break;
+      case ValueType::eInt: {
+        int32_t const VALUE{ VALUES.get<int32_t>(OUTPUT.index) };
+        std::memcpy(&bits, &VALUE, sizeof(bits));
+        kind = TraceChange::Kind::eInt;
+        break;
+      }
+      case ValueType::eFloat: {
+        float const VALUE{ VALUES.get<float>(OUTPUT.index) };
+        std::memcpy(&bits, &VALUE, sizeof(bits));
+        kind = TraceChange::Kind::eFloat;
+        break;
+      }
+    }
+
+    if (signal.known && bits == signal.last) continue;
+
+    // A change that doesn't fit is picked up again on the next tick.
+    if (ring.push({ TIME, SIGNAL, kind, bits })) {
+      signal.known = true;
+      signal.last = bits;
+      changes++;
+    } else
+      dropped++;
+  }
+
+  auto const SPENT = std::chrono::duration_cast<std::chrono::nanoseconds>(clock_t::now() - NOW);
+  pimpl.ticks.fetch_add(1, std::memory_order_relaxed);
+  pimpl.changes.fetch_add(changes, std::memory_order_relaxed);
+  if (dropped) pimpl.dropped.fetch_add(dropped, std::memory_order_relaxed);
+  pimpl.sampleNanoseconds.fetch_add(static_cast<uint64_t>(SPENT.count()), std::memory_order_relaxed);
+}
+
+void Recorder::forget(Element const *const a_element)
+{
+  auto &pimpl = *m_pimpl;
+
+  if (a_element == pimpl.package) {
+    stop();
+    pimpl.package = nullptr;
+  }
+
+  for (auto &signal : pimpl.signals) {
+    for (Element const *element{ signal.element }; element; element = element->package()) {
+      if (element != a_element) continue;
+      signal.element = nullptr;
+      break;
+    }
+  }
+}
+
+void Recorder::writeChanges()
+{
+  auto &pimpl = *m_pimpl;
+  std::vector<TraceChange> batch(WRITE_BATCH);
+
+  while (true) {
+    // Read before draining, once the dispatch thread let go everything it queued is visible.
+    bool const STOPPING{ pimpl.stopping.load(std::memory_order_acquire) };
+
+    size_t const COUNT{ pimpl.ring->pop(batch.data(), batch.size()) };
+    if (COUNT > 0) {
+      pimpl.writer->write(batch.data(), COUNT);
+      continue;
+    }
+
+    if (STOPPING) break;
+    std::this_thread::sleep_for(WRITER_IDLE);
+  }
+}
+
+} // namespace spaghetti
@@ -31,8 +31,10 @@
 #endif
 // clang-format on
 
+#include <unordered_map>
 #include <vector>
 
+#include "element_arena.h"
 #include "filesystem.h"
 #include "shared_library.h"
 
@@ -68,13 +70,17 @@ namespace spaghetti {
 struct Registry::PIMPL {
   using Plugins = std::vector<std::shared_ptr<SharedLibrary>>;
   using MetaInfos = std::vector<MetaInfo>;
+  using Index = std::unordered_map<string::hash_t, size_t>;
   MetaInfos metaInfos{};
+  // Hash -> position in metaInfos, filled as elements (and plugins) register.
+  Index index{};
   Plugins plugins{};
   fs::path app_path{};
   fs::path system_plugins_path{};
   fs::path user_plugins_path{};
   fs::path system_packages_path{};
   fs::path user_packages_path{};
+  fs::path user_cache_path{};
 };
 
 Registry &Registry::get()
@@ -106,6 +112,7 @@ Registry::Registry()
 
   fs::path const USER_PLUGINS_PATH{ fs::absolute(APP_DATA_PATH / "Spaghetti/Plugins") };
   fs::path const USER_PACKAGES_PATH{ fs::absolute(APP_DATA_PATH / "Spaghetti/Packages") };
+  fs::path const USER_CACHE_PATH{ fs::absolute(APP_DATA_PATH / "Spaghetti/Cache") };
 #else
   fs::path const HOME_PATH{ getenv("HOME") };
 
@@ -115,16 +122,19 @@ Registry::Registry()
 
   fs::path const USER_PLUGINS_PATH{ fs::absolute(HOME_PATH / ".config/spaghetti/plugins") };
   fs::path const USER_PACKAGES_PATH{ fs::absolute(HOME_PATH / ".config/spaghetti/packages") };
+  fs::path const USER_CACHE_PATH{ fs::absolute(HOME_PATH / ".config/spaghetti/cache") };
 #endif
 
   fs::create_directories(USER_PLUGINS_PATH);
   fs::create_directories(USER_PACKAGES_PATH);
+  fs::create_directories(USER_CACHE_PATH);
 
   m_pimpl->app_path = APP_PATH;
   m_pimpl->system_plugins_path = SYSTEM_PLUGINS_PATH;
   m_pimpl->user_plugins_path = USER_PLUGINS_PATH;
   m_pimpl->system_packages_path = SYSTEM_PACKAGES_PATH;
   m_pimpl->user_packages_path = USER_PACKAGES_PATH;
+  m_pimpl->user_cache_path = USER_CACHE_PATH;
 }
 
 void Registry::registerInternalElements()
@@ -233,6 +243,21 @@ Element *Registry::createElement(string::hash_t const a_hash)
   return META_INFO.cloneElement();
 }
 
+Element *Registry::createElement(string::hash_t const a_hash, ElementArena &a_arena)
+{
+  auto const &META_INFO = metaInfoFor(a_hash);
+  assert(META_INFO.placeElement);
+  void *const MEMORY{ a_arena.allocate(a_hash, META_INFO.elementSize) };
+  a_arena.prepareEditorData();
+  try {
+    return META_INFO.placeElement(MEMORY);
+  } catch (...) {
+    a_arena.discardEditorData();
+    a_arena.deallocate(a_hash, MEMORY);
+    throw;
+  }
+}
+
 Node *Registry::createNode(string::hash_t const a_hash)
 {
   auto const &META_INFO = metaInfoFor(a_hash);
@@ -240,13 +265,13 @@ Node *Registry::createNode(string::hash_t const a_hash)
   return META_INFO.cloneNode();
 }
 
-std::string Registry::elementName(string::hash_t const a_hash)
+std::string const &Registry::elementName(string::hash_t const a_hash)
 {
   auto const &META_INFO = metaInfoFor(a_hash);
   return META_INFO.name;
 }
 
-std::string Registry::elementIcon(string::hash_t const a_hash)
+std::string const &Registry::elementIcon(string::hash_t const a_hash)
 {
   auto const &META_INFO = metaInfoFor(a_hash);
   return META_INFO.icon;
@@ -255,15 +280,13 @@ std::string Registry::elementIcon(string::hash_t const a_hash)
 void Registry::addElement(MetaInfo &a_metaInfo)
 {
   auto &metaInfos = m_pimpl->metaInfos;
+  m_pimpl->index.emplace(a_metaInfo.hash, metaInfos.size());
   metaInfos.push_back(std::move(a_metaInfo));
 }
 
 bool Registry::hasElement(string::hash_t const a_hash) const
 {
-  auto const &META_INFOS = m_pimpl->metaInfos;
-  auto const IT = std::find_if(std::begin(META_INFOS), std::end(META_INFOS),
-                               [a_hash](auto const &a_metaInfo) { return a_metaInfo.hash == a_hash; });
-  return IT != std::end(META_INFOS);
+  return m_pimpl->index.count(a_hash) != 0;
 }
 
 size_t Registry::size() const
@@ -274,11 +297,10 @@ size_t Registry::size() const
 
 Registry::MetaInfo const &Registry::metaInfoFor(string::hash_t const a_hash) const
 {
-  auto &metaInfos = m_pimpl->metaInfos;
-  assert(hasElement(a_hash));
-  auto const IT = std::find_if(std::begin(metaInfos), std::end(metaInfos),
-                               [a_hash](auto const &a_metaInfo) { return a_metaInfo.hash == a_hash; });
-  return *IT;
+  auto const &INDEX = m_pimpl->index;
+  auto const IT = INDEX.find(a_hash);
+  assert(IT != std::end(INDEX));
+  return m_pimpl->metaInfos[IT->second];
 }
 
 Registry::MetaInfo const &Registry::metaInfoAt(size_t const a_index) const
@@ -312,4 +334,9 @@ std::string Registry::userPackagesPath() const
   return m_pimpl->user_packages_path.string();
 }
 
+std::string Registry::userCachePath() const
+{
+  return m_pimpl->user_cache_path.string();
+}
+
 } // namespace spaghetti
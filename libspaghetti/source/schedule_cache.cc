@@ -0,0 +1,294 @@
+// MIT License
+//
+// Copyright (c) 2017-2018 Artur Wyszyński, aljen at hitomi dot pl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "schedule_cache.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+#include "filesystem.h"
+#include "mapped_file.h"
+#include "spaghetti/logger.h"
+#include "spaghetti/registry.h"
+#include "spaghetti/version.h"
+
+namespace spaghetti::schedule_cache {
+
+namespace {
+
+// Layout of a .schedule file, native endian:
+//
+//   Header | loads (float per partition) | partitionOf (uint32_t per element)
+constexpr char const MAGIC[8]{ 'S', 'P', 'A', 'G', 'S', 'C', 'H', '\0' };
+constexpr uint32_t VERSION{ 1 };
+
+struct Header {
+  char magic[8]{};
+  uint32_t version{};
+  uint32_t partitions{};
+  uint64_t key{};
+  uint64_t elements{};
+  uint64_t cutSize{};
+  double imbalance{};
+};
+
+// Smaller packages partition faster than their schedule loads.
+size_t const MIN_ELEMENTS{ 4096 };
+// Oldest schedules are dropped past this many.
+size_t const MAX_ENTRIES{ 64 };
+
+std::mutex s_mutex{};
+
+class Hasher {
+ public:
+  void add(uint64_t const a_value) { m_hash = (m_hash ^ a_value) * 0x100000001b3ULL; }
+  void add(std::string_view const a_string)
+  {
+    for (char const C : a_string) add(static_cast<uint64_t>(static_cast<uint8_t>(C)));
+    add(a_string.size());
+  }
+
+  uint64_t hash() const
+  {
+    // Folds high bits back in, FNV over whole words leaves them poorly mixed.
+    uint64_t hash{ m_hash };
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    return hash;
+  }
+
+ private:
+  uint64_t m_hash{ 0xcbf29ce484222325ULL };
+};
+
+fs::path directory()
+{
+  return fs::path{ Registry::get().userCachePath() } / "schedules";
+}
+
+fs::path path_for(uint64_t const a_key)
+{
+  char name[32]{};
+  std::snprintf(name, sizeof(name), "%016llx.schedule", static_cast<unsigned long long>(a_key));
+  return directory() / name;
+}
+
+bool load(fs::path const &a_path, uint64_t const a_key, size_t const a_elements, size_t const a_partitions,
+          Partitioning &a_result)
+{
+  std::error_code error{};
+  MappedFile const MAPPED{ a_path.string(), error };
+  if (error || MAPPED.size() < sizeof(Header)) return false;
+
+  Header header{};
+  std::memcpy(&header, MAPPED.data(), sizeof(Header));
+  if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION || header.key != a_key ||
+      header.elements != a_elements || header.partitions != a_partitions)
+    return false;
+
+  size_t const LOADS_SIZE{ a_partitions * sizeof(float) };
+  size_t const PARTITION_OF_SIZE{ a_elements * sizeof(uint32_t) };
+  if (MAPPED.size() != sizeof(Header) + LOADS_SIZE + PARTITION_OF_SIZE) return false;
+
+  a_result.loads.resize(a_partitions);
+  a_result.partitionOf.resize(a_elements);
+  std::memcpy(a_result.loads.data(), MAPPED.data() + sizeof(Header), LOADS_SIZE);
+  std::memcpy(a_result.partitionOf.data(), MAPPED.data() + sizeof(Header) + LOADS_SIZE, PARTITION_OF_SIZE);
+  a_result.cutSize = static_cast<size_t>(header.cutSize);
+  a_result.imbalance = header.imbalance;
+
+  // Any assignment dispatches correctly, a colliding key only costs balance. One
+  // out of range would not.
+  return std::all_of(std::begin(a_result.partitionOf), std::end(a_result.partitionOf),
+                     [a_partitions](uint32_t const a_partition) { return a_partition < a_partitions; });
+}
+
+void prune()
+{
+  std::vector<std::pair<decltype(fs::last_write_time(fs::path{})), fs::path>> entries{};
+  for (auto const &ENTRY : fs::directory_iterator{ directory() })
+    if (ENTRY.path().extension() == ".schedule") entries.emplace_back(fs::last_write_time(ENTRY.path()), ENTRY.path());
+
+  if (entries.size() <= MAX_ENTRIES) return;
+
+  std::sort(std::begin(entries), std::end(entries),
+            [](auto const &a_lhs, auto const &a_rhs) { return a_lhs.first < a_rhs.first; });
+  size_t const EXCESS{ entries.size() - MAX_ENTRIES };
+  for (size_t i = 0; i < EXCESS; ++i) fs::remove(entries[i].second);
+}
+
+void store(fs::path const &a_path, uint64_t const a_key, Partitioning const &a_result)
+{
+  Header header{};
+  std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+  header.version = VERSION;
+  header.partitions = static_cast<uint32_t>(a_result.loads.size());
+  header.key = a_key;
+  header.elements = a_result.partitionOf.size();
+  header.cutSize = a_result.cutSize;
+  header.imbalance = a_result.imbalance;
+
+  fs::create_directories(directory());
+
+  // Written aside and renamed, a reader never maps a partial schedule.
+  fs::path temp{ a_path };
+  temp += ".tmp";
+  {
+    std::ofstream file{ temp.string(), std::ios::binary | std::ios::trunc };
+    file.write(reinterpret_cast<char const *>(&header), sizeof(header));
+    file.write(reinterpret_cast<char const *>(a_result.loads.data()),
+               static_cast<std::streamsize>(a_result.loads.size() * sizeof(float)));
+    file.write(reinterpret_cast<char const *>(a_result.partitionOf.data()),
+               static_cast<std::streamsize>(a_result.partitionOf.size() * sizeof(uint32_t)));
+    if (!file.good()) {
+      file.close();
+      fs::remove(temp);
+      return;
+    }
+  }
+  fs::rename(temp, a_path);
+
+  prune();
+}
+
+} // namespace
+
+Partitioning partition(Package::Elements const &a_elements, Package::Connections const &a_connections,
+                       size_t const a_partitions)
+{
+  size_t const PARTITIONS{ std::max<size_t>(a_partitions, 1) };
+  if (a_elements.size() < MIN_ELEMENTS || PARTITIONS == 1)
+    return partition_elements(a_elements, a_connections, PARTITIONS);
+
+  uint64_t const KEY{ key(a_elements, a_connections, PARTITIONS) };
+
+  fs::path path{};
+  try {
+    std::lock_guard<std::mutex> lock{ s_mutex };
+    path = path_for(KEY);
+    Partitioning result{};
+    if (load(path, KEY, a_elements.size(), PARTITIONS, result)) {
+      log::debug("[schedule_cache]: Loaded {}", path.string());
+      return result;
+    }
+  } catch (std::exception const &a_exception) {
+    log::warn("[schedule_cache]: Can't load schedule: {}", a_exception.what());
+  }
+
+  auto result = partition_elements(a_elements, a_connections, PARTITIONS);
+  if (path.empty()) return result;
+
+  try {
+    std::lock_guard<std::mutex> lock{ s_mutex };
+    store(path, KEY, result);
+  } catch (std::exception const &a_exception) {
+    log::warn("[schedule_cache]: Can't store schedule: {}", a_exception.what());
+  }
+
+  return result;
+}
+
+bool lookup(Package::Elements const &a_elements, Package::Connections const &a_connections,
+            size_t const a_partitions, Partitioning &a_result)
+{
+  size_t const PARTITIONS{ std::max<size_t>(a_partitions, 1) };
+  if (a_elements.size() < MIN_ELEMENTS || PARTITIONS == 1) return false;
+
+  uint64_t const KEY{ key(a_elements, a_connections, PARTITIONS) };
+
+  try {
+    std::lock_guard<std::mutex> lock{ s_mutex };
+    Partitioning result{};
+    if (!load(path_for(KEY), KEY, a_elements.size(), PARTITIONS, result)) return false;
+    a_result = std::move(result);
+    return true;
+  } catch (std::exception const &a_exception) {
+    log::warn("[schedule_cache]: Can't load schedule: {}", a_exception.what());
+  }
+
+  return false;
+}
+
+uint64_t key(Package::Elements const &a_elements, Package::Connections const &a_connections,
+             size_t const a_partitions)
+{
+  Hasher hasher{};
+  hasher.add(VERSION);
+  hasher.add(version::STRING);
+  hasher.add(version::COMMIT_HASH);
+
+  // Plugins register in directory order, only the resulting set matters.
+  auto &registry = Registry::get();
+  std::vector<std::pair<string::hash_t, size_t>> types{};
+  size_t const TYPES{ registry.size() };
+  for (size_t i = 0; i < TYPES; ++i) {
+    auto const &INFO = registry.metaInfoAt(i);
+    types.emplace_back(INFO.hash, INFO.elementSize);
+  }
+  std::sort(std::begin(types), std::end(types));
+  for (auto const &TYPE : types) {
+    hasher.add(TYPE.first);
+    hasher.add(TYPE.second);
+  }
+
+  hasher.add(a_partitions);
+
+  // Everything partition_elements() reads: element types and socket counts drive
+  // the cost model, connections in order drive growth and refinement.
+  hasher.add(a_elements.size());
+  for (auto const ELEMENT : a_elements) {
+    if (!ELEMENT) {
+      hasher.add(uint64_t{});
+      continue;
+    }
+    hasher.add(ELEMENT->hash());
+    hasher.add((ELEMENT->inputs().size() << 8) | ELEMENT->outputs().size());
+  }
+
+  hasher.add(a_connections.size());
+  for (auto const &CONNECTION : a_connections) {
+    hasher.add(CONNECTION.from_id);
+    hasher.add(CONNECTION.to_id);
+    hasher.add((uint64_t{ CONNECTION.from_socket } << 8) | CONNECTION.to_socket);
+  }
+
+  return hasher.hash();
+}
+
+void clear()
+{
+  std::lock_guard<std::mutex> lock{ s_mutex };
+
+  try {
+    fs::remove_all(directory());
+  } catch (std::exception const &a_exception) {
+    log::warn("[schedule_cache]: Can't clear: {}", a_exception.what());
+  }
+}
+
+} // namespace spaghetti::schedule_cache
@@ -0,0 +1,53 @@
+// MIT License
+//
+// Copyright (c) 2017-2018 Artur Wyszyński, aljen at hitomi dot pl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+#ifndef SPAGHETTI_SCHEDULE_CACHE_H
+#define SPAGHETTI_SCHEDULE_CACHE_H
+
+#include <cstdint>
+
+#include "partitioner.h"
+
+namespace spaghetti::schedule_cache {
+
+// Dispatch partitioning of large packages, kept in Registry::userCachePath() so
+// reopening an unchanged design skips partition_elements(). Entries are keyed by
+// the package's elements and connections, the library version and the set of
+// registered element types.
+// Cache entries are written and pruned here, call it where a package is opened or
+// dispatch starts, not from the dispatch thread.
+Partitioning partition(Package::Elements const &a_elements, Package::Connections const &a_connections,
+                       size_t const a_partitions);
+
+// Only reads the cache, a miss leaves a_result untouched.
+bool lookup(Package::Elements const &a_elements, Package::Connections const &a_connections,
+            size_t const a_partitions, Partitioning &a_result);
+
+uint64_t key(Package::Elements const &a_elements, Package::Connections const &a_connections,
+             size_t const a_partitions);
+
+void clear();
+
+} // namespace spaghetti::schedule_cache
+
+#endif // SPAGHETTI_SCHEDULE_CACHE_H
@@ -0,0 +1,93 @@
+// MIT License
+//
+// Copyright (c) 2017-2018 Artur Wyszyński, aljen at hitomi dot pl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+#ifndef SPAGHETTI_SPSC_RING_H
+#define SPAGHETTI_SPSC_RING_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace spaghetti {
+
+// Bounded lock-free queue between exactly one producer and one consumer thread.
+// Capacity is rounded up to a power of two, push() fails instead of waiting when
+// it's full. Each side caches the other's index so it only touches the shared
+// cache line when the cached one runs out.
+template<typename T>
+class SpscRing final {
+ public:
+  explicit SpscRing(size_t const a_capacity)
+  {
+    size_t capacity{ 2 };
+    while (capacity < a_capacity) capacity <<= 1;
+    m_buffer.resize(capacity);
+    m_mask = capacity - 1;
+  }
+
+  SpscRing(SpscRing const &) = delete;
+  SpscRing &operator=(SpscRing const &) = delete;
+
+  size_t capacity() const { return m_buffer.size(); }
+
+  bool push(T const &a_value)
+  {
+    size_t const TAIL{ m_tail.load(std::memory_order_relaxed) };
+    if (TAIL - m_cachedHead == m_buffer.size()) {
+      m_cachedHead = m_head.load(std::memory_order_acquire);
+      if (TAIL - m_cachedHead == m_buffer.size()) return false;
+    }
+
+    m_buffer[TAIL & m_mask] = a_value;
+    m_tail.store(TAIL + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Moves up to a_count values to a_values, returns how many there were.
+  size_t pop(T *const a_values, size_t const a_count)
+  {
+    size_t const HEAD{ m_head.load(std::memory_order_relaxed) };
+    if (m_cachedTail == HEAD) {
+      m_cachedTail = m_tail.load(std::memory_order_acquire);
+      if (m_cachedTail == HEAD) return 0;
+    }
+
+    size_t const COUNT{ std::min(a_count, m_cachedTail - HEAD) };
+    for (size_t i = 0; i < COUNT; ++i) a_values[i] = m_buffer[(HEAD + i) & m_mask];
+    m_head.store(HEAD + COUNT, std::memory_order_release);
+    return COUNT;
+  }
+
+ private:
+  std::vector<T> m_buffer{};
+  size_t m_mask{};
+  alignas(64) std::atomic_size_t m_head{};
+  size_t m_cachedTail{};
+  alignas(64) std::atomic_size_t m_tail{};
+  size_t m_cachedHead{};
+};
+
+} // namespace spaghetti
+
+#endif // SPAGHETTI_SPSC_RING_H
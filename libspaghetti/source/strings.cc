@@ -0,0 +1,206 @@
+// MIT License
+//
+// Copyright (c) 2017-2018 Artur Wyszyński, aljen at hitomi dot pl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "spaghetti/strings.h"
+
+#include <atomic>
+#include <cassert>
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace spaghetti::string {
+
+namespace {
+
+// Entries never move, references handed out by lookup() stay valid as long as
+// their handle is held and handles can be compared instead of the text they
+// stand for. A dropped entry is emptied and its slot reused by the next string.
+struct Entry {
+  Entry() = default;
+  explicit Entry(std::string_view const a_text)
+    : text{ a_text }
+  {
+  }
+
+  std::string text{};
+  std::atomic<uint32_t> references{};
+};
+
+struct StringTable {
+  StringTable() { entries.emplace_back(); }
+
+  std::shared_mutex mutex{};
+  std::deque<Entry> entries{};
+  std::unordered_multimap<hash_t, handle_t> handles{};
+  std::vector<handle_t> free{};
+  // Released while a Hold was alive, dropped when the last one goes.
+  std::vector<handle_t> pending{};
+  size_t holds{};
+};
+
+StringTable &string_table()
+{
+  static StringTable s_table{};
+  return s_table;
+}
+
+// Called with the table locked exclusively.
+void drop(StringTable &a_table, handle_t const a_handle)
+{
+  auto &entry = a_table.entries[a_handle];
+  // Interned again since, or pending twice and gone already.
+  if (entry.references > 0 || entry.text.empty()) return;
+
+  auto const RANGE = a_table.handles.equal_range(hash(entry.text));
+  for (auto it = RANGE.first; it != RANGE.second; ++it) {
+    if (it->second != a_handle) continue;
+    a_table.handles.erase(it);
+    break;
+  }
+
+  std::string{}.swap(entry.text);
+  a_table.free.push_back(a_handle);
+}
+
+} // namespace
+
+handle_t intern(std::string_view const a_string)
+{
+  if (a_string.empty()) return 0;
+
+  auto &table = string_table();
+  hash_t const HASH{ hash(a_string) };
+
+  auto find = [&]() -> handle_t {
+    auto const RANGE = table.handles.equal_range(HASH);
+    for (auto it = RANGE.first; it != RANGE.second; ++it) {
+      auto &entry = table.entries[it->second];
+      if (entry.text != a_string) continue;
+      entry.references.fetch_add(1, std::memory_order_relaxed);
+      return it->second;
+    }
+    return 0;
+  };
+
+  {
+    std::shared_lock<std::shared_mutex> lock{ table.mutex };
+    if (handle_t const HANDLE{ find() }; HANDLE != 0) return HANDLE;
+  }
+
+  std::unique_lock<std::shared_mutex> lock{ table.mutex };
+  if (handle_t const HANDLE{ find() }; HANDLE != 0) return HANDLE;
+
+  handle_t handle{};
+  if (table.free.empty()) {
+    handle = static_cast<handle_t>(table.entries.size());
+    table.entries.emplace_back(a_string);
+  } else {
+    handle = table.free.back();
+    table.free.pop_back();
+    table.entries[handle].text = a_string;
+  }
+  table.entries[handle].references = 1;
+  table.handles.emplace(HASH, handle);
+
+  return handle;
+}
+
+void release(handle_t const a_handle)
+{
+  if (a_handle == 0) return;
+
+  auto &table = string_table();
+
+  {
+    std::shared_lock<std::shared_mutex> lock{ table.mutex };
+    auto &references = table.entries[a_handle].references;
+    uint32_t count{ references.load(std::memory_order_relaxed) };
+    while (count > 1)
+      if (references.compare_exchange_weak(count, count - 1, std::memory_order_relaxed)) return;
+  }
+
+  // The last reference goes under the exclusive lock, so intern() can't find
+  // the string halfway through being dropped.
+  std::unique_lock<std::shared_mutex> lock{ table.mutex };
+  auto &entry = table.entries[a_handle];
+  assert(entry.references > 0);
+  if (--entry.references > 0) return;
+
+  if (table.holds > 0)
+    table.pending.push_back(a_handle);
+  else
+    drop(table, a_handle);
+}
+
+std::string const &lookup(handle_t const a_handle)
+{
+  auto &table = string_table();
+  std::shared_lock<std::shared_mutex> lock{ table.mutex };
+  assert(a_handle < table.entries.size());
+  return table.entries[a_handle].text;
+}
+
+size_t interned()
+{
+  auto &table = string_table();
+  std::shared_lock<std::shared_mutex> lock{ table.mutex };
+  return table.entries.size() - table.free.size();
+}
+
+size_t memory_usage()
+{
+  auto &table = string_table();
+  std::shared_lock<std::shared_mutex> lock{ table.mutex };
+
+  size_t bytes{ table.entries.size() * sizeof(Entry) };
+  for (auto const &ENTRY : table.entries)
+    if (ENTRY.text.capacity() >= sizeof(std::string)) bytes += ENTRY.text.capacity() + 1;
+
+  // Node per handle plus the bucket array.
+  bytes += table.handles.size() * (sizeof(std::pair<hash_t const, handle_t>) + 2 * sizeof(void *));
+  bytes += table.handles.bucket_count() * sizeof(void *);
+  bytes += (table.free.capacity() + table.pending.capacity()) * sizeof(handle_t);
+
+  return bytes;
+}
+
+Hold::Hold()
+{
+  auto &table = string_table();
+  std::unique_lock<std::shared_mutex> lock{ table.mutex };
+  ++table.holds;
+}
+
+Hold::~Hold()
+{
+  auto &table = string_table();
+  std::unique_lock<std::shared_mutex> lock{ table.mutex };
+  if (--table.holds > 0) return;
+
+  for (handle_t const HANDLE : table.pending) drop(table, HANDLE);
+  table.pending.clear();
+}
+
+} // namespace spaghetti::string
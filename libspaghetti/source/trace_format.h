@@ -0,0 +1,123 @@
+// MIT License
+//
+// Copyright (c) 2017-2018 Artur Wyszyński, aljen at hitomi dot pl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+#ifndef SPAGHETTI_TRACE_FORMAT_H
+#define SPAGHETTI_TRACE_FORMAT_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace spaghetti::trace {
+
+// Layout of a .trace file, native endian:
+//
+//   Header | signals | chunk | chunk | ... | index
+//
+// Signals are a type byte and two length prefixed strings, scope and name.
+// Sections start 8 byte aligned. A chunk holds the changes of a stretch of time:
+//
+//   ChunkHeader | bits[signals] | tags[signals] | ListEntry[lists] | lists
+//
+// bits and tags are every signal's value when the chunk starts, so reading
+// one never needs an earlier chunk. Only signals that changed have a list,
+// sorted by signal. A list is a run of changes, each a varint of the time
+// since the previous one (or the chunk start) shifted left by two over a tag,
+// followed by the value for TAG_VALUE: a zigzag varint for ints, four raw bytes
+// for floats. The index, one IndexEntry per chunk, and the header fields
+// pointing at it are written last. A file without them is still read by walking
+// the chunks, a torn last chunk is ignored.
+
+constexpr char const MAGIC[8]{ 'S', 'P', 'A', 'G', 'T', 'R', 'C', '\0' };
+constexpr uint32_t VERSION{ 1 };
+constexpr uint32_t ENDIAN_MARK{ 0x01020304 };
+constexpr uint32_t CHUNK_MAGIC{ 0x4b4e4843 };
+
+enum Tag : uint8_t { TAG_FALSE, TAG_TRUE, TAG_VALUE, TAG_UNKNOWN };
+
+struct Header {
+  char magic[8]{};
+  uint32_t version{};
+  uint32_t endian{};
+  uint64_t timescale{};
+  uint64_t signals{};
+  uint64_t firstChunk{};
+  uint64_t index{};
+  uint64_t chunks{};
+  uint64_t endTime{};
+};
+
+struct ChunkHeader {
+  uint32_t magic{};
+  uint32_t lists{};
+  uint64_t size{};
+  uint64_t startTime{};
+  uint64_t endTime{};
+};
+
+struct ListEntry {
+  uint32_t signal{};
+  uint32_t changes{};
+  // From the start of the chunk.
+  uint64_t offset{};
+};
+
+struct IndexEntry {
+  uint64_t offset{};
+  uint64_t startTime{};
+  uint64_t endTime{};
+};
+
+inline void write_varint(uint8_t *&a_cursor, uint64_t a_value)
+{
+  while (a_value >= 0x80) {
+    *a_cursor++ = static_cast<uint8_t>(a_value | 0x80);
+    a_value >>= 7;
+  }
+  *a_cursor++ = static_cast<uint8_t>(a_value);
+}
+
+// False when the varint runs past a_end.
+inline bool read_varint(uint8_t const *&a_cursor, uint8_t const *const a_end, uint64_t &a_value)
+{
+  a_value = 0;
+  for (int shift = 0; shift < 64 && a_cursor < a_end; shift += 7) {
+    uint8_t const BYTE{ *a_cursor++ };
+    a_value |= static_cast<uint64_t>(BYTE & 0x7f) << shift;
+    if (!(BYTE & 0x80)) return true;
+  }
+  return false;
+}
+
+inline uint32_t zigzag(int32_t const a_value)
+{
+  return (static_cast<uint32_t>(a_value) << 1) ^ static_cast<uint32_t>(a_value >> 31);
+}
+
+inline int32_t unzigzag(uint32_t const a_value)
+{
+  return static_cast<int32_t>((a_value >> 1) ^ (~(a_value & 1) + 1));
+}
+
+} // namespace spaghetti::trace
+
+#endif // SPAGHETTI_TRACE_FORMAT_H
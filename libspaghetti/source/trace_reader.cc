@@ -0,0 +1,339 @@
+// MIT License
+//
+// Copyright (c) 2017-2018 Artur Wyszyński, aljen at hitomi dot pl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "spaghetti/trace_reader.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "mapped_file.h"
+#include "spaghetti/logger.h"
+#include "trace_format.h"
+
+namespace spaghetti {
+
+namespace {
+
+template<typename T>
+T load(uint8_t const *const a_data)
+{
+  T value{};
+  std::memcpy(&value, a_data, sizeof(T));
+  return value;
+}
+
+size_t aligned(size_t const a_offset)
+{
+  return (a_offset + 7) & ~size_t{ 7 };
+}
+
+} // namespace
+
+struct TraceReader::PIMPL {
+  // A chunk's keyframe and change list of one signal, checked against the file.
+  struct List {
+    uint8_t tag{ trace::TAG_UNKNOWN };
+    uint32_t bits{};
+    uint64_t startTime{};
+    uint32_t changes{};
+    uint8_t const *begin{};
+    uint8_t const *end{};
+  };
+
+  bool list(size_t const a_chunk, SignalId const a_signal, List &a_list) const;
+  Value value(SignalId const a_signal, uint8_t const a_tag, uint32_t const a_bits) const;
+  bool next(SignalId const a_signal, uint8_t const *&a_cursor, uint8_t const *const a_end, uint64_t &a_time,
+            uint8_t &a_tag, uint32_t &a_bits) const;
+
+  std::unique_ptr<MappedFile> file{};
+  trace::Header header{};
+  std::vector<Signal> signals{};
+  std::vector<trace::IndexEntry> index{};
+  bool complete{};
+};
+
+bool TraceReader::PIMPL::list(size_t const a_chunk, SignalId const a_signal, List &a_list) const
+{
+  uint64_t const OFFSET{ index[a_chunk].offset };
+  uint8_t const *const CHUNK{ file->data() + OFFSET };
+  auto const HEADER = load<trace::ChunkHeader>(CHUNK);
+
+  size_t const SIGNALS{ signals.size() };
+  size_t const DIRECTORY{ aligned(sizeof(trace::ChunkHeader) + SIGNALS * (sizeof(uint32_t) + sizeof(uint8_t))) };
+  if (HEADER.magic != trace::CHUNK_MAGIC || HEADER.size > file->size() - OFFSET || HEADER.size < DIRECTORY ||
+      HEADER.lists > (HEADER.size - DIRECTORY) / sizeof(trace::ListEntry))
+    return false;
+
+  a_list.bits = load<uint32_t>(CHUNK + sizeof(trace::ChunkHeader) + a_signal * sizeof(uint32_t));
+  a_list.tag = CHUNK[sizeof(trace::ChunkHeader) + SIGNALS * sizeof(uint32_t) + a_signal];
+  a_list.startTime = HEADER.startTime;
+  a_list.changes = 0;
+  a_list.begin = a_list.end = nullptr;
+
+  uint8_t const *const ENTRIES{ CHUNK + DIRECTORY };
+  size_t first{}, count{ HEADER.lists };
+  while (count > 0) {
+    size_t const STEP{ count / 2 };
+    if (load<uint32_t>(ENTRIES + (first + STEP) * sizeof(trace::ListEntry)) < a_signal) {
+      first += STEP + 1;
+      count -= STEP + 1;
+    } else
+      count = STEP;
+  }
+  if (first == HEADER.lists) return true;
+
+  auto const ENTRY = load<trace::ListEntry>(ENTRIES + first * sizeof(trace::ListEntry));
+  if (ENTRY.signal != a_signal) return true;
+  if (ENTRY.offset > HEADER.size) return false;
+
+  uint64_t const END{ first + 1 < HEADER.lists
+                        ? load<trace::ListEntry>(ENTRIES + (first + 1) * sizeof(trace::ListEntry)).offset
+                        : HEADER.size };
+  if (END < ENTRY.offset || END > HEADER.size) return false;
+
+  a_list.changes = ENTRY.changes;
+  a_list.begin = CHUNK + ENTRY.offset;
+  a_list.end = CHUNK + END;
+  return true;
+}
+
+TraceReader::Value TraceReader::PIMPL::value(SignalId const a_signal, uint8_t const a_tag, uint32_t const a_bits) const
+{
+  Value value{};
+  value.known = a_tag != trace::TAG_UNKNOWN;
+  if (!value.known) return value;
+
+  switch (signals[a_signal].type) {
+    case ValueType::eBool: value.boolean = a_tag == trace::TAG_TRUE; break;
+    case ValueType::eInt: value.integer = static_cast<int32_t>(a_bits); break;
+    case ValueType::eFloat: std::memcpy(&value.real, &a_bits, sizeof(value.real)); break;
+  }
+  return value;
+}
+
+bool TraceReader::PIMPL::next(SignalId const a_signal, uint8_t const *&a_cursor, uint8_t const *const a_end,
+                              uint64_t &a_time, uint8_t &a_tag, uint32_t &a_bits) const
+{
+  uint64_t encoded{};
+  if (a_cursor >= a_end || !trace::read_varint(a_cursor, a_end, encoded)) return false;
+
+  a_time += encoded >> 2;
+  a_tag = static_cast<uint8_t>(encoded & 3);
+  a_bits = 0;
+  if (a_tag != trace::TAG_VALUE) return true;
+
+  if (signals[a_signal].type == ValueType::eInt) {
+    uint64_t zigzagged{};
+    if (!trace::read_varint(a_cursor, a_end, zigzagged)) return false;
+    a_bits = static_cast<uint32_t>(trace::unzigzag(static_cast<uint32_t>(zigzagged)));
+    return true;
+  }
+
+  if (a_end - a_cursor < static_cast<ptrdiff_t>(sizeof(a_bits))) return false;
+  a_bits = load<uint32_t>(a_cursor);
+  a_cursor += sizeof(a_bits);
+  return true;
+}
+
+TraceReader::TraceReader()
+  : m_pimpl{ std::make_unique<PIMPL>() }
+{
+}
+
+TraceReader::~TraceReader() = default;
+
+bool TraceReader::open(std::string const &a_filename)
+{
+  close();
+
+  auto &pimpl = *m_pimpl;
+
+  std::error_code error{};
+  auto file = std::make_unique<MappedFile>(a_filename, error);
+  if (error) {
+    log::error("[trace]: Can't open {}: {}", a_filename, error.message());
+    return false;
+  }
+
+  uint8_t const *const DATA{ file->data() };
+  size_t const SIZE{ file->size() };
+
+  trace::Header header{};
+  if (SIZE >= sizeof(header)) header = load<trace::Header>(DATA);
+  if (SIZE < sizeof(header) || std::memcmp(header.magic, trace::MAGIC, sizeof(trace::MAGIC)) != 0 ||
+      header.version != trace::VERSION || header.endian != trace::ENDIAN_MARK || header.firstChunk > SIZE) {
+    log::error("[trace]: {} isn't a trace", a_filename);
+    return false;
+  }
+
+  std::vector<Signal> signals{};
+  uint8_t const *cursor{ DATA + sizeof(header) };
+  uint8_t const *const TABLE_END{ DATA + header.firstChunk };
+  for (uint64_t i = 0; i < header.signals; ++i) {
+    Signal signal{};
+    if (cursor >= TABLE_END || *cursor > static_cast<uint8_t>(ValueType::eFloat)) break;
+    signal.type = static_cast<ValueType>(*cursor++);
+    for (auto *const string : { &signal.scope, &signal.name }) {
+      if (TABLE_END - cursor < static_cast<ptrdiff_t>(sizeof(uint32_t))) break;
+      uint32_t const LENGTH{ load<uint32_t>(cursor) };
+      cursor += sizeof(uint32_t);
+      if (static_cast<uint64_t>(TABLE_END - cursor) < LENGTH) break;
+      string->assign(reinterpret_cast<char const *>(cursor), LENGTH);
+      cursor += LENGTH;
+    }
+    signals.push_back(std::move(signal));
+  }
+  if (signals.size() != header.signals || cursor > TABLE_END) {
+    log::error("[trace]: {} has a broken signal table", a_filename);
+    return false;
+  }
+
+  std::vector<trace::IndexEntry> index{};
+  bool const INDEXED{ header.index >= header.firstChunk && header.index <= SIZE &&
+                      header.chunks <= (SIZE - header.index) / sizeof(trace::IndexEntry) };
+  if (INDEXED) {
+    index.resize(header.chunks);
+    std::memcpy(index.data(), DATA + header.index, index.size() * sizeof(trace::IndexEntry));
+  } else {
+    // The recording didn't finish, whole chunks are still there.
+    for (uint64_t offset = header.firstChunk; SIZE - offset >= sizeof(trace::ChunkHeader);) {
+      auto const CHUNK = load<trace::ChunkHeader>(DATA + offset);
+      if (CHUNK.magic != trace::CHUNK_MAGIC || CHUNK.size < sizeof(trace::ChunkHeader) ||
+          CHUNK.size > SIZE - offset)
+        break;
+      index.push_back({ offset, CHUNK.startTime, CHUNK.endTime });
+      offset += CHUNK.size;
+    }
+    header.endTime = index.empty() ? 0 : index.back().endTime;
+    log::warn("[trace]: {} wasn't closed, read {} chunks", a_filename, index.size());
+  }
+
+  for (auto const &ENTRY : index) {
+    if (ENTRY.offset < header.firstChunk || ENTRY.offset > SIZE - sizeof(trace::ChunkHeader)) {
+      log::error("[trace]: {} has a broken index", a_filename);
+      return false;
+    }
+  }
+
+  pimpl.file = std::move(file);
+  pimpl.header = header;
+  pimpl.signals = std::move(signals);
+  pimpl.index = std::move(index);
+  pimpl.complete = INDEXED;
+  return true;
+}
+
+void TraceReader::close()
+{
+  *m_pimpl = PIMPL{};
+}
+
+bool TraceReader::isOpen() const
+{
+  return m_pimpl->file != nullptr;
+}
+
+bool TraceReader::isComplete() const
+{
+  return m_pimpl->complete;
+}
+
+std::vector<TraceReader::Signal> const &TraceReader::signals() const
+{
+  return m_pimpl->signals;
+}
+
+std::chrono::nanoseconds TraceReader::timescale() const
+{
+  return std::chrono::nanoseconds{ m_pimpl->header.timescale };
+}
+
+uint64_t TraceReader::endTime() const
+{
+  return m_pimpl->header.endTime;
+}
+
+size_t TraceReader::chunks() const
+{
+  return m_pimpl->index.size();
+}
+
+TraceReader::Value TraceReader::valueAt(SignalId const a_signal, uint64_t const a_time) const
+{
+  auto const &pimpl = *m_pimpl;
+  if (a_signal >= pimpl.signals.size()) return {};
+
+  auto const CHUNK = std::upper_bound(std::begin(pimpl.index), std::end(pimpl.index), a_time,
+                                      [](uint64_t const a_t, trace::IndexEntry const &a_entry) {
+                                        return a_t < a_entry.startTime;
+                                      });
+  if (CHUNK == std::begin(pimpl.index)) return {};
+
+  PIMPL::List list{};
+  if (!pimpl.list(static_cast<size_t>(CHUNK - std::begin(pimpl.index)) - 1, a_signal, list)) return {};
+
+  uint8_t tag{ list.tag };
+  uint32_t bits{ list.bits };
+  uint64_t time{ list.startTime };
+  uint8_t nextTag{};
+  uint32_t nextBits{};
+  uint8_t const *cursor{ list.begin };
+  for (uint32_t i = 0; i < list.changes && pimpl.next(a_signal, cursor, list.end, time, nextTag, nextBits); ++i) {
+    if (time > a_time) break;
+    tag = nextTag;
+    bits = nextBits;
+  }
+
+  return pimpl.value(a_signal, tag, bits);
+}
+
+std::vector<TraceReader::Change> TraceReader::changes(SignalId const a_signal, uint64_t const a_from,
+                                                     uint64_t const a_to) const
+{
+  auto const &pimpl = *m_pimpl;
+  std::vector<Change> changes{};
+  if (a_signal >= pimpl.signals.size() || a_from > a_to) return changes;
+
+  // The first chunk that ends at or after a_from, ends only grow.
+  auto const FIRST = std::lower_bound(std::begin(pimpl.index), std::end(pimpl.index), a_from,
+                                      [](trace::IndexEntry const &a_entry, uint64_t const a_t) {
+                                        return a_entry.endTime < a_t;
+                                      });
+
+  for (auto chunk = FIRST; chunk != std::end(pimpl.index) && chunk->startTime <= a_to; ++chunk) {
+    PIMPL::List list{};
+    if (!pimpl.list(static_cast<size_t>(chunk - std::begin(pimpl.index)), a_signal, list)) break;
+
+    uint64_t time{ list.startTime };
+    uint8_t tag{};
+    uint32_t bits{};
+    uint8_t const *cursor{ list.begin };
+    for (uint32_t i = 0; i < list.changes && pimpl.next(a_signal, cursor, list.end, time, tag, bits); ++i) {
+      if (time > a_to) break;
+      if (time >= a_from) changes.push_back({ time, pimpl.value(a_signal, tag, bits) });
+    }
+  }
+
+  return changes;
+}
+
+} // namespace spaghetti
@@ -0,0 +1,82 @@
+// MIT License
+//
+// Copyright (c) 2017-2018 Artur Wyszyński, aljen at hitomi dot pl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+#ifndef SPAGHETTI_TRACE_WRITER_H
+#define SPAGHETTI_TRACE_WRITER_H
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "spaghetti/value_store.h"
+
+namespace spaghetti {
+
+// One value change as the dispatch thread hands it to a trace writer. The kind
+// shares a word with the signal id, keeping changes at 16 bytes.
+struct TraceChange {
+  enum class Kind : uint32_t { eBool, eInt, eFloat, eUnknown };
+
+  static constexpr uint32_t const SIGNAL_BITS{ 30 };
+  static constexpr uint32_t const SIGNAL_MASK{ (1u << SIGNAL_BITS) - 1 };
+
+  TraceChange() = default;
+  TraceChange(uint64_t const a_time, uint32_t const a_signal, Kind const a_kind, uint32_t const a_bits)
+    : time{ a_time }
+    , signalAndKind{ a_signal | (static_cast<uint32_t>(a_kind) << SIGNAL_BITS) }
+    , bits{ a_bits }
+  {
+  }
+
+  uint32_t signal() const { return signalAndKind & SIGNAL_MASK; }
+  Kind kind() const { return static_cast<Kind>(signalAndKind >> SIGNAL_BITS); }
+
+  uint64_t time{};
+  uint32_t signalAndKind{};
+  // Raw bits of the value, a float's included.
+  uint32_t bits{};
+};
+
+struct TraceSignal {
+  // Nested scopes separated by dots.
+  std::string scope{};
+  std::string name{};
+  ValueType type{};
+};
+
+// File format a Recorder's writer thread produces, changes arrive in time order.
+class TraceWriter {
+ public:
+  virtual ~TraceWriter() = default;
+
+  virtual bool open(std::string const &a_filename, std::vector<TraceSignal> const &a_signals,
+                    std::chrono::nanoseconds const a_timescale) = 0;
+  virtual void write(TraceChange const *const a_changes, size_t const a_count) = 0;
+  // Size of the file so far, false if anything failed to write.
+  virtual bool close(uint64_t &a_bytes) = 0;
+};
+
+} // namespace spaghetti
+
+#endif // SPAGHETTI_TRACE_WRITER_H
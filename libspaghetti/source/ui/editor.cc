@@ -40,6 +40,7 @@
 #include <QPainterPath>
 #include <QPolygonF>
 #include <QPushButton>
+#include <QStatusBar>
 #include <QTableWidget>
 #include <QUrl>
 #include <cctype>
@@ -49,12 +50,19 @@
 
 #include "elements/logic/all.h"
 #include "spaghetti/node.h"
+#include "spaghetti/package.h"
+#include "spaghetti/package_format.h"
 #include "spaghetti/registry.h"
 #include "spaghetti/version.h"
 #include "ui/expander_widget.h"
 #include "ui/package_view.h"
 
 QString const PACKAGES_DIR{ "../packages" };
+QString const JSON_PACKAGE_FILTER{ "JSON package (*.package)" };
+QString const COMPRESSED_PACKAGE_FILTER{ "Compressed package (*.package.z)" };
+QString const BINARY_PACKAGE_FILTER{ "Binary package (*.package.bin)" };
+QString const PACKAGE_FILTERS{ "Packages (*.package *.package.z *.package.bin);;" + JSON_PACKAGE_FILTER + ";;" +
+                               COMPRESSED_PACKAGE_FILTER + ";;" + BINARY_PACKAGE_FILTER };
 
 namespace spaghetti {
 
@@ -78,6 +86,7 @@ Editor::Editor(QWidget *const a_parent)
 
   connect(m_ui->actionShowLibrary, &QAction::triggered, this, &Editor::showLibrary);
   connect(m_ui->actionShowProperties, &QAction::triggered, this, &Editor::showProperties);
+  connect(m_ui->actionMemoryUsage, &QAction::triggered, this, &Editor::showMemoryUsage);
 
   connect(m_ui->actionBuildCommit, &QAction::triggered, this, &Editor::buildCommit);
   connect(m_ui->actionRecentChanges, &QAction::triggered, this, &Editor::recentChanges);
@@ -219,6 +228,12 @@ void Editor::newPackage()
 
   connect(packageView, &PackageView::requestOpenFile,
           [this](QString const a_filename) { openPackageFile(a_filename); });
+  connect(packageView, &PackageView::saved, [this](QString const a_filename, bool const a_saved) {
+    if (a_saved)
+      statusBar()->showMessage(QString{ "Saved %1" }.arg(a_filename), 5000);
+    else
+      QMessageBox::warning(this, "Save failed", QString{ "Can't save %1, see the log for details." }.arg(a_filename));
+  });
 }
 
 void Editor::openPackage()
@@ -226,7 +241,7 @@ void Editor::openPackage()
   foreach (PackageView *temp, this->findChildren<PackageView *>())
     temp->setUpdatesEnabled(false);
 
-  QString const FILENAME{ QFileDialog::getOpenFileName(this, "Open .package", PACKAGES_DIR, "*.package") };
+  QString const FILENAME{ QFileDialog::getOpenFileName(this, "Open .package", PACKAGES_DIR, PACKAGE_FILTERS) };
 
   foreach (PackageView *temp, this->findChildren<PackageView *>())
     temp->setUpdatesEnabled(true);
@@ -291,13 +306,28 @@ void Editor::savePackageView(bool const a_saveAs)
     foreach (PackageView *temp, this->findChildren<PackageView *>())
       temp->setUpdatesEnabled(false);
 
-    QString filename{ QFileDialog::getSaveFileName(this, "Save .package", PACKAGES_DIR, "*.package") };
+    QString selectedFilter{ JSON_PACKAGE_FILTER };
+    QString const FILTERS{ JSON_PACKAGE_FILTER + ";;" + COMPRESSED_PACKAGE_FILTER + ";;" + BINARY_PACKAGE_FILTER };
+    QString filename{ QFileDialog::getSaveFileName(this, "Save .package", PACKAGES_DIR, FILTERS, &selectedFilter) };
 
     foreach (PackageView *temp, this->findChildren<PackageView *>())
       temp->setUpdatesEnabled(true);
 
     if (filename.isEmpty()) return;
-    if (!filename.endsWith(".package")) filename += ".package";
+
+    // Package::save() picks the format from the extension.
+    QString const BINARY_EXTENSION{ package_format::BINARY_EXTENSION };
+    QString const COMPRESSED_EXTENSION{ package_format::COMPRESSED_EXTENSION };
+    QString const JSON_EXTENSION{ package_format::JSON_EXTENSION };
+    if (!filename.endsWith(BINARY_EXTENSION) && !filename.endsWith(COMPRESSED_EXTENSION) &&
+        !filename.endsWith(JSON_EXTENSION)) {
+      if (selectedFilter == BINARY_PACKAGE_FILTER)
+        filename += BINARY_EXTENSION;
+      else if (selectedFilter == COMPRESSED_PACKAGE_FILTER)
+        filename += COMPRESSED_EXTENSION;
+      else
+        filename += JSON_EXTENSION;
+    }
 
     packageView->setFilename(filename);
     QDir const packagesDir{ PACKAGES_DIR };
@@ -330,6 +360,62 @@ void Editor::showProperties(bool a_checked)
   m_ui->properties->setVisible(a_checked);
 }
 
+void Editor::showMemoryUsage()
+{
+  auto const packageView = packageViewForIndex(m_packageViewIndex);
+  if (!packageView) return;
+
+  auto const USAGE = packageView->package()->memoryUsage();
+
+  size_t nodes{}, sockets{}, links{};
+  for (auto const item : packageView->scene()->items()) {
+    switch (item->type()) {
+      case NODE_TYPE: nodes++; break;
+      case SOCKET_TYPE: sockets++; break;
+      case LINK_TYPE: links++; break;
+    }
+  }
+  size_t const VIEW_BYTES{ nodes * sizeof(Node) + sockets * sizeof(SocketItem) + links * sizeof(LinkItem) };
+
+  auto const kib = [](size_t const a_bytes) { return QString::number(static_cast<double>(a_bytes) / 1024.0, 'f', 1); };
+
+  QString types{};
+  for (auto const &TYPE : USAGE.elements)
+    types += QString("%1: %2 × <b>%3 KiB</b><br>").arg(TYPE.type).arg(TYPE.count).arg(kib(TYPE.bytes));
+
+  QMessageBox::information(this, "Memory usage",
+                           QString("<b>Package</b><br>"
+                                   "Element arena: %1 KiB<br>"
+                                   "Spilled sockets: %2 KiB<br>"
+                                   "Editor data: %3 KiB<br>"
+                                   "Values: %4 KiB<br>"
+                                   "Connections: %5 KiB<br>"
+                                   "Dependencies: %6 KiB<br>"
+                                   "Names (shared): %7 KiB<br>"
+                                   "Total: <b>%8 KiB</b><br>"
+                                   "<br>"
+                                   "Last load JSON peak: %9 KiB<br>"
+                                   "<br>"
+                                   "<b>Scene</b><br>"
+                                   "%10 nodes, %11 sockets, %12 links: %13 KiB<br>"
+                                   "<br>"
+                                   "<b>Elements</b><br>%14")
+                               .arg(kib(USAGE.arenaBytes))
+                               .arg(kib(USAGE.socketBytes))
+                               .arg(kib(USAGE.editorBytes))
+                               .arg(kib(USAGE.valueBytes))
+                               .arg(kib(USAGE.connectionBytes))
+                               .arg(kib(USAGE.dependencyBytes))
+                               .arg(kib(USAGE.nameBytes))
+                               .arg(kib(USAGE.total()))
+                               .arg(kib(USAGE.lastLoadJsonBytes))
+                               .arg(nodes)
+                               .arg(sockets)
+                               .arg(links)
+                               .arg(kib(VIEW_BYTES))
+                               .arg(types));
+}
+
 void Editor::buildCommit()
 {
   QUrl const url{ QString("https://github.com/aljen/spaghetti/tree/%1").arg(version::COMMIT_HASH) };
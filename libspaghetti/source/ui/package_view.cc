@@ -22,6 +22,8 @@
 
 #include "ui/package_view.h"
 
+#include <cassert>
+
 #include <QDebug>
 #include <QDragEnterEvent>
 #include <QDragLeaveEvent>
@@ -41,6 +43,7 @@
 #include "spaghetti/node.h"
 #include "spaghetti/package.h"
 #include "spaghetti/registry.h"
+#include "spaghetti/socket_item.h"
 #include "ui/elements_list.h"
 #include "ui/link_item.h"
 
@@ -116,12 +119,28 @@ PackageView::PackageView(QTableWidget *const a_properties, Package *const a_pack
   connect(&m_timer, &QTimer::timeout, [this]() { m_scene->advance(); });
   m_timer.start();
 
+  // Edits since the last save go to the package's journal, a crash loses a few seconds at most.
+  m_autosaveTimer.setInterval(5000);
+  connect(&m_autosaveTimer, &QTimer::timeout, [this]() { m_package->autosave(); });
+  m_autosaveTimer.start();
+
+  m_package->setCompactionCallback([this](Package::IdRemap const &a_remap) { remapNodes(a_remap); });
+  // A save started before the last one finished was already put in place by it.
+  connect(this, &PackageView::saveWritten, this,
+          [this](quint64 const a_save) {
+            if (a_save == m_saves) finishSave();
+          },
+          Qt::QueuedConnection);
   m_package->startDispatchThread();
 }
 
 PackageView::~PackageView()
 {
   m_timer.stop();
+  m_autosaveTimer.stop();
+  // The saving thread calls back into this view.
+  m_package->finishSave();
+  m_package->setCompactionCallback({});
   if (m_standalone) {
     m_package->quitDispatchThread();
     delete m_package;
@@ -143,6 +162,9 @@ void PackageView::open()
   size_t const SIZE{ elements.size() };
   for (size_t i = 1; i < SIZE; ++i) {
     auto const element = elements[i];
+    // A replayed journal may have left holes.
+    if (!element) continue;
+
     auto const node = registry.createNode(element->hash());
     auto const nodeName = QString::fromStdString(registry.elementName(element->hash()));
     auto const nodeIcon = QString::fromStdString(registry.elementIcon(element->hash()));
@@ -173,7 +195,20 @@ void PackageView::open()
 
 void PackageView::save()
 {
-  m_package->save(m_filename.toStdString());
+  finishSave();
+
+  // Simulation and editing go on while the snapshot is written, the saving
+  // thread hands the rest back to this one.
+  quint64 const SAVE{ ++m_saves };
+  m_savingFilename = m_filename;
+  m_package->startSave(m_filename.toStdString(), false, [this, SAVE](bool const) { emit saveWritten(SAVE); });
+}
+
+void PackageView::finishSave()
+{
+  if (!m_package->isSaving()) return;
+
+  emit saved(m_savingFilename, m_package->finishSave());
 }
 
 void PackageView::dragEnterEvent(QDragEnterEvent *a_event)
@@ -420,4 +455,20 @@ void PackageView::updateGrid(qreal const a_scale)
   m_gridDensity = newDensity;
 }
 
+void PackageView::remapNodes(std::vector<size_t> const &a_remap)
+{
+  Nodes nodes{};
+  for (auto it = m_nodes.cbegin(); it != m_nodes.cend(); ++it) {
+    size_t const NEW_ID{ a_remap[it.key()] };
+    assert(NEW_ID != Package::INVALID_ID);
+
+    Node *const node{ it.value() };
+    for (auto &&socket : node->inputs()) socket->setElementId(NEW_ID);
+    for (auto &&socket : node->outputs()) socket->setElementId(NEW_ID);
+    nodes[NEW_ID] = node;
+  }
+
+  m_nodes = std::move(nodes);
+}
+
 } // namespace spaghetti
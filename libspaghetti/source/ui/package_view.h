@@ -28,6 +28,8 @@
 #include <QHash>
 #include <QTimer>
 
+#include <vector>
+
 class QTableWidget;
 
 namespace spaghetti {
@@ -46,6 +48,7 @@ class PackageView final : public QGraphicsView {
   ~PackageView() override;
 
   void open();
+  // Returns once a snapshot is taken, saved() reports how writing it went.
   void save();
 
   void dragEnterEvent(QDragEnterEvent *a_event) override;
@@ -85,9 +88,14 @@ class PackageView final : public QGraphicsView {
 
  signals:
   void requestOpenFile(QString const a_filename);
+  void saved(QString const a_filename, bool const a_saved);
+  // Emitted by the saving thread.
+  void saveWritten(quint64 const a_save);
 
  private:
+  void finishSave();
   void updateGrid(qreal const a_scale);
+  void remapNodes(std::vector<size_t> const &a_remap);
 
  private:
   QTableWidget *const m_properties{};
@@ -95,6 +103,7 @@ class PackageView final : public QGraphicsView {
   Nodes m_nodes{};
   QGraphicsScene *const m_scene{};
   QTimer m_timer{};
+  QTimer m_autosaveTimer{};
   Node *const m_inputs{};
   Node *const m_outputs{};
   Node *const m_packageNode{};
@@ -104,6 +113,8 @@ class PackageView final : public QGraphicsView {
   int32_t m_scheduledScalings{};
   enum class GridDensity { eLarge, eSmall } m_gridDensity{};
   QString m_filename{};
+  QString m_savingFilename{};
+  quint64 m_saves{};
   bool m_snapToGrid{};
   bool m_standalone{};
 };
@@ -0,0 +1,128 @@
+// MIT License
+//
+// Copyright (c) 2017-2018 Artur Wyszyński, aljen at hitomi dot pl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "spaghetti/value_store.h"
+
+namespace spaghetti {
+
+namespace {
+
+template<typename T>
+ValueStore::Index allocate_slot(std::vector<T> &a_values, std::vector<ValueStore::Index> &a_free)
+{
+  if (a_free.empty()) {
+    auto const INDEX = static_cast<ValueStore::Index>(a_values.size());
+    a_values.emplace_back();
+    return INDEX;
+  }
+
+  auto const INDEX = a_free.back();
+  a_free.pop_back();
+  a_values[INDEX] = T{};
+  return INDEX;
+}
+
+template<typename T>
+ValueStore::Index append_slots(std::vector<T> &a_values, std::vector<ValueStore::Index> &a_free,
+                               std::vector<T> &a_otherValues, std::vector<ValueStore::Index> &a_otherFree)
+{
+  auto const OFFSET = static_cast<ValueStore::Index>(a_values.size());
+  a_values.insert(std::end(a_values), std::begin(a_otherValues), std::end(a_otherValues));
+  for (auto const INDEX : a_otherFree) a_free.push_back(OFFSET + INDEX);
+  a_otherValues.clear();
+  a_otherFree.clear();
+  return OFFSET;
+}
+
+} // namespace
+
+ValueStore &ValueStore::detached()
+{
+  static thread_local ValueStore s_store{};
+  return s_store;
+}
+
+ValueStore::Index ValueStore::allocate(ValueType const a_type)
+{
+  std::lock_guard<std::mutex> lock{ m_mutex };
+
+  switch (a_type) {
+    case ValueType::eBool: return allocate_slot(m_bools, m_freeBools);
+    case ValueType::eInt: return allocate_slot(m_ints, m_freeInts);
+    case ValueType::eFloat: return allocate_slot(m_floats, m_freeFloats);
+  }
+
+  assert(false && "Wrong value type");
+  return 0;
+}
+
+void ValueStore::release(ValueType const a_type, Index const a_index)
+{
+  std::lock_guard<std::mutex> lock{ m_mutex };
+
+  switch (a_type) {
+    case ValueType::eBool: m_freeBools.push_back(a_index); break;
+    case ValueType::eInt: m_freeInts.push_back(a_index); break;
+    case ValueType::eFloat: m_freeFloats.push_back(a_index); break;
+  }
+}
+
+void ValueStore::reset(ValueType const a_type, Index const a_index)
+{
+  switch (a_type) {
+    case ValueType::eBool: m_bools[a_index] = false; break;
+    case ValueType::eInt: m_ints[a_index] = 0; break;
+    case ValueType::eFloat: m_floats[a_index] = 0.0f; break;
+  }
+}
+
+ValueStore::Offsets ValueStore::append(ValueStore &a_other)
+{
+  assert(&a_other != this);
+  std::scoped_lock lock{ m_mutex, a_other.m_mutex };
+
+  Offsets offsets{};
+  offsets.bools = append_slots(m_bools, m_freeBools, a_other.m_bools, a_other.m_freeBools);
+  offsets.ints = append_slots(m_ints, m_freeInts, a_other.m_ints, a_other.m_freeInts);
+  offsets.floats = append_slots(m_floats, m_freeFloats, a_other.m_floats, a_other.m_freeFloats);
+  return offsets;
+}
+
+size_t ValueStore::size(ValueType const a_type) const
+{
+  switch (a_type) {
+    case ValueType::eBool: return m_bools.size();
+    case ValueType::eInt: return m_ints.size();
+    case ValueType::eFloat: return m_floats.size();
+  }
+
+  return 0;
+}
+
+size_t ValueStore::memoryUsage() const
+{
+  return m_bools.capacity() * sizeof(uint8_t) + m_ints.capacity() * sizeof(int32_t) +
+         m_floats.capacity() * sizeof(float) +
+         (m_freeBools.capacity() + m_freeInts.capacity() + m_freeFloats.capacity()) * sizeof(Index);
+}
+
+} // namespace spaghetti
@@ -0,0 +1,183 @@
+// MIT License
+//
+// Copyright (c) 2017-2018 Artur Wyszyński, aljen at hitomi dot pl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "vcd_writer.h"
+
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+
+#include "spaghetti/version.h"
+
+namespace spaghetti {
+
+namespace {
+
+// Identifier codes are base 94 numbers in printable ASCII.
+std::string code_for(size_t a_index)
+{
+  std::string code{};
+  do {
+    code += static_cast<char>('!' + a_index % 94);
+    a_index /= 94;
+  } while (a_index > 0);
+  return code;
+}
+
+// Timescales are a power of ten of a nanosecond, Recorder rounds them.
+std::string timescale_of(std::chrono::nanoseconds const a_timescale)
+{
+  char const *const UNITS[]{ "ns", "us", "ms", "s" };
+
+  uint64_t value{ static_cast<uint64_t>(a_timescale.count()) };
+  size_t unit{};
+  while (unit < 3 && value >= 1000) {
+    value /= 1000;
+    unit++;
+  }
+  return std::to_string(value) + " " + UNITS[unit];
+}
+
+std::vector<std::string> split(std::string const &a_scope)
+{
+  std::vector<std::string> path{};
+  size_t begin{};
+  while (begin <= a_scope.size()) {
+    size_t end{ a_scope.find('.', begin) };
+    if (end == std::string::npos) end = a_scope.size();
+    if (end > begin) path.push_back(a_scope.substr(begin, end - begin));
+    begin = end + 1;
+  }
+  return path;
+}
+
+void append_binary(std::string &a_line, uint32_t const a_bits)
+{
+  int bit{ 31 };
+  while (bit > 0 && !(a_bits & (1u << bit))) bit--;
+  for (; bit >= 0; --bit) a_line += (a_bits & (1u << bit)) ? '1' : '0';
+}
+
+} // namespace
+
+bool VcdWriter::open(std::string const &a_filename, std::vector<TraceSignal> const &a_signals,
+                     std::chrono::nanoseconds const a_timescale)
+{
+  m_file.open(a_filename, std::ios::binary | std::ios::trunc);
+  if (!m_file.is_open()) return false;
+
+  std::time_t const NOW{ std::time(nullptr) };
+  char date[64]{};
+  std::strftime(date, sizeof(date), "%Y-%m-%d %H:%M:%S", std::localtime(&NOW));
+
+  m_file << "$date\n  " << date << "\n$end\n";
+  m_file << "$version\n  Spaghetti " << version::STRING << "\n$end\n";
+  m_file << "$timescale " << timescale_of(a_timescale) << " $end\n";
+
+  std::vector<std::string> scopes{};
+  size_t const SIZE{ a_signals.size() };
+  for (size_t i = 0; i < SIZE; ++i) {
+    auto const &SIGNAL = a_signals[i];
+
+    // Leaves what the scope path doesn't share with the previous one, enters the rest.
+    std::vector<std::string> const PATH{ split(SIGNAL.scope) };
+    size_t common{};
+    while (common < scopes.size() && common < PATH.size() && scopes[common] == PATH[common]) common++;
+    for (; scopes.size() > common; scopes.pop_back()) m_file << "$upscope $end\n";
+    for (; scopes.size() < PATH.size(); scopes.push_back(PATH[scopes.size()]))
+      m_file << "$scope module " << PATH[scopes.size()] << " $end\n";
+
+    m_codes.push_back(code_for(i));
+    m_types.push_back(SIGNAL.type);
+
+    switch (SIGNAL.type) {
+      case ValueType::eBool: m_file << "$var wire 1 "; break;
+      case ValueType::eInt: m_file << "$var integer 32 "; break;
+      case ValueType::eFloat: m_file << "$var real 32 "; break;
+    }
+    m_file << m_codes.back() << ' ' << SIGNAL.name << " $end\n";
+  }
+  for (; !scopes.empty(); scopes.pop_back()) m_file << "$upscope $end\n";
+
+  m_file << "$enddefinitions $end\n#0\n$dumpvars\n";
+  for (size_t i = 0; i < SIZE; ++i) {
+    if (m_types[i] == ValueType::eBool) m_file << 'x' << m_codes[i] << '\n';
+    if (m_types[i] == ValueType::eInt) m_file << "bx " << m_codes[i] << '\n';
+  }
+  m_file << "$end\n";
+
+  return m_file.good();
+}
+
+void VcdWriter::write(TraceChange const *const a_changes, size_t const a_count)
+{
+  m_line.clear();
+
+  for (size_t i = 0; i < a_count; ++i) {
+    auto const &CHANGE = a_changes[i];
+    uint32_t const SIGNAL{ CHANGE.signal() };
+
+    if (CHANGE.time != m_time) {
+      m_time = CHANGE.time;
+      m_line += '#';
+      m_line += std::to_string(m_time);
+      m_line += '\n';
+    }
+
+    switch (CHANGE.kind()) {
+      case TraceChange::Kind::eBool: m_line += CHANGE.bits ? '1' : '0'; break;
+      case TraceChange::Kind::eInt:
+        m_line += 'b';
+        append_binary(m_line, CHANGE.bits);
+        m_line += ' ';
+        break;
+      case TraceChange::Kind::eFloat: {
+        float value{};
+        std::memcpy(&value, &CHANGE.bits, sizeof(value));
+        char real[32]{};
+        std::snprintf(real, sizeof(real), "r%.9g ", static_cast<double>(value));
+        m_line += real;
+        break;
+      }
+      case TraceChange::Kind::eUnknown:
+        // Reals have no unknown value, they keep their last one.
+        if (m_types[SIGNAL] == ValueType::eFloat) continue;
+        m_line += m_types[SIGNAL] == ValueType::eBool ? "x" : "bx ";
+        break;
+    }
+    m_line += m_codes[SIGNAL];
+    m_line += '\n';
+  }
+
+  m_file.write(m_line.data(), static_cast<std::streamsize>(m_line.size()));
+}
+
+bool VcdWriter::close(uint64_t &a_bytes)
+{
+  m_file.flush();
+  a_bytes = static_cast<uint64_t>(m_file.tellp());
+  bool const GOOD{ m_file.good() };
+  m_file.close();
+  return GOOD;
+}
+
+} // namespace spaghetti
@@ -0,0 +1,52 @@
+// MIT License
+//
+// Copyright (c) 2017-2018 Artur Wyszyński, aljen at hitomi dot pl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+#ifndef SPAGHETTI_VCD_WRITER_H
+#define SPAGHETTI_VCD_WRITER_H
+
+#include <fstream>
+
+#include "trace_writer.h"
+
+namespace spaghetti {
+
+// IEEE 1364 value change dump. Bools are wires, ints 32 bit vectors and floats
+// reals, all signals start out unknown until their first change.
+class VcdWriter final : public TraceWriter {
+ public:
+  bool open(std::string const &a_filename, std::vector<TraceSignal> const &a_signals,
+            std::chrono::nanoseconds const a_timescale) override;
+  void write(TraceChange const *const a_changes, size_t const a_count) override;
+  bool close(uint64_t &a_bytes) override;
+
+ private:
+  std::ofstream m_file{};
+  std::vector<std::string> m_codes{};
+  std::vector<ValueType> m_types{};
+  std::string m_line{};
+  uint64_t m_time{};
+};
+
+} // namespace spaghetti
+
+#endif // SPAGHETTI_VCD_WRITER_H
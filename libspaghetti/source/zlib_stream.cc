@@ -0,0 +1,234 @@
+// MIT License
+//
+// Copyright (c) 2017-2018 Artur Wyszyński, aljen at hitomi dot pl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "zlib_stream.h"
+
+#include <algorithm>
+#include <climits>
+
+#include <zlib.h>
+
+#include "spaghetti/logger.h"
+
+namespace spaghetti {
+
+namespace {
+
+// A 32 KiB window, +16 writes a gzip wrapper, +32 reads gzip and zlib alike.
+constexpr int const GZIP_WINDOW_BITS{ 15 + 16 };
+constexpr int const AUTO_WINDOW_BITS{ 15 + 32 };
+constexpr int const MEMORY_LEVEL{ 8 };
+
+// zlib counts in uInt, larger buffers go through in slices.
+uInt slice(size_t const a_size)
+{
+  return static_cast<uInt>(std::min<size_t>(a_size, UINT_MAX));
+}
+
+} // namespace
+
+InflateBuffer::InflateBuffer(std::istream &a_source, size_t const a_bufferSize)
+  : m_source{ a_source }
+  , m_stream{ std::make_unique<z_stream_s>() }
+  , m_input(a_bufferSize)
+  , m_output(a_bufferSize)
+{
+  if (inflateInit2(m_stream.get(), AUTO_WINDOW_BITS) != Z_OK) {
+    log::error("Can't start inflating: {}", m_stream->msg ? m_stream->msg : "out of memory");
+    m_failed = m_end = true;
+  }
+
+  setg(m_output.data(), m_output.data(), m_output.data());
+}
+
+InflateBuffer::~InflateBuffer()
+{
+  inflateEnd(m_stream.get());
+}
+
+InflateBuffer::int_type InflateBuffer::underflow()
+{
+  if (gptr() < egptr()) return traits_type::to_int_type(*gptr());
+
+  size_t const SIZE{ fill(m_output.data(), m_output.size()) };
+  if (SIZE == 0) return traits_type::eof();
+
+  setg(m_output.data(), m_output.data(), m_output.data() + SIZE);
+  return traits_type::to_int_type(*gptr());
+}
+
+std::streamsize InflateBuffer::xsgetn(char_type *a_data, std::streamsize a_size)
+{
+  std::streamsize const BUFFERED{ std::min<std::streamsize>(a_size, egptr() - gptr()) };
+  std::copy_n(gptr(), BUFFERED, a_data);
+  gbump(static_cast<int>(BUFFERED));
+  if (BUFFERED == a_size) return a_size;
+
+  return BUFFERED + static_cast<std::streamsize>(fill(a_data + BUFFERED, static_cast<size_t>(a_size - BUFFERED)));
+}
+
+size_t InflateBuffer::fill(char *const a_data, size_t const a_size)
+{
+  z_stream_s &stream{ *m_stream };
+  size_t done{};
+
+  while (done < a_size && !m_end) {
+    if (stream.avail_in == 0) {
+      m_source.read(m_input.data(), static_cast<std::streamsize>(m_input.size()));
+      stream.next_in = reinterpret_cast<Bytef *>(m_input.data());
+      stream.avail_in = static_cast<uInt>(m_source.gcount());
+      if (stream.avail_in == 0) {
+        log::error("Compressed stream ends early");
+        m_failed = m_end = true;
+        break;
+      }
+    }
+
+    stream.next_out = reinterpret_cast<Bytef *>(a_data + done);
+    stream.avail_out = slice(a_size - done);
+    uInt const AVAILABLE{ stream.avail_out };
+
+    int const RESULT{ ::inflate(&stream, Z_NO_FLUSH) };
+    done += AVAILABLE - stream.avail_out;
+
+    if (RESULT == Z_STREAM_END) {
+      // gzip members may follow each other, as written by cat a.gz b.gz.
+      if (stream.avail_in == 0 && m_source.peek() == std::istream::traits_type::eof())
+        m_end = true;
+      else
+        inflateReset(&stream);
+    } else if (RESULT != Z_OK && RESULT != Z_BUF_ERROR) {
+      log::error("Can't inflate: {}", stream.msg ? stream.msg : "damaged stream");
+      m_failed = m_end = true;
+    }
+  }
+
+  return done;
+}
+
+DeflateBuffer::DeflateBuffer(std::ostream &a_target, int const a_level, size_t const a_bufferSize)
+  : m_target{ a_target }
+  , m_stream{ std::make_unique<z_stream_s>() }
+  , m_input(a_bufferSize)
+  , m_output(a_bufferSize)
+{
+  if (deflateInit2(m_stream.get(), a_level, Z_DEFLATED, GZIP_WINDOW_BITS, MEMORY_LEVEL, Z_DEFAULT_STRATEGY) != Z_OK) {
+    log::error("Can't start deflating: {}", m_stream->msg ? m_stream->msg : "bad level or out of memory");
+    m_failed = true;
+  }
+
+  setp(m_input.data(), m_input.data() + m_input.size());
+}
+
+DeflateBuffer::~DeflateBuffer()
+{
+  finish();
+  deflateEnd(m_stream.get());
+}
+
+bool DeflateBuffer::finish()
+{
+  if (m_finished) return !m_failed;
+  m_finished = true;
+
+  bool const DEFLATED{ drain(pbase(), static_cast<size_t>(pptr() - pbase()), Z_FINISH) };
+  setp(nullptr, nullptr);
+
+  return DEFLATED && m_target.flush();
+}
+
+DeflateBuffer::int_type DeflateBuffer::overflow(int_type a_c)
+{
+  if (m_finished || !drain(pbase(), static_cast<size_t>(pptr() - pbase()), Z_NO_FLUSH)) return traits_type::eof();
+  setp(m_input.data(), m_input.data() + m_input.size());
+
+  if (traits_type::eq_int_type(a_c, traits_type::eof())) return traits_type::not_eof(a_c);
+
+  *pptr() = traits_type::to_char_type(a_c);
+  pbump(1);
+  return a_c;
+}
+
+std::streamsize DeflateBuffer::xsputn(char_type const *a_data, std::streamsize a_size)
+{
+  if (m_finished) return 0;
+
+  if (a_size < epptr() - pptr()) {
+    std::copy_n(a_data, a_size, pptr());
+    pbump(static_cast<int>(a_size));
+    return a_size;
+  }
+
+  if (!drain(pbase(), static_cast<size_t>(pptr() - pbase()), Z_NO_FLUSH)) return 0;
+  setp(m_input.data(), m_input.data() + m_input.size());
+  if (!drain(a_data, static_cast<size_t>(a_size), Z_NO_FLUSH)) return 0;
+
+  return a_size;
+}
+
+int DeflateBuffer::sync()
+{
+  // Only hands buffered input to zlib, a sync flush per stream flush would cost ratio.
+  if (m_finished) return m_failed ? -1 : 0;
+  if (!drain(pbase(), static_cast<size_t>(pptr() - pbase()), Z_NO_FLUSH)) return -1;
+  setp(m_input.data(), m_input.data() + m_input.size());
+  return 0;
+}
+
+bool DeflateBuffer::drain(char const *const a_data, size_t const a_size, int const a_flush)
+{
+  if (m_failed) return false;
+
+  z_stream_s &stream{ *m_stream };
+  size_t done{};
+
+  do {
+    stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(a_data + done));
+    stream.avail_in = slice(a_size - done);
+    uInt const AVAILABLE{ stream.avail_in };
+    bool const LAST{ a_size - done == AVAILABLE };
+
+    do {
+      stream.next_out = reinterpret_cast<Bytef *>(m_output.data());
+      stream.avail_out = static_cast<uInt>(m_output.size());
+
+      if (::deflate(&stream, LAST ? a_flush : Z_NO_FLUSH) == Z_STREAM_ERROR) {
+        log::error("Can't deflate: {}", stream.msg ? stream.msg : "broken stream");
+        m_failed = true;
+        return false;
+      }
+
+      m_target.write(m_output.data(), static_cast<std::streamsize>(m_output.size() - stream.avail_out));
+      if (!m_target) {
+        log::error("Can't write compressed stream");
+        m_failed = true;
+        return false;
+      }
+    } while (stream.avail_out == 0);
+
+    done += AVAILABLE;
+  } while (done < a_size);
+
+  return true;
+}
+
+} // namespace spaghetti
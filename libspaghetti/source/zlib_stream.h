@@ -0,0 +1,104 @@
+// MIT License
+//
+// Copyright (c) 2017-2018 Artur Wyszyński, aljen at hitomi dot pl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+#ifndef SPAGHETTI_ZLIB_STREAM_H
+#define SPAGHETTI_ZLIB_STREAM_H
+
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <streambuf>
+#include <vector>
+
+struct z_stream_s;
+
+namespace spaghetti {
+
+// gzip streams layered over another stream, compressed packages go through the
+// same loader and writer as plain JSON with only a chunk of each side in memory.
+// Large reads and writes are (de)compressed straight to and from the caller's
+// buffer.
+class InflateBuffer final : public std::streambuf {
+ public:
+  static constexpr size_t const DEFAULT_BUFFER_SIZE{ 64 * 1024 };
+
+  explicit InflateBuffer(std::istream &a_source, size_t const a_bufferSize = DEFAULT_BUFFER_SIZE);
+  ~InflateBuffer() override;
+
+  InflateBuffer(InflateBuffer const &) = delete;
+  InflateBuffer &operator=(InflateBuffer const &) = delete;
+
+  // Damaged or truncated input reads as an early end, this tells the two apart.
+  bool failed() const { return m_failed; }
+
+ protected:
+  int_type underflow() override;
+  std::streamsize xsgetn(char_type *a_data, std::streamsize a_size) override;
+
+ private:
+  size_t fill(char *const a_data, size_t const a_size);
+
+ private:
+  std::istream &m_source;
+  std::unique_ptr<z_stream_s> m_stream;
+  std::vector<char> m_input;
+  std::vector<char> m_output;
+  bool m_end{};
+  bool m_failed{};
+};
+
+class DeflateBuffer final : public std::streambuf {
+ public:
+  static constexpr size_t const DEFAULT_BUFFER_SIZE{ 64 * 1024 };
+
+  explicit DeflateBuffer(std::ostream &a_target, int const a_level = -1,
+                         size_t const a_bufferSize = DEFAULT_BUFFER_SIZE);
+  ~DeflateBuffer() override;
+
+  DeflateBuffer(DeflateBuffer const &) = delete;
+  DeflateBuffer &operator=(DeflateBuffer const &) = delete;
+
+  // Writes the gzip trailer, the output isn't readable before. Called by the
+  // destructor if needed, but only this reports failures.
+  bool finish();
+
+ protected:
+  int_type overflow(int_type a_c) override;
+  std::streamsize xsputn(char_type const *a_data, std::streamsize a_size) override;
+  int sync() override;
+
+ private:
+  bool drain(char const *const a_data, size_t const a_size, int const a_flush);
+
+ private:
+  std::ostream &m_target;
+  std::unique_ptr<z_stream_s> m_stream;
+  std::vector<char> m_input;
+  std::vector<char> m_output;
+  bool m_finished{};
+  bool m_failed{};
+};
+
+} // namespace spaghetti
+
+#endif // SPAGHETTI_ZLIB_STREAM_H
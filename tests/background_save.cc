@@ -0,0 +1,98 @@
+// MIT License
+//
+// Copyright (c) 2017-2018 Artur Wyszyński, aljen at hitomi dot pl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <atomic>
+#include <fstream>
+#include <string>
+
+#include <spaghetti/package.h>
+
+#include "common.h"
+
+int main()
+{
+  using namespace spaghetti;
+  using spaghetti::tests::dump;
+
+  tests::register_elements();
+
+  std::string const FILENAME{ "background_save_test.package" };
+  std::string const JOURNAL{ FILENAME + ".journal" };
+
+  Package package{};
+  tests::build_sample(package);
+  package.startDispatchThread();
+
+  std::atomic_int calls{};
+  std::atomic_bool written{};
+  package.startSave(FILENAME, false, [&](bool const a_written) {
+    written = a_written;
+    calls++;
+  });
+  CHECK(package.isSaving());
+  Element::Json const SNAPSHOT = dump(package);
+
+  // Edits made while writing aren't in the file, they go to its journal.
+  Element *const gate{ package.add("gates/or") };
+  gate->setName("Added while saving");
+  package.connect(4, 0, gate->id(), 0);
+
+  CHECK(package.finishSave());
+  CHECK(!package.isSaving());
+  CHECK(!package.finishSave());
+  CHECK(calls == 1 && written);
+
+  {
+    std::ifstream file{ FILENAME, std::ios::binary };
+    CHECK(Element::Json::parse(file) == SNAPSHOT);
+  }
+  {
+    Package reopened{};
+    reopened.open(FILENAME);
+    CHECK(dump(reopened) == dump(package));
+  }
+
+  gate->iconify(true);
+  CHECK(package.autosave());
+  {
+    Package reopened{};
+    reopened.open(FILENAME);
+    CHECK(dump(reopened) == dump(package));
+  }
+
+  // Starting another save waits for the one still running.
+  std::string const BINARY{ "background_save_test.package.bin" };
+  package.startSave(FILENAME, true);
+  package.startSave(BINARY);
+  CHECK(package.finishSave());
+  {
+    Package reopened{};
+    reopened.open(BINARY);
+    CHECK(dump(reopened) == dump(package));
+  }
+
+  package.quitDispatchThread();
+
+  tests::remove_files({ FILENAME, JOURNAL, BINARY, BINARY + ".journal" });
+
+  return tests::failures() == 0 ? 0 : 1;
+}
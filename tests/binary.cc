@@ -0,0 +1,59 @@
+// MIT License
+//
+// Copyright (c) 2017-2018 Artur Wyszyński, aljen at hitomi dot pl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <cstdint>
+#include <vector>
+
+#include <spaghetti/package.h>
+#include <spaghetti/package_format.h>
+
+#include "common.h"
+
+int main()
+{
+  using namespace spaghetti;
+
+  tests::register_elements();
+
+  Package package{};
+  tests::build_sample(package);
+
+  CHECK(package_format::format_for("a.package.bin") == package_format::Format::eBinary);
+  CHECK(package_format::format_for("a.package") == package_format::Format::eJson);
+
+  tests::round_trip(package, "binary_test.package.bin");
+  tests::convert(package, "binary_convert.package", "binary_convert.package.bin");
+  tests::convert(package, "binary_convert.package.bin", "binary_convert_back.package");
+
+  Element::Json const JSON = tests::dump(package);
+  std::vector<uint8_t> binary{};
+  Element::Json fromBinary{};
+  CHECK(package_format::json_to_binary(JSON, binary));
+  CHECK(package_format::binary_to_json(binary.data(), binary.size(), fromBinary));
+  CHECK(fromBinary == JSON);
+
+  // A cut image is refused rather than read past its end.
+  Element::Json truncated{};
+  CHECK(!package_format::binary_to_json(binary.data(), binary.size() / 2, truncated));
+
+  return tests::failures() == 0 ? 0 : 1;
+}
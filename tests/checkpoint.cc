@@ -0,0 +1,111 @@
+// MIT License
+//
+// Copyright (c) 2017-2018 Artur Wyszyński, aljen at hitomi dot pl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <spaghetti/package.h>
+
+#include "common.h"
+
+namespace {
+
+using namespace spaghetti;
+using namespace std::chrono_literals;
+
+bool state(Element const &a_element)
+{
+  return a_element.value<bool>(a_element.outputs()[0]);
+}
+
+float real(Element const &a_element)
+{
+  return a_element.value<float>(a_element.outputs()[0]);
+}
+
+} // namespace
+
+int main()
+{
+  tests::register_elements();
+
+  Package package{};
+  tests::build_sample(package);
+  Element *const clock{ package.add("logic/clock") };
+  clock->setProperties({ { "duration", 1000.0 } });
+  Element *const a{ package.get(1) };
+  Element *const sum{ package.get(3) };
+  sum->calculate();
+  CHECK(real(*sum) == 3.75f);
+
+  clock->update(400ms);
+  auto const CHECKPOINT = package.checkpoint();
+  CHECK(!CHECKPOINT.empty());
+
+  // Socket values and the clock's time both go back.
+  clock->update(400ms);
+  a->setProperties({ { "value", 10.0f } });
+  sum->calculate();
+  CHECK(real(*sum) == 12.25f);
+
+  CHECK(package.restore(CHECKPOINT));
+  CHECK(real(*a) == 1.5f);
+  CHECK(real(*sum) == 3.75f);
+  bool const BEFORE{ state(*clock) };
+  clock->update(500ms);
+  CHECK(state(*clock) == BEFORE);
+  clock->update(200ms);
+  CHECK(state(*clock) != BEFORE);
+
+  // Through a file.
+  std::string const FILENAME{ "checkpoint_test.checkpoint" };
+  CHECK(package.restore(CHECKPOINT));
+  CHECK(package.saveCheckpoint(FILENAME));
+  clock->update(800ms);
+  a->setProperties({ { "value", -1.0f } });
+  CHECK(package.loadCheckpoint(FILENAME));
+  CHECK(real(*a) == 1.5f);
+  clock->update(500ms);
+  CHECK(state(*clock) == BEFORE);
+  tests::remove_files({ FILENAME });
+
+  // Another structure or a cut checkpoint is refused and changes nothing.
+  a->setProperties({ { "value", 4.0f } });
+  Package other{};
+  tests::build_sample(other);
+  CHECK(!other.restore(CHECKPOINT));
+  std::vector<uint8_t> const CUT(CHECKPOINT.begin(), CHECKPOINT.begin() + CHECKPOINT.size() / 2);
+  CHECK(!package.restore(CUT));
+  CHECK(real(*a) == 4.0f);
+
+  // Taken between ticks of a running package.
+  package.startDispatchThread();
+  std::this_thread::sleep_for(20ms);
+  CHECK(package.restore(package.checkpoint()));
+  package.quitDispatchThread();
+  CHECK(real(*package.get(3)) == 6.25f);
+
+  return tests::failures() == 0 ? 0 : 1;
+}
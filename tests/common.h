@@ -0,0 +1,147 @@
+// MIT License
+//
+// Copyright (c) 2017-2018 Artur Wyszyński, aljen at hitomi dot pl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+#ifndef SPAGHETTI_TESTS_COMMON_H
+#define SPAGHETTI_TESTS_COMMON_H
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <spaghetti/package.h>
+#include <spaghetti/package_format.h>
+#include <spaghetti/registry.h>
+
+namespace spaghetti::tests {
+
+inline int &failures()
+{
+  static int s_failures{};
+  return s_failures;
+}
+
+inline void check(bool const a_condition, char const *const a_what, char const *const a_file, int const a_line)
+{
+  if (a_condition) return;
+  std::fprintf(stderr, "%s:%d: check failed: %s\n", a_file, a_line, a_what);
+  ++failures();
+}
+
+#define CHECK(a_condition) spaghetti::tests::check((a_condition), #a_condition, __FILE__, __LINE__)
+
+inline void register_elements()
+{
+  static bool s_registered{};
+  if (s_registered) return;
+  Registry::get().registerInternalElements();
+  s_registered = true;
+}
+
+inline Element::Json dump(Package &a_package)
+{
+  Element::Json json{};
+  a_package.serialize(json);
+  return json;
+}
+
+template<typename T>
+void set_property(Element &a_element, char const *const a_key, T const a_value)
+{
+  Element::Json json{};
+  a_element.serialize(json);
+  json["properties"][a_key] = a_value;
+  a_element.deserialize(json);
+}
+
+// A few value sources feeding gates and math, a nested package and a hole
+// left by a removed element, enough for every part of the formats to show up.
+inline void build_sample(Package &a_package)
+{
+  Element *const a{ a_package.add("values/const_float") };
+  Element *const b{ a_package.add("values/const_float") };
+  Element *const sum{ a_package.add("math/add") };
+  Element *const on{ a_package.add("values/const_bool") };
+  Element *const removed{ a_package.add("gates/or") };
+  Element *const inverted{ a_package.add("gates/not") };
+  Element *const nested{ a_package.add("logic/package") };
+
+  set_property(*a, "value", 1.5f);
+  set_property(*b, "value", 2.25f);
+  set_property(*on, "value", true);
+
+  a->setName("A");
+  b->setName("B");
+  sum->setName("A + B");
+  sum->setPosition(120.0, -40.0);
+  inverted->iconify(true);
+  nested->setName("Nested");
+
+  a_package.connect(a->id(), 0, sum->id(), 0);
+  a_package.connect(b->id(), 0, sum->id(), 1);
+  a_package.connect(on->id(), 0, inverted->id(), 0);
+  a_package.connect(on->id(), 0, nested->id(), 0);
+
+  auto &inner = static_cast<Package &>(*nested);
+  inner.setPackageDescription("Inner package");
+  inner.setInputsPosition(-200.0, 0.0);
+  Element *const gate{ inner.add("gates/and") };
+  inner.connect(0, 0, gate->id(), 0);
+  inner.connect(0, 1, gate->id(), 1);
+  inner.connect(gate->id(), 0, 0, 0);
+
+  a_package.remove(removed);
+}
+
+inline void remove_files(std::vector<std::string> const &a_filenames)
+{
+  for (auto const &FILENAME : a_filenames) std::remove(FILENAME.c_str());
+}
+
+// Saves a_package as a_filename, opens it again and checks nothing was lost.
+inline void round_trip(Package &a_package, std::string const &a_filename, bool const a_compact = false)
+{
+  a_package.save(a_filename, a_compact);
+
+  Package loaded{};
+  loaded.open(a_filename);
+  CHECK(dump(loaded) == dump(a_package));
+
+  remove_files({ a_filename, a_filename + ".journal" });
+}
+
+// Saves a_package as a_from, converts that to a_to and opens the result.
+inline void convert(Package &a_package, std::string const &a_from, std::string const &a_to)
+{
+  a_package.save(a_from);
+  CHECK(package_format::convert(a_from, a_to));
+
+  Package loaded{};
+  loaded.open(a_to);
+  CHECK(dump(loaded) == dump(a_package));
+
+  remove_files({ a_from, a_from + ".journal", a_to, a_to + ".journal" });
+}
+
+} // namespace spaghetti::tests
+
+#endif // SPAGHETTI_TESTS_COMMON_H
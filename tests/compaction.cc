@@ -0,0 +1,127 @@
+// MIT License
+//
+// Copyright (c) 2017-2018 Artur Wyszyński, aljen at hitomi dot pl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <spaghetti/package.h>
+
+#include "common.h"
+
+namespace {
+
+using namespace spaghetti;
+
+constexpr size_t const ROWS{ 64 };
+
+float read(Package &a_package, Element const &a_element)
+{
+  a_package.pauseDispatchThread();
+  float const VALUE{ a_element.value<float>(a_element.outputs()[0]) };
+  a_package.resumeDispatchThread();
+  return VALUE;
+}
+
+} // namespace
+
+int main()
+{
+  using namespace std::chrono_literals;
+
+  tests::register_elements();
+
+  // One long chain of sums, every row of it preceded by an element removed later.
+  Package package{};
+  package.setCompactionThreshold(1.0f);
+
+  Element *const first{ package.add("values/const_float") };
+  tests::set_property(*first, "value", 1.0f);
+
+  Element *last{ first };
+  std::vector<size_t> removed{};
+  float expected{ 1.0f };
+  for (size_t row = 0; row < ROWS; ++row) {
+    removed.push_back(package.add("gates/not")->id());
+
+    Element *const constant{ package.add("values/const_float") };
+    tests::set_property(*constant, "value", static_cast<float>(row));
+    expected += static_cast<float>(row);
+
+    Element *const sum{ package.add("math/add") };
+    package.connect(last->id(), 0, sum->id(), 0);
+    package.connect(constant->id(), 0, sum->id(), 1);
+    last = sum;
+  }
+
+  package.setDispatchPartitions(4);
+  Package::TickOptions options{};
+  options.period = 100us;
+  options.highResolution = true;
+  package.setTickOptions(options);
+  package.startDispatchThread();
+  std::this_thread::sleep_for(200ms);
+  CHECK(read(package, *last) == expected);
+
+  // Compacting while dispatching, the running layout follows the new ids.
+  size_t const SIZE{ package.elements().size() };
+  size_t const LAST_ID{ last->id() };
+  for (size_t const ID : removed) package.remove(ID);
+  CHECK(package.fragmentation() > 0.0f);
+
+  Package::IdRemap remap{};
+  package.setCompactionCallback([&remap](Package::IdRemap const &a_remap) { remap = a_remap; });
+  package.compact();
+
+  CHECK(remap.size() == SIZE);
+  CHECK(package.elements().size() == SIZE - ROWS);
+  CHECK(package.fragmentation() == 0.0f);
+  for (size_t const ID : removed) CHECK(remap[ID] == Package::INVALID_ID);
+  CHECK(remap[LAST_ID] == last->id());
+  CHECK(package.get(last->id()) == last);
+  CHECK(last->inputs()[1].id == remap[LAST_ID - 1]);
+
+  std::this_thread::sleep_for(100ms);
+  CHECK(package.partitionStats().partitions == 4);
+  CHECK(read(package, *last) == expected);
+
+  // Edits after compaction reach the end of the chain.
+  first->setProperties({ { "value", 11.0f } });
+  expected += 10.0f;
+  Element *const constant{ package.add("values/const_float") };
+  tests::set_property(*constant, "value", 100.0f);
+  Element *const sum{ package.add("math/add") };
+  package.connect(last->id(), 0, sum->id(), 0);
+  package.connect(constant->id(), 0, sum->id(), 1);
+  std::this_thread::sleep_for(200ms);
+  CHECK(read(package, *sum) == expected + 100.0f);
+
+  package.quitDispatchThread();
+
+  // A fresh start partitions the compacted package from scratch.
+  package.startDispatchThread();
+  std::this_thread::sleep_for(100ms);
+  CHECK(read(package, *sum) == expected + 100.0f);
+  package.quitDispatchThread();
+
+  return tests::failures() == 0 ? 0 : 1;
+}
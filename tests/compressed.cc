@@ -0,0 +1,58 @@
+// MIT License
+//
+// Copyright (c) 2017-2018 Artur Wyszyński, aljen at hitomi dot pl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <fstream>
+#include <string>
+
+#include <spaghetti/package.h>
+#include <spaghetti/package_format.h>
+
+#include "common.h"
+
+int main()
+{
+  using namespace spaghetti;
+
+  tests::register_elements();
+
+  Package package{};
+  tests::build_sample(package);
+
+  CHECK(package_format::format_for("a.package.z") == package_format::Format::eCompressed);
+
+  tests::round_trip(package, "compressed_test.package.z");
+  tests::convert(package, "compressed_convert.package", "compressed_convert.package.z");
+  tests::convert(package, "compressed_convert.package.z", "compressed_convert.package.bin");
+
+  // Plain gzip, readable by anything else.
+  std::string const FILENAME{ "compressed_magic.package.z" };
+  package.save(FILENAME);
+  {
+    std::ifstream file{ FILENAME, std::ios::binary };
+    unsigned char magic[2]{};
+    file.read(reinterpret_cast<char *>(magic), sizeof(magic));
+    CHECK(file && magic[0] == 0x1f && magic[1] == 0x8b);
+  }
+  tests::remove_files({ FILENAME, FILENAME + ".journal" });
+
+  return tests::failures() == 0 ? 0 : 1;
+}
@@ -0,0 +1,140 @@
+// MIT License
+//
+// Copyright (c) 2017-2018 Artur Wyszyński, aljen at hitomi dot pl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <algorithm>
+#include <map>
+#include <random>
+#include <vector>
+
+#include <spaghetti/dependency_graph.h>
+#include <spaghetti/package.h>
+
+#include "common.h"
+
+namespace {
+
+using namespace spaghetti;
+
+using Reference = std::map<size_t, std::vector<size_t>>;
+
+bool matches(DependencyGraph const &a_graph, Reference const &a_reference, size_t const a_sources)
+{
+  size_t edges{};
+  for (size_t from = 0; from < a_sources; ++from) {
+    auto targets = a_graph.targets(from);
+    std::sort(std::begin(targets), std::end(targets));
+
+    auto const IT = a_reference.find(from);
+    auto expected = IT == std::end(a_reference) ? std::vector<size_t>{} : IT->second;
+    std::sort(std::begin(expected), std::end(expected));
+
+    if (targets != expected) return false;
+    edges += expected.size();
+  }
+
+  return edges == a_graph.edges();
+}
+
+// Random edits against a plain adjacency list, crossing the merge threshold
+// many times with both the overlay and tombstones in use.
+void random_edits()
+{
+  constexpr size_t const SOURCES{ 200 };
+
+  std::mt19937 random{ 1234 };
+  std::uniform_int_distribution<size_t> node{ 0, SOURCES - 1 };
+
+  DependencyGraph graph{};
+  Reference reference{};
+
+  for (size_t step = 0; step < 5000; ++step) {
+    size_t const FROM{ node(random) };
+    auto &targets = reference[FROM];
+
+    if (targets.empty() || random() % 3 != 0) {
+      size_t const TO{ node(random) };
+      graph.add(FROM, TO);
+      targets.push_back(TO);
+    } else {
+      auto const IT = std::begin(targets) + static_cast<std::ptrdiff_t>(random() % targets.size());
+      graph.remove(FROM, *IT);
+      targets.erase(IT);
+    }
+
+    if (step % 250 == 0) CHECK(matches(graph, reference, SOURCES));
+  }
+
+  CHECK(matches(graph, reference, SOURCES));
+
+  graph.merge();
+  CHECK(graph.overlay() == 0);
+  CHECK(matches(graph, reference, SOURCES));
+
+  // Removing what isn't there leaves the graph alone.
+  size_t const EDGES{ graph.edges() };
+  graph.remove(SOURCES + 10, 0);
+  graph.remove(0, SOURCES + 10);
+  CHECK(graph.edges() == EDGES);
+
+  graph.clear();
+  CHECK(graph.edges() == 0);
+  CHECK(graph.targets(0).empty());
+}
+
+// One edge per connection, parallel connections show up repeatedly.
+void package_edges()
+{
+  Package package{};
+  Element *const source{ package.add("values/const_bool") };
+  Element *const a{ package.add("gates/and") };
+  Element *const b{ package.add("gates/not") };
+
+  package.connect(source->id(), 0, a->id(), 0);
+  package.connect(source->id(), 0, a->id(), 1);
+  package.connect(source->id(), 0, b->id(), 0);
+
+  auto targets = package.dependencies().targets(source->id());
+  std::sort(std::begin(targets), std::end(targets));
+  CHECK((targets == std::vector<size_t>{ a->id(), a->id(), b->id() }));
+
+  package.disconnect(source->id(), 0, a->id(), 1);
+  targets = package.dependencies().targets(source->id());
+  std::sort(std::begin(targets), std::end(targets));
+  CHECK((targets == std::vector<size_t>{ a->id(), b->id() }));
+
+  size_t const B{ b->id() };
+  package.remove(b);
+  CHECK((package.dependencies().targets(source->id()) == std::vector<size_t>{ a->id() }));
+  CHECK(package.dependencies().targets(B).empty());
+}
+
+} // namespace
+
+int main()
+{
+  tests::register_elements();
+
+  random_edits();
+  package_edges();
+
+  return tests::failures() == 0 ? 0 : 1;
+}
@@ -0,0 +1,147 @@
+// MIT License
+//
+// Copyright (c) 2017-2018 Artur Wyszyński, aljen at hitomi dot pl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <spaghetti/package.h>
+
+#include "common.h"
+
+namespace {
+
+using namespace spaghetti;
+
+constexpr size_t const CHAINS{ 8 };
+constexpr size_t const CHAIN_LENGTH{ 32 };
+
+// Chains of additions over constants with a gate per stage, wide enough to be
+// split and deep enough for values to cross partitions several times.
+void build_chains(Package &a_package)
+{
+  for (size_t chain = 0; chain < CHAINS; ++chain) {
+    Element *previous{ a_package.add("values/const_float") };
+    tests::set_property(*previous, "value", static_cast<float>(chain) * 0.5f);
+
+    Element *previousGate{ a_package.add("values/const_bool") };
+    tests::set_property(*previousGate, "value", chain % 2 == 0);
+
+    for (size_t i = 0; i < CHAIN_LENGTH; ++i) {
+      Element *const constant{ a_package.add("values/const_float") };
+      tests::set_property(*constant, "value", static_cast<float>(i) * 0.25f);
+
+      Element *const sum{ a_package.add("math/add") };
+      a_package.connect(previous->id(), 0, sum->id(), 0);
+      a_package.connect(constant->id(), 0, sum->id(), 1);
+      previous = sum;
+
+      Element *const gate{ a_package.add("gates/not") };
+      a_package.connect(previousGate->id(), 0, gate->id(), 0);
+      previousGate = gate;
+    }
+  }
+
+  // Neighbouring chains feed each other, connections have to cross partitions.
+  auto const LAST_SUM = [](size_t const a_chain) { return 1 + a_chain * (2 + CHAIN_LENGTH * 3) + CHAIN_LENGTH * 3; };
+  for (size_t chain = 1; chain < CHAINS; ++chain) {
+    Element *const sum{ a_package.add("math/add") };
+    a_package.connect(LAST_SUM(chain - 1), 0, sum->id(), 0);
+    a_package.connect(LAST_SUM(chain), 0, sum->id(), 1);
+  }
+}
+
+// Adds to the last sum while dispatching, the layout is rebuilt between ticks.
+void extend(Package &a_package)
+{
+  size_t const LAST{ a_package.elements().size() - 1 };
+
+  Element *const constant{ a_package.add("values/const_float") };
+  tests::set_property(*constant, "value", 8.0f);
+
+  Element *const sum{ a_package.add("math/add") };
+  a_package.connect(constant->id(), 0, sum->id(), 0);
+  a_package.connect(LAST, 0, sum->id(), 1);
+}
+
+std::vector<float> snapshot(Package &a_package)
+{
+  std::vector<float> values{};
+
+  a_package.pauseDispatchThread();
+  for (auto const *const ELEMENT : a_package.elements()) {
+    if (!ELEMENT || ELEMENT == &a_package) continue;
+    for (auto const &OUTPUT : ELEMENT->outputs()) {
+      switch (OUTPUT.type) {
+        case ValueType::eBool: values.push_back(ELEMENT->value<bool>(OUTPUT) ? 1.0f : 0.0f); break;
+        case ValueType::eInt: values.push_back(static_cast<float>(ELEMENT->value<int32_t>(OUTPUT))); break;
+        case ValueType::eFloat: values.push_back(ELEMENT->value<float>(OUTPUT)); break;
+      }
+    }
+  }
+  a_package.resumeDispatchThread();
+
+  return values;
+}
+
+// Runs the chains until they settle, edits them while dispatching and lets
+// them settle again.
+std::vector<float> run(size_t const a_partitions)
+{
+  using namespace std::chrono_literals;
+
+  Package package{};
+  build_chains(package);
+
+  package.setDispatchPartitions(a_partitions);
+  Package::TickOptions options{};
+  options.period = 100us;
+  options.highResolution = true;
+  package.setTickOptions(options);
+  package.startDispatchThread();
+
+  std::this_thread::sleep_for(300ms);
+  CHECK(package.partitionStats().partitions == a_partitions);
+
+  extend(package);
+  std::this_thread::sleep_for(300ms);
+
+  auto values = snapshot(package);
+  package.quitDispatchThread();
+
+  return values;
+}
+
+} // namespace
+
+int main()
+{
+  tests::register_elements();
+
+  auto const SINGLE = run(1);
+  auto const PARTITIONED = run(4);
+
+  CHECK(!SINGLE.empty());
+  CHECK(SINGLE == PARTITIONED);
+
+  return tests::failures() == 0 ? 0 : 1;
+}
@@ -0,0 +1,114 @@
+// MIT License
+//
+// Copyright (c) 2017-2018 Artur Wyszyński, aljen at hitomi dot pl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <fstream>
+#include <string>
+
+#include <spaghetti/package.h>
+
+#include "common.h"
+
+namespace {
+
+using namespace spaghetti;
+using spaghetti::tests::dump;
+
+size_t file_size(std::string const &a_filename)
+{
+  std::ifstream file{ a_filename, std::ios::binary | std::ios::ate };
+  return file ? static_cast<size_t>(file.tellg()) : 0;
+}
+
+} // namespace
+
+int main()
+{
+  tests::register_elements();
+
+  std::string const FILENAME{ "journal_test.package" };
+  std::string const JOURNAL{ FILENAME + ".journal" };
+
+  Package package{};
+  tests::build_sample(package);
+  package.save(FILENAME);
+
+  Element *const gate{ package.add("gates/or") };
+  gate->setName("Late");
+  gate->setPosition(10.0, 20.0);
+  gate->setPosition(30.0, 40.0);
+  package.connect(4, 0, gate->id(), 0);
+  package.remove(1);
+
+  // A nested package filled by deserialize() is logged as what it added.
+  Package source{};
+  tests::build_sample(source);
+  Element::Json const SOURCE = dump(source);
+  auto &nested = static_cast<Package &>(*package.add("logic/package"));
+  nested.deserialize(SOURCE);
+
+  CHECK(package.autosave());
+  CHECK(file_size(JOURNAL) > 0);
+
+  {
+    Package reopened{};
+    reopened.open(FILENAME);
+    CHECK(dump(reopened) == dump(package));
+  }
+
+  // A property edit on a connected element replays without dropping its links.
+  Element *const b{ package.get(2) };
+  b->setProperties({ { "value", 7.5f } });
+  CHECK(package.autosave());
+
+  {
+    Package reopened{};
+    reopened.open(FILENAME);
+    CHECK(dump(reopened) == dump(package));
+    Element *const replayed{ reopened.get(2) };
+    CHECK(replayed->value<float>(replayed->outputs()[0]) == 7.5f);
+    CHECK(reopened.get(3)->inputs()[1].id == 2);
+  }
+
+  // Edits after the next autosave land after the ones already there.
+  package.disconnect(4, 0, gate->id(), 0);
+  gate->iconify(true);
+  CHECK(package.autosave());
+
+  {
+    Package reopened{};
+    reopened.open(FILENAME);
+    CHECK(dump(reopened) == dump(package));
+  }
+
+  // Saving folds the journal into the snapshot and starts it over.
+  package.save(FILENAME);
+
+  {
+    Package reopened{};
+    reopened.open(FILENAME);
+    CHECK(dump(reopened) == dump(package));
+  }
+
+  tests::remove_files({ FILENAME, JOURNAL });
+
+  return tests::failures() == 0 ? 0 : 1;
+}
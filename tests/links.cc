@@ -0,0 +1,199 @@
+// MIT License
+//
+// Copyright (c) 2017-2018 Artur Wyszyński, aljen at hitomi dot pl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <spaghetti/package.h>
+#include <spaghetti/recorder.h>
+#include <spaghetti/trace_reader.h>
+
+#include "common.h"
+
+namespace {
+
+using namespace spaghetti;
+
+constexpr size_t const CHAINS{ 4 };
+constexpr size_t const CHAIN_LENGTH{ 24 };
+
+bool has_connection(Package const &a_package, size_t const a_id)
+{
+  auto const &CONNECTIONS = a_package.connections();
+  return std::any_of(std::begin(CONNECTIONS), std::end(CONNECTIONS), [a_id](Package::Connection const &a_connection) {
+    return a_connection.from_id == a_id || a_connection.to_id == a_id;
+  });
+}
+
+void sockets()
+{
+  Package package{};
+  Element *const source{ package.add("values/const_float") };
+  Element *const first{ package.add("math/add") };
+  Element *const second{ package.add("math/add") };
+  tests::set_property(*source, "value", 3.5f);
+
+  // Fan-out reads the source's slot, nothing is copied.
+  package.connect(source->id(), 0, first->id(), 0);
+  package.connect(source->id(), 0, second->id(), 1);
+  auto const &OUTPUT = source->outputs()[0];
+  CHECK(first->inputs()[0].linked && first->inputs()[0].index == OUTPUT.index);
+  CHECK(second->inputs()[1].linked && second->inputs()[1].index == OUTPUT.index);
+
+  // Disconnecting hands the input a slot of its own, the other reader keeps the source's.
+  package.disconnect(source->id(), 0, first->id(), 0);
+  CHECK(!first->inputs()[0].linked && first->inputs()[0].index != OUTPUT.index);
+  CHECK(second->inputs()[1].linked && second->inputs()[1].index == OUTPUT.index);
+
+  // Dropping sockets disconnects them.
+  Element *const gate{ package.add("gates/and") };
+  Element *const on{ package.add("values/const_bool") };
+  gate->addInput(ValueType::eBool, "#3", Element::IOSocket::eCanHoldBool);
+  package.connect(on->id(), 0, gate->id(), 2);
+  gate->removeInput();
+  CHECK(!has_connection(package, gate->id()));
+  package.connect(on->id(), 0, gate->id(), 0);
+  gate->clearInputs();
+  CHECK(!has_connection(package, gate->id()));
+  CHECK(package.dependencies().targets(on->id()).empty());
+
+  // Removing an element drops its connections both ways.
+  package.connect(source->id(), 0, first->id(), 0);
+  package.connect(first->id(), 0, second->id(), 0);
+  package.remove(first);
+  CHECK(!has_connection(package, first->id()));
+  CHECK(!second->inputs()[0].linked);
+  CHECK(second->inputs()[1].linked && second->inputs()[1].index == OUTPUT.index);
+  package.remove(source);
+  CHECK(package.connections().empty());
+  CHECK(!second->inputs()[1].linked);
+  CHECK(package.dependencies().targets(source->id()).empty());
+}
+
+// Clearing what a nested package's input feeds leaves the link into that input alone.
+void package_boundary()
+{
+  Package package{};
+  Element *const on{ package.add("values/const_bool") };
+  auto &nested = static_cast<Package &>(*package.add("logic/package"));
+  package.connect(on->id(), 0, nested.id(), 0);
+
+  Element *const gate{ nested.add("gates/and") };
+  nested.connect(0, 0, gate->id(), 0);
+  gate->clearInputs();
+  CHECK(nested.connections().empty());
+  CHECK(nested.inputs()[0].linked && nested.inputs()[0].index == on->outputs()[0].index);
+  CHECK(package.connections().size() == 1);
+}
+
+// Chains of additions over constants, the last sum of each is recorded.
+std::vector<Element *> build_chains(Package &a_package, std::vector<Element *> &a_firsts)
+{
+  std::vector<Element *> lasts{};
+  for (size_t chain = 0; chain < CHAINS; ++chain) {
+    Element *previous{ a_package.add("values/const_float") };
+    tests::set_property(*previous, "value", static_cast<float>(chain));
+    a_firsts.push_back(previous);
+
+    for (size_t i = 0; i < CHAIN_LENGTH; ++i) {
+      Element *const constant{ a_package.add("values/const_float") };
+      tests::set_property(*constant, "value", 0.5f);
+
+      Element *const sum{ a_package.add("math/add") };
+      a_package.connect(previous->id(), 0, sum->id(), 0);
+      a_package.connect(constant->id(), 0, sum->id(), 1);
+      previous = sum;
+    }
+    lasts.push_back(previous);
+  }
+  return lasts;
+}
+
+// What each last sum went through while the first constants changed twice,
+// without the times.
+std::vector<std::vector<float>> trace(size_t const a_partitions)
+{
+  using namespace std::chrono_literals;
+
+  std::string const FILENAME{ "links_test_" + std::to_string(a_partitions) + ".trace" };
+
+  Package package{};
+  std::vector<Element *> firsts{};
+  auto const LASTS = build_chains(package, firsts);
+
+  Recorder recorder{ package };
+  for (auto *const last : LASTS) recorder.addSignal(*last, 0);
+
+  package.setDispatchPartitions(a_partitions);
+  Package::TickOptions options{};
+  options.period = 100us;
+  options.highResolution = true;
+  package.setTickOptions(options);
+  package.startDispatchThread();
+  std::this_thread::sleep_for(200ms);
+
+  CHECK(recorder.start(FILENAME));
+  for (float const VALUE : { 10.0f, -4.0f }) {
+    std::this_thread::sleep_for(50ms);
+    package.pauseDispatchThread();
+    for (auto *const first : firsts) first->setProperties({ { "value", VALUE } });
+    package.resumeDispatchThread();
+  }
+  std::this_thread::sleep_for(100ms);
+  CHECK(recorder.stop());
+  package.quitDispatchThread();
+
+  std::vector<std::vector<float>> values{};
+  TraceReader reader{};
+  CHECK(reader.open(FILENAME));
+  for (TraceReader::SignalId signal = 0; signal < LASTS.size(); ++signal) {
+    values.emplace_back();
+    for (auto const &CHANGE : reader.changes(signal, 0, reader.endTime())) values.back().push_back(CHANGE.value.real);
+  }
+  reader.close();
+
+  tests::remove_files({ FILENAME });
+
+  return values;
+}
+
+} // namespace
+
+int main()
+{
+  tests::register_elements();
+
+  sockets();
+  package_boundary();
+
+  auto const SINGLE = trace(1);
+  auto const PARTITIONED = trace(4);
+
+  CHECK(SINGLE.size() == CHAINS);
+  CHECK(SINGLE.front().size() == 3);
+  CHECK(SINGLE == PARTITIONED);
+
+  return tests::failures() == 0 ? 0 : 1;
+}
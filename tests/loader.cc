@@ -0,0 +1,59 @@
+// MIT License
+//
+// Copyright (c) 2017-2018 Artur Wyszyński, aljen at hitomi dot pl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <fstream>
+#include <string>
+
+#include <spaghetti/package.h>
+
+#include "common.h"
+
+int main()
+{
+  using namespace spaghetti;
+
+  tests::register_elements();
+
+  Package package{};
+  tests::build_sample(package);
+  package.get(1)->setName("Quote \" back\\slash \xc3\xbc\ttab");
+
+  tests::round_trip(package, "loader_test.package");
+  tests::round_trip(package, "loader_test_compact.package", true);
+
+  // Groups in an order the streaming path doesn't expect fall back to the DOM.
+  Element::Json const JSON = tests::dump(package);
+  std::string const FILENAME{ "loader_test_reordered.package" };
+  {
+    std::ofstream file{ FILENAME, std::ios::binary };
+    file << "{ \"package\": " << JSON["package"].dump() << ", \"node\": " << JSON["node"].dump()
+         << ", \"element\": " << JSON["element"].dump() << " }";
+  }
+
+  Package reordered{};
+  reordered.open(FILENAME);
+  CHECK(tests::dump(reordered) == JSON);
+
+  tests::remove_files({ FILENAME, FILENAME + ".journal" });
+
+  return tests::failures() == 0 ? 0 : 1;
+}
@@ -0,0 +1,95 @@
+// MIT License
+//
+// Copyright (c) 2017-2018 Artur Wyszyński, aljen at hitomi dot pl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <algorithm>
+
+#include <spaghetti/package.h>
+#include <spaghetti/registry.h>
+
+#include "common.h"
+
+namespace {
+
+using namespace spaghetti;
+
+Package::MemoryUsage::ElementType find_type(Package::MemoryUsage const &a_usage, char const *const a_type)
+{
+  string::hash_t const HASH{ string::hash(a_type) };
+  auto const IT = std::find_if(std::begin(a_usage.elements), std::end(a_usage.elements),
+                               [HASH](auto const &a_entry) { return a_entry.hash == HASH; });
+  return IT == std::end(a_usage.elements) ? Package::MemoryUsage::ElementType{} : *IT;
+}
+
+} // namespace
+
+int main()
+{
+  tests::register_elements();
+
+  Package package{};
+  for (int i = 0; i < 4; ++i) package.add("values/const_float");
+  Element *const sum{ package.add("math/add") };
+  package.add("math/add");
+  package.connect(1, 0, sum->id(), 0);
+  package.connect(2, 0, sum->id(), 1);
+
+  // Wider than the inline buffer, its inputs live on the heap.
+  Element *const wide{ package.add("gates/and") };
+  while (wide->inputs().size() <= Element::INLINE_INPUTS)
+    wide->addInput(ValueType::eBool, "#", Element::IOSocket::eCanHoldBool);
+
+  auto &nested = static_cast<Package &>(*package.add("logic/package"));
+  nested.add("gates/and");
+  nested.add("gates/not");
+
+  auto const USAGE = package.memoryUsage();
+
+  CHECK(find_type(USAGE, "values/const_float").count == 4);
+  CHECK(find_type(USAGE, "math/add").count == 2);
+  CHECK(find_type(USAGE, "logic/package").count == 1);
+  // Nested packages are walked, ordinary elements aren't taken for packages.
+  CHECK(find_type(USAGE, "gates/and").count == 2);
+  CHECK(find_type(USAGE, "gates/not").count == 1);
+
+  auto const &REGISTRY = Registry::get();
+  for (auto const &TYPE : USAGE.elements)
+    CHECK(TYPE.bytes >= TYPE.count * REGISTRY.metaInfoFor(TYPE.hash).elementSize);
+
+  CHECK(std::is_sorted(std::begin(USAGE.elements), std::end(USAGE.elements),
+                       [](auto const &a_lhs, auto const &a_rhs) { return a_lhs.bytes > a_rhs.bytes; }));
+
+  CHECK(USAGE.socketBytes >= wide->inputs().size() * sizeof(Element::IOSocket));
+  CHECK(USAGE.arenaBytes > 0);
+  CHECK(USAGE.valueBytes > 0);
+  CHECK(USAGE.connectionBytes >= package.connections().size() * sizeof(Package::Connection));
+  CHECK(USAGE.total() == USAGE.arenaBytes + USAGE.socketBytes + USAGE.editorBytes + USAGE.valueBytes +
+                             USAGE.connectionBytes + USAGE.dependencyBytes + USAGE.nameBytes);
+
+  // Elements of a nested package add to its parent's footprint.
+  auto const BEFORE = package.memoryUsage();
+  for (int i = 0; i < 16; ++i) nested.add("math/add");
+  auto const AFTER = package.memoryUsage();
+  CHECK(find_type(AFTER, "math/add").count == 18);
+  CHECK(AFTER.total() > BEFORE.total());
+
+  return tests::failures() == 0 ? 0 : 1;
+}
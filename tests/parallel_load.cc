@@ -0,0 +1,105 @@
+// MIT License
+//
+// Copyright (c) 2017-2018 Artur Wyszyński, aljen at hitomi dot pl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <algorithm>
+#include <fstream>
+#include <string>
+
+#include <spaghetti/package.h>
+
+#include "common.h"
+
+namespace {
+
+using namespace spaghetti;
+
+// Past the size a load is spread over threads at.
+constexpr size_t const PAIRS{ 3000 };
+
+size_t count_elements(Package const &a_package)
+{
+  auto const &ELEMENTS = a_package.elements();
+  return static_cast<size_t>(std::count_if(std::begin(ELEMENTS) + 1, std::end(ELEMENTS),
+                                           [](Element const *const a_element) { return a_element != nullptr; }));
+}
+
+} // namespace
+
+int main()
+{
+  tests::register_elements();
+
+  Package package{};
+  Element *previous{ package.add("values/const_float") };
+  for (size_t i = 0; i < PAIRS; ++i) {
+    Element *const constant{ package.add("values/const_float") };
+    tests::set_property(*constant, "value", static_cast<float>(i));
+    constant->setName("Constant " + std::to_string(i));
+
+    Element *const sum{ package.add("math/add") };
+    package.connect(previous->id(), 0, sum->id(), 0);
+    package.connect(constant->id(), 0, sum->id(), 1);
+    previous = sum;
+  }
+  Package source{};
+  tests::build_sample(source);
+  package.add("logic/package")->deserialize(tests::dump(source));
+
+  tests::round_trip(package, "parallel_load_test.package");
+  tests::round_trip(package, "parallel_load_test.package.bin");
+
+  // An element of a type nobody registered is left out along with its connections.
+  Element::Json json = tests::dump(package);
+  auto &elements = json["package"]["elements"];
+  size_t const UNKNOWN_ID{ elements[2]["element"]["id"].get<size_t>() };
+  elements[2]["element"]["type"] = "missing/plugin_element";
+
+  std::string const FILENAME{ "parallel_load_unknown.package" };
+  {
+    std::ofstream file{ FILENAME, std::ios::binary };
+    file << json.dump();
+  }
+
+  size_t const ELEMENTS{ count_elements(package) };
+  size_t const CONNECTIONS{ package.connections().size() };
+  size_t const UNKNOWN_CONNECTIONS{ static_cast<size_t>(
+      std::count_if(std::begin(package.connections()), std::end(package.connections()),
+                    [UNKNOWN_ID](Package::Connection const &a_connection) {
+                      return a_connection.from_id == UNKNOWN_ID || a_connection.to_id == UNKNOWN_ID;
+                    })) };
+  CHECK(UNKNOWN_CONNECTIONS > 0);
+
+  Package streamed{};
+  streamed.open(FILENAME);
+  CHECK(count_elements(streamed) == ELEMENTS - 1);
+  CHECK(streamed.connections().size() == CONNECTIONS - UNKNOWN_CONNECTIONS);
+
+  Package parsed{};
+  parsed.deserialize(json);
+  CHECK(count_elements(parsed) == ELEMENTS - 1);
+  CHECK(parsed.connections().size() == CONNECTIONS - UNKNOWN_CONNECTIONS);
+  CHECK(tests::dump(parsed) == tests::dump(streamed));
+
+  tests::remove_files({ FILENAME, FILENAME + ".journal" });
+
+  return tests::failures() == 0 ? 0 : 1;
+}
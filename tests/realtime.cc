@@ -0,0 +1,110 @@
+// MIT License
+//
+// Copyright (c) 2017-2018 Artur Wyszyński, aljen at hitomi dot pl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <chrono>
+#include <thread>
+
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+#include <spaghetti/package.h>
+
+#include "common.h"
+
+namespace {
+
+using namespace spaghetti;
+
+// Pinning only works when the process may run on every cpu it asks for.
+bool can_pin()
+{
+#if defined(__linux__)
+  cpu_set_t set{};
+  if (sched_getaffinity(0, sizeof(set), &set) != 0) return false;
+  return static_cast<unsigned>(CPU_COUNT(&set)) == std::thread::hardware_concurrency();
+#else
+  return false;
+#endif
+}
+
+float read(Package &a_package, Element const &a_element)
+{
+  a_package.pauseDispatchThread();
+  float const VALUE{ a_element.value<float>(a_element.outputs()[0]) };
+  a_package.resumeDispatchThread();
+  return VALUE;
+}
+
+} // namespace
+
+int main()
+{
+  using namespace std::chrono_literals;
+
+  tests::register_elements();
+
+  Package package{};
+  Element *const a{ package.add("values/const_float") };
+  Element *const b{ package.add("values/const_float") };
+  Element *const sum{ package.add("math/add") };
+  Element *const total{ package.add("math/add") };
+  tests::set_property(*a, "value", 2.0f);
+  tests::set_property(*b, "value", 3.0f);
+  package.connect(a->id(), 0, sum->id(), 0);
+  package.connect(b->id(), 0, sum->id(), 1);
+  package.connect(sum->id(), 0, total->id(), 0);
+  package.connect(a->id(), 0, total->id(), 1);
+
+  // A cpu past the last one wraps around, FIFO may be refused without privileges,
+  // the package dispatches either way.
+  Package::RealtimeOptions options{};
+  options.enabled = true;
+  options.cpu = 1000;
+  options.priority = 1;
+  options.lockMemory = false;
+
+  package.setDispatchPartitions(2);
+  package.startDispatchThread(options);
+  std::this_thread::sleep_for(100ms);
+
+  CHECK(read(package, *total) == 7.0f);
+  auto const STATUS = package.realtimeStatus();
+  CHECK(!STATUS.memoryLocked);
+  if (can_pin()) CHECK(STATUS.pinned);
+#if defined(_WIN64) || defined(_WIN32)
+  CHECK(!STATUS.fifo);
+#endif
+
+  package.quitDispatchThread();
+
+  // Without realtime nothing is reported.
+  options.enabled = false;
+  package.startDispatchThread(options);
+  std::this_thread::sleep_for(50ms);
+  auto const PLAIN = package.realtimeStatus();
+  CHECK(!PLAIN.pinned && !PLAIN.fifo && !PLAIN.memoryLocked);
+  CHECK(read(package, *total) == 7.0f);
+  package.quitDispatchThread();
+
+  return tests::failures() == 0 ? 0 : 1;
+}
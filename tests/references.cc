@@ -0,0 +1,119 @@
+// MIT License
+//
+// Copyright (c) 2017-2018 Artur Wyszyński, aljen at hitomi dot pl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <string>
+
+#include <spaghetti/package.h>
+
+#include "common.h"
+
+namespace {
+
+using namespace spaghetti;
+
+void build_library(Package &a_package, size_t const a_gates)
+{
+  Element *previous{};
+  for (size_t i = 0; i < a_gates; ++i) {
+    Element *const gate{ a_package.add("gates/and") };
+    a_package.connect(0, 0, gate->id(), 0);
+    if (previous)
+      a_package.connect(previous->id(), 0, gate->id(), 1);
+    else
+      a_package.connect(0, 1, gate->id(), 1);
+    previous = gate;
+  }
+  a_package.connect(previous->id(), 0, 0, 0);
+}
+
+Package &add_reference(Package &a_package, std::string const &a_path)
+{
+  auto &reference = static_cast<Package &>(*a_package.add("logic/package"));
+  reference.setPackagePath(a_path);
+  reference.setReference(true);
+  return reference;
+}
+
+} // namespace
+
+int main()
+{
+  tests::register_elements();
+
+  std::string const LIBRARY{ "references_library.package" };
+  std::string const HOST{ "references_host.package" };
+
+  Package library{};
+  build_library(library, 3);
+  library.save(LIBRARY);
+
+  // Referencing without the extension, the contents are only read when needed.
+  Package host{};
+  Package &first{ add_reference(host, "references_library") };
+  Package &second{ add_reference(host, "references_library") };
+  CHECK(first.isReference() && !first.isMaterialized());
+  CHECK(first.elements().size() == 1);
+
+  first.materialize();
+  CHECK(first.isMaterialized());
+  CHECK(first.elements().size() == library.elements().size());
+  CHECK(first.connections().size() == library.connections().size());
+
+  // Only the path is saved.
+  Element::Json const JSON = tests::dump(host);
+  for (auto const &ELEMENT : JSON["package"]["elements"]) {
+    CHECK(ELEMENT["package"]["reference"].get<bool>());
+    CHECK(ELEMENT["package"].count("elements") == 0);
+  }
+  host.save(HOST);
+
+  // A changed file is read again by the next package that needs it.
+  Package changed{};
+  build_library(changed, 5);
+  changed.save(LIBRARY);
+  {
+    Package reopened{};
+    reopened.open(HOST);
+    auto &reference = static_cast<Package &>(*reopened.get(first.id()));
+    CHECK(reference.isReference() && !reference.isMaterialized());
+    reference.materialize();
+    CHECK(reference.elements().size() == changed.elements().size());
+    CHECK(reference.connections().size() == changed.connections().size());
+  }
+
+  // A local copy keeps the contents and saves them.
+  second.setReference(false);
+  CHECK(!second.isReference());
+  CHECK(second.elements().size() == changed.elements().size());
+  Element::Json const COPY = tests::dump(host);
+  CHECK(COPY["package"]["elements"][1]["package"]["elements"].size() == changed.elements().size() - 1);
+
+  // A missing file leaves the reference empty.
+  Package &missing{ add_reference(host, "references_missing") };
+  missing.materialize();
+  CHECK(missing.isMaterialized());
+  CHECK(missing.elements().size() == 1);
+
+  tests::remove_files({ LIBRARY, LIBRARY + ".journal", HOST, HOST + ".journal" });
+
+  return tests::failures() == 0 ? 0 : 1;
+}
@@ -0,0 +1,119 @@
+// MIT License
+//
+// Copyright (c) 2017-2018 Artur Wyszyński, aljen at hitomi dot pl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+#include <filesystem.h>
+#include <spaghetti/package.h>
+
+#include "common.h"
+
+namespace {
+
+using namespace spaghetti;
+
+// Where a schedule's header keeps the cut size, see schedule_cache.cc.
+constexpr std::streamoff const CUT_SIZE_OFFSET{ 32 };
+constexpr uint64_t const SENTINEL{ 0x5eed5eed };
+
+fs::path directory()
+{
+  return fs::path{ Registry::get().userCachePath() } / "schedules";
+}
+
+std::vector<fs::path> schedules()
+{
+  std::vector<fs::path> paths{};
+  if (!fs::exists(directory())) return paths;
+  for (auto const &ENTRY : fs::directory_iterator{ directory() })
+    if (ENTRY.path().extension() == ".schedule") paths.push_back(ENTRY.path());
+  return paths;
+}
+
+void build_chain(Package &a_package, size_t const a_sums)
+{
+  Element *previous{ a_package.add("values/const_float") };
+  for (size_t i = 0; i < a_sums; ++i) {
+    Element *const constant{ a_package.add("values/const_float") };
+    Element *const sum{ a_package.add("math/add") };
+    a_package.connect(previous->id(), 0, sum->id(), 0);
+    a_package.connect(constant->id(), 0, sum->id(), 1);
+    previous = sum;
+  }
+}
+
+void dispatch(Package &a_package)
+{
+  a_package.setDispatchPartitions(4);
+  a_package.startDispatchThread();
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  a_package.quitDispatchThread();
+}
+
+} // namespace
+
+int main()
+{
+  tests::register_elements();
+
+  fs::remove_all(directory());
+
+  // Small packages partition faster than a schedule loads, they aren't cached.
+  Package small{};
+  build_chain(small, 100);
+  dispatch(small);
+  CHECK(schedules().empty());
+
+  Package package{};
+  build_chain(package, 2100);
+  dispatch(package);
+
+  auto const PATHS = schedules();
+  CHECK(PATHS.size() == 1);
+  if (PATHS.size() != 1) return 1;
+
+  // A cut size nothing would produce shows the stats come from the file.
+  {
+    std::fstream file{ PATHS.front().string(), std::ios::binary | std::ios::in | std::ios::out };
+    file.seekp(CUT_SIZE_OFFSET);
+    file.write(reinterpret_cast<char const *>(&SENTINEL), sizeof(SENTINEL));
+    CHECK(file.good());
+  }
+  CHECK(package.partitionStats().partitions == 4);
+  CHECK(package.partitionStats().cutSize == SENTINEL);
+
+  // Another partition count or an edit is another key.
+  package.setDispatchPartitions(2);
+  CHECK(package.partitionStats().cutSize != SENTINEL);
+  package.setDispatchPartitions(4);
+  CHECK(package.partitionStats().cutSize == SENTINEL);
+  package.add("values/const_float");
+  CHECK(package.partitionStats().cutSize != SENTINEL);
+
+  fs::remove_all(directory());
+
+  return tests::failures() == 0 ? 0 : 1;
+}
@@ -0,0 +1,70 @@
+// MIT License
+//
+// Copyright (c) 2017-2018 Artur Wyszyński, aljen at hitomi dot pl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <chrono>
+#include <thread>
+
+#include <spaghetti/package.h>
+
+#include "common.h"
+
+int main()
+{
+  using namespace spaghetti;
+  using namespace std::chrono_literals;
+
+  tests::register_elements();
+
+  Package package{};
+  Element *const a{ package.add("values/const_float") };
+  Element *const sum{ package.add("math/add") };
+  package.connect(a->id(), 0, sum->id(), 0);
+
+  // Periods are at least a microsecond and spinning never outlasts one.
+  Package::TickOptions options{};
+  options.period = 0ns;
+  options.spin = -1ms;
+  package.setTickOptions(options);
+  CHECK(package.tickOptions().period == 1us);
+  CHECK(package.tickOptions().spin == 0ns);
+
+  options.period = 5ms;
+  options.spin = 10ms;
+  package.setTickOptions(options);
+  CHECK(package.tickOptions().spin == 5ms);
+
+  // The measured period follows the requested one, loosely on a loaded machine.
+  options.highResolution = true;
+  options.spin = 200us;
+  package.setTickOptions(options);
+  CHECK(package.measuredTickPeriod() == 0ns);
+
+  package.startDispatchThread();
+  std::this_thread::sleep_for(500ms);
+  auto const MEASURED = package.measuredTickPeriod();
+  package.quitDispatchThread();
+
+  CHECK(MEASURED >= 2500us);
+  CHECK(MEASURED <= 15ms);
+
+  return tests::failures() == 0 ? 0 : 1;
+}
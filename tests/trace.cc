@@ -0,0 +1,90 @@
+// MIT License
+//
+// Copyright (c) 2017-2018 Artur Wyszyński, aljen at hitomi dot pl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <chrono>
+#include <thread>
+
+#include <spaghetti/package.h>
+#include <spaghetti/recorder.h>
+#include <spaghetti/trace_reader.h>
+
+#include "common.h"
+
+int main()
+{
+  using namespace spaghetti;
+  using namespace std::chrono_literals;
+
+  tests::register_elements();
+
+  std::string const FILENAME{ "trace_test.trace" };
+
+  Package package{};
+  Element *const constant{ package.add("values/const_int") };
+  constant->setName("Counter");
+  tests::set_property(*constant, "value", 1);
+
+  {
+    Recorder recorder{ package };
+    CHECK(recorder.addSignal(*constant, 0) == 0);
+    CHECK(recorder.start(FILENAME));
+
+    package.startDispatchThread();
+    std::this_thread::sleep_for(50ms);
+
+    package.pauseDispatchThread();
+    constant->setProperties({ { "value", 2 } });
+    package.resumeDispatchThread();
+
+    std::this_thread::sleep_for(50ms);
+    package.quitDispatchThread();
+
+    CHECK(recorder.stop());
+    CHECK(recorder.stats().changes == 2);
+  }
+
+  TraceReader reader{};
+  CHECK(reader.open(FILENAME));
+  CHECK(reader.isComplete());
+  CHECK(reader.chunks() >= 1);
+  CHECK(reader.signals().size() == 1);
+
+  if (reader.signals().size() == 1) {
+    CHECK(reader.signals()[0].type == ValueType::eInt);
+
+    auto const CHANGES = reader.changes(0, 0, reader.endTime());
+    CHECK(CHANGES.size() == 2);
+    if (CHANGES.size() == 2) {
+      CHECK(CHANGES[0].value.known && CHANGES[0].value.integer == 1);
+      CHECK(CHANGES[1].value.known && CHANGES[1].value.integer == 2);
+      CHECK(CHANGES[0].time < CHANGES[1].time);
+
+      CHECK(reader.valueAt(0, CHANGES[1].time - 1).integer == 1);
+      CHECK(reader.valueAt(0, reader.endTime()).integer == 2);
+    }
+  }
+
+  reader.close();
+  tests::remove_files({ FILENAME });
+
+  return tests::failures() == 0 ? 0 : 1;
+}
@@ -0,0 +1,133 @@
+// MIT License
+//
+// Copyright (c) 2017-2018 Artur Wyszyński, aljen at hitomi dot pl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <spaghetti/package.h>
+#include <spaghetti/recorder.h>
+
+#include "common.h"
+
+namespace {
+
+using namespace spaghetti;
+
+std::vector<std::string> read_lines(std::string const &a_filename)
+{
+  std::vector<std::string> lines{};
+  std::ifstream file{ a_filename };
+  for (std::string line{}; std::getline(file, line);) lines.push_back(line);
+  return lines;
+}
+
+// Identifier code of the $var whose reference starts with a_name.
+std::string code_of(std::vector<std::string> const &a_lines, std::string const &a_kind, std::string const &a_name)
+{
+  for (auto const &LINE : a_lines) {
+    if (LINE.compare(0, a_kind.size(), a_kind) != 0) continue;
+    std::istringstream tokens{ LINE.substr(a_kind.size()) };
+    std::string code{}, reference{};
+    tokens >> code >> reference;
+    if (reference.compare(0, a_name.size(), a_name) == 0) return code;
+  }
+  return {};
+}
+
+size_t find_line(std::vector<std::string> const &a_lines, std::string const &a_line, size_t const a_from = 0)
+{
+  for (size_t i = a_from; i < a_lines.size(); ++i)
+    if (a_lines[i] == a_line) return i;
+  return a_lines.size();
+}
+
+} // namespace
+
+int main()
+{
+  using namespace std::chrono_literals;
+
+  tests::register_elements();
+
+  std::string const FILENAME{ "vcd_test.vcd" };
+
+  Package package{};
+  package.setName("Top");
+  Element *const toggle{ package.add("values/const_bool") };
+  toggle->setName("Switch");
+  tests::set_property(*toggle, "value", true);
+  Element *const real{ package.add("values/const_float") };
+  real->setName("Level");
+  tests::set_property(*real, "value", 2.5f);
+  auto &nested = static_cast<Package &>(*package.add("logic/package"));
+  nested.setName("Nested");
+  Element *const count{ nested.add("values/const_int") };
+  count->setName("Count");
+  tests::set_property(*count, "value", 5);
+
+  {
+    Recorder recorder{ package };
+    recorder.addSignal(*toggle, 0);
+    recorder.addSignal(*real, 0);
+    recorder.addSignal(*count, 0);
+    CHECK(recorder.start(FILENAME));
+
+    package.startDispatchThread();
+    std::this_thread::sleep_for(50ms);
+
+    package.pauseDispatchThread();
+    toggle->setProperties({ { "value", false } });
+    package.resumeDispatchThread();
+
+    std::this_thread::sleep_for(50ms);
+    package.quitDispatchThread();
+    CHECK(recorder.stop());
+  }
+
+  auto const LINES = read_lines(FILENAME);
+  CHECK(find_line(LINES, "$timescale 1 us $end") < LINES.size());
+  CHECK(find_line(LINES, "$scope module Top $end") < LINES.size());
+  CHECK(find_line(LINES, "$scope module Nested_3 $end") < LINES.size());
+
+  std::string const SWITCH{ code_of(LINES, "$var wire 1 ", "Switch_1_") };
+  std::string const LEVEL{ code_of(LINES, "$var real 32 ", "Level_2_") };
+  std::string const COUNT{ code_of(LINES, "$var integer 32 ", "Count_1_") };
+  CHECK(!SWITCH.empty() && !LEVEL.empty() && !COUNT.empty());
+
+  // Unknown until the first tick, then the values and the toggle's change.
+  size_t const DEFINITIONS{ find_line(LINES, "$enddefinitions $end") };
+  CHECK(find_line(LINES, "x" + SWITCH, DEFINITIONS) < LINES.size());
+  size_t const ON{ find_line(LINES, "1" + SWITCH, DEFINITIONS) };
+  size_t const OFF{ find_line(LINES, "0" + SWITCH, DEFINITIONS) };
+  CHECK(ON < OFF && OFF < LINES.size());
+  CHECK(LINES[OFF - 1].front() == '#');
+  CHECK(find_line(LINES, "r2.5 " + LEVEL, DEFINITIONS) < LINES.size());
+  CHECK(find_line(LINES, "b101 " + COUNT, DEFINITIONS) < LINES.size());
+
+  tests::remove_files({ FILENAME });
+
+  return tests::failures() == 0 ? 0 : 1;
+}
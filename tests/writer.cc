@@ -0,0 +1,70 @@
+// MIT License
+//
+// Copyright (c) 2017-2018 Artur Wyszyński, aljen at hitomi dot pl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#include <spaghetti/package.h>
+
+#include "common.h"
+
+namespace {
+
+using namespace spaghetti;
+
+std::string read_file(std::string const &a_filename)
+{
+  std::ifstream file{ a_filename, std::ios::binary };
+  return std::string{ std::istreambuf_iterator<char>{ file }, std::istreambuf_iterator<char>{} };
+}
+
+} // namespace
+
+int main()
+{
+  tests::register_elements();
+
+  Package package{};
+  tests::build_sample(package);
+  package.get(2)->setName("Escaped \"\\\x01 \xc3\xbc");
+
+  // What the writer streams out is the document serialize() builds, once
+  // saving has closed the hole the sample leaves.
+  std::string const FILENAME{ "writer_test.package" };
+  package.save(FILENAME);
+  Element::Json const JSON = tests::dump(package);
+  std::string const INDENTED{ read_file(FILENAME) };
+  CHECK(Element::Json::parse(INDENTED) == JSON);
+  CHECK(std::count(std::begin(INDENTED), std::end(INDENTED), '\n') > 1);
+
+  package.save(FILENAME, true);
+  std::string const COMPACT{ read_file(FILENAME) };
+  CHECK(Element::Json::parse(COMPACT) == JSON);
+  CHECK(COMPACT.size() < INDENTED.size());
+  CHECK(std::count(std::begin(COMPACT), std::end(COMPACT), '\n') <= 1);
+
+  tests::remove_files({ FILENAME, FILENAME + ".journal" });
+
+  return tests::failures() == 0 ? 0 : 1;
+}
@@ -0,0 +1,43 @@
+// MIT License
+//
+// Copyright (c) 2017-2018 Artur Wyszyński, aljen at hitomi dot pl
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <iostream>
+
+#include <spaghetti/package_format.h>
+
+int main(int argc, char **argv)
+{
+  if (argc != 3) {
+    std::cerr << "usage: " << argv[0] << " <from> <to>\n"
+              << "Converts between " << spaghetti::package_format::JSON_EXTENSION << ", "
+              << spaghetti::package_format::COMPRESSED_EXTENSION << " and "
+              << spaghetti::package_format::BINARY_EXTENSION << " packages, formats are picked by extension.\n";
+    return 1;
+  }
+
+  if (!spaghetti::package_format::convert(argv[1], argv[2])) {
+    std::cerr << "Can't convert " << argv[1] << " to " << argv[2] << '\n';
+    return 1;
+  }
+
+  return 0;
+}